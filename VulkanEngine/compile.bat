@@ -2,4 +2,8 @@ C:\VulkanSDK\1.3.283.0\Bin\glslangValidator.exe -V simple_shader.vert -o simple_
 C:\VulkanSDK\1.3.283.0\Bin\glslangValidator.exe -V simple_shader.frag -o simple_shader.frag.spv
 C:\VulkanSDK\1.3.283.0\Bin\glslangValidator.exe -V point_light.vert -o point_light.vert.spv
 C:\VulkanSDK\1.3.283.0\Bin\glslangValidator.exe -V point_light.frag -o point_light.frag.spv
+C:\VulkanSDK\1.3.283.0\Bin\glslangValidator.exe -V gpu_driven.vert -o gpu_driven.vert.spv
+C:\VulkanSDK\1.3.283.0\Bin\glslangValidator.exe -V gpu_cull.comp -o gpu_cull.comp.spv
+C:\VulkanSDK\1.3.283.0\Bin\glslangValidator.exe -V gpu_build_draws.comp -o gpu_build_draws.comp.spv
+C:\VulkanSDK\1.3.283.0\Bin\glslangValidator.exe -V depth_prepass.vert -o depth_prepass.vert.spv
 pause
\ No newline at end of file
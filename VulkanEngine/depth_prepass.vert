@@ -0,0 +1,32 @@
+#version 450
+#extension GL_KHR_vulkan_glsl : enable
+
+// Depth only pass ahead of simple_shader, which then shades with an EQUAL depth test. Both compute gl_Position with
+// the same expression and declare it invariant, so the depth values match exactly.
+
+layout(location = 0) in vec3 position;
+
+invariant gl_Position;
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+	mat4 projection;
+	mat4 view;
+	mat4 invView;
+	vec4 ambientLightColor; // w is intensity
+	uvec4 clusterCounts; // w is the number of lights
+	vec4 clusterDepth; // x is the first slice's near depth, y the slices per unit of log depth
+} ubo;
+
+layout(std430, set = 1, binding = 0) readonly buffer InstanceBuffer {
+	uint objectSlots[];
+} instanceBuffer;
+
+layout(std430, set = 1, binding = 1) readonly buffer TransformBuffer {
+	mat3x4 transforms[];
+} transformBuffer;
+
+void main() {
+	mat3x4 transform = transformBuffer.transforms[instanceBuffer.objectSlots[gl_InstanceIndex]];
+	vec4 positionWorld = vec4(vec4(position, 1.0) * transform, 1.0);
+	gl_Position = ubo.projection * (ubo.view * positionWorld);
+}
@@ -13,9 +13,10 @@
 
 #include "keyboard_movement_controller.hpp"
 #include "lve_camera.hpp"
-#include "lve_buffer.hpp"
-#include "simple_render_system.hpp"
-#include "point_light_system.hpp"
+#include "lve_scene_file.hpp"
+#include "lve_scene_renderer.hpp"
+#include "lve_scene_target.hpp"
+#include "lve_utils.hpp"
 
 // libs
 #define GLM_FORCE_RADIANS
@@ -24,21 +25,27 @@
 #include <glm/gtc/constants.hpp>
 
 // std
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <cassert>
+#include <iostream>
 #include <stdexcept>
 
 namespace lve {
 
     /**
      * @brief Constructs the FirstApp object and initializes the descriptor pool.
+     *
+     * @param framesInFlight Number of frames the CPU may record ahead of the GPU. Every per frame resource of the
+     *        application and its render systems is created this many times.
      */
-	FirstApp::FirstApp() { 
+	FirstApp::FirstApp(uint32_t framesInFlight) : lveRenderer{ lveWindow, lveDevice, framesInFlight } { 
         globalPool = 
             LveDescriptorPool::Builder(lveDevice)
-            .setMaxSets(LveSwapChain::MAX_FRAMES_IN_FLIGHT)
-            .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, LveSwapChain::MAX_FRAMES_IN_FLIGHT)
+            .setMaxSets(framesInFlight)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, framesInFlight)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 * framesInFlight)
             .build();
         loadGameObjects(); 
     }
@@ -55,38 +62,67 @@ namespace lve {
      * It handles updating game objects, managing camera movement, and rendering each frame.
      */
 	void FirstApp::run() {
-        std::vector<std::unique_ptr<LveBuffer>> uboBuffers(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
-        for (int i = 0; i < uboBuffers.size(); i++) {
-            uboBuffers[i] = std::make_unique<LveBuffer>(
-                lveDevice,
-                sizeof(GlobalUbo),
-                1,
-                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
-            uboBuffers[i]->map();
-        }
+        const uint32_t framesInFlight = lveRenderer.getFramesInFlight();
+        // the render systems compile their pipelines on the job system and skip drawing until they are ready
+        auto compileStart = std::chrono::high_resolution_clock::now();
+        bool pipelinesReported = false;
 
-        auto globalSetLayout = 
-            LveDescriptorSetLayout::Builder(lveDevice)
-            .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
-            .build();
-
-        std::vector<VkDescriptorSet> globalDescriptorSets(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
-        for (int i = 0; i < globalDescriptorSets.size(); i++) {
-            auto bufferInfo = uboBuffers[i]->descriptorInfo();
-            LveDescriptorWriter(*globalSetLayout, *globalPool)
-                .writeBuffer(0, &bufferInfo)
-                .build(globalDescriptorSets[i]);
-        }
-        
-		SimpleRenderSystem simpleRenderSystem{ 
-            lveDevice, 
-            lveRenderer.getSwapChainRenderPass(), 
-            globalSetLayout->getDescriptorSetLayout()};
-        PointLightSystem pointLightSystem{
+        // the scene's buffers, descriptor sets and render systems, shared with the headless application
+        LveSceneRenderer sceneRenderer{
             lveDevice,
+            jobSystem,
+            *globalPool,
             lveRenderer.getSwapChainRenderPass(),
-            globalSetLayout->getDescriptorSetLayout() };
+            framesInFlight,
+            gameObjects,
+            sceneBvh,
+            true };
+        if (gpuDrivenRendering && !sceneRenderer.supportsGpuDrivenRendering()) {
+            std::cout << "GPU driven rendering is not supported by this device, using CPU culling" << std::endl;
+        }
+        sceneRenderer.setGpuDrivenRendering(gpuDrivenRendering);
+        SimpleRenderSystem& simpleRenderSystem = sceneRenderer.getSimpleRenderSystem();
+        LvePipelineCompiler& pipelineCompiler = sceneRenderer.getPipelineCompiler();
+        LveGpuProfiler& gpuProfiler = sceneRenderer.getGpuProfiler();
+        if (!gpuProfiler.isSupported()) {
+            std::cout << "Timestamp queries are not supported by this device, GPU times are not reported" << std::endl;
+        }
+
+        // the scene is rendered offscreen at a resolution scaled to the frame time budget, toggled with R
+        std::unique_ptr<LveSceneTarget> sceneTarget;
+        if (lveRenderer.supportsSwapChainBlit() &&
+            LveSceneTarget::isSupported(lveDevice, lveRenderer.getSwapChainImageFormat())) {
+            sceneTarget = std::make_unique<LveSceneTarget>(
+                lveDevice,
+                lveRenderer.getSwapChainImageFormat(),
+                lveRenderer.getSwapChainDepthFormat(),
+                lveRenderer.getSwapChainExtent(),
+                framesInFlight);
+        } else {
+            std::cout << "Dynamic resolution is not supported by this device, rendering at native resolution" << std::endl;
+        }
+        bool dynamicResolution = sceneTarget != nullptr;
+        // frames held back by FIFO presentation or the frame limiter may take the whole interval on the GPU, only
+        // a budget tighter than both would lower the resolution of a GPU that is waiting anyway
+        const float defaultFrameBudget = LveSceneTarget::Settings{}.targetFrameTime;
+        const GLFWvidmode* videoMode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+        const float refreshInterval = videoMode != nullptr && videoMode->refreshRate > 0
+            ? 1.f / static_cast<float>(videoMode->refreshRate) : 0.f;
+        auto updateResolutionBudget = [&]() {
+            float budget = defaultFrameBudget;
+            if (lveRenderer.getPresentMode() == VK_PRESENT_MODE_FIFO_KHR) {
+                budget = std::max(budget, refreshInterval);
+            }
+            if (framePacer.getTargetFrameRate() > 0.f) {
+                budget = std::max(budget, 1.f / framePacer.getTargetFrameRate());
+            }
+            LveSceneTarget::Settings settings = sceneTarget->getSettings();
+            if (settings.targetFrameTime != budget) {
+                settings.targetFrameTime = budget;
+                sceneTarget->setSettings(settings);
+            }
+        };
+
         LveCamera camera{};
 
         auto viewerObject = LveGameObject::createGameObject();
@@ -94,104 +130,316 @@ namespace lve {
         KeyboardMovementController cameraController{};
 
         auto currentTime = std::chrono::high_resolution_clock::now();
+        float frameTime = 0.f;
+        // when the input of the frame being recorded was sampled
+        auto inputTime = currentTime;
+        float statsTimer = 0.f;
+        bool wasPickPressed = false;
+        bool wasGpuTogglePressed = false;
+        bool wasPrepassTogglePressed = false;
+        bool wasVariantPressed = false;
+        bool wasResolutionTogglePressed = false;
+        bool wasPresentModePressed = false;
+        bool wasFrameLimitPressed = false;
+        bool wasInputModePressed = false;
+        // shading variants cycled with V, from full Blinn-Phong to the cheapest diffuse only light loop
+        const std::array<ShadingVariant, 3> shadingVariants{ {
+            { 512.f, true, 0 },
+            { 512.f, true, 32 },
+            { 512.f, false, 32 } } };
+        size_t shadingVariantIndex = 0;
+        // present modes cycled with M and frame rate limits cycled with L, 0 meaning unlimited
+        const std::array<VkPresentModeKHR, 3> presentModes{
+            VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR };
+        const std::array<float, 4> frameRateLimits{ 0.f, 30.f, 60.f, 144.f };
+        // frame times accumulated since the last report, restarted whenever a setting that affects them changes
+        float statsFrameTime = 0.f;
+        float statsFenceWaitTime = 0.f;
+        float statsInputLatency = 0.f;
+        uint32_t statsFrameCount = 0;
+        auto resetStats = [&]() {
+            statsTimer = 0.f;
+            statsFrameTime = 0.f;
+            statsFenceWaitTime = 0.f;
+            statsInputLatency = 0.f;
+            statsFrameCount = 0;
+        };
 
-		while (!lveWindow.shouldClose()) {
-			glfwPollEvents();
+        // polls events, moves the camera and handles the toggles, either at the start of the frame or, with
+        // just in time input, after beginFrame has waited for the frame's fence and acquired its image
+        auto sampleInput = [&]() {
+            glfwPollEvents();
 
-            auto newTime = std::chrono::high_resolution_clock::now();
-            float frameTime = 
-                std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
-            currentTime = newTime;
+            inputTime = std::chrono::high_resolution_clock::now();
+            frameTime = std::chrono::duration<float, std::chrono::seconds::period>(inputTime - currentTime).count();
+            currentTime = inputTime;
 
             cameraController.moveInPlaneXZ(lveWindow.getGLFWwindow(), frameTime, viewerObject);
             camera.setViewYXZ(viewerObject.transform.translation, viewerObject.transform.rotation);
 
+            bool pickPressed = glfwGetMouseButton(lveWindow.getGLFWwindow(), GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+            if (pickPressed && !wasPickPressed) {
+                pickObject(camera);
+            }
+            wasPickPressed = pickPressed;
+
+            bool gpuTogglePressed = glfwGetKey(lveWindow.getGLFWwindow(), GLFW_KEY_G) == GLFW_PRESS;
+            if (gpuTogglePressed && !wasGpuTogglePressed && sceneRenderer.supportsGpuDrivenRendering()) {
+                sceneRenderer.setGpuDrivenRendering(!sceneRenderer.isGpuDrivenRendering());
+                std::cout << (sceneRenderer.isGpuDrivenRendering() ? "GPU driven rendering" : "CPU culled rendering")
+                    << std::endl;
+            }
+            wasGpuTogglePressed = gpuTogglePressed;
+
+            bool prepassTogglePressed = glfwGetKey(lveWindow.getGLFWwindow(), GLFW_KEY_P) == GLFW_PRESS;
+            if (prepassTogglePressed && !wasPrepassTogglePressed) {
+                simpleRenderSystem.setDepthPrepassEnabled(!simpleRenderSystem.isDepthPrepassEnabled());
+                std::cout << "Depth pre-pass " << (simpleRenderSystem.isDepthPrepassEnabled() ? "on" : "off") << std::endl;
+                resetStats();
+            }
+            wasPrepassTogglePressed = prepassTogglePressed;
+
+            bool variantPressed = glfwGetKey(lveWindow.getGLFWwindow(), GLFW_KEY_V) == GLFW_PRESS;
+            if (variantPressed && !wasVariantPressed) {
+                shadingVariantIndex = (shadingVariantIndex + 1) % shadingVariants.size();
+                simpleRenderSystem.setShadingVariant(shadingVariants[shadingVariantIndex]);
+                resetStats();
+            }
+            wasVariantPressed = variantPressed;
+
+            bool resolutionTogglePressed = glfwGetKey(lveWindow.getGLFWwindow(), GLFW_KEY_R) == GLFW_PRESS;
+            if (resolutionTogglePressed && !wasResolutionTogglePressed && sceneTarget != nullptr) {
+                dynamicResolution = !dynamicResolution;
+                std::cout << "Dynamic resolution " << (dynamicResolution ? "on" : "off") << std::endl;
+                resetStats();
+            }
+            wasResolutionTogglePressed = resolutionTogglePressed;
+
+            bool presentModePressed = glfwGetKey(lveWindow.getGLFWwindow(), GLFW_KEY_M) == GLFW_PRESS;
+            if (presentModePressed && !wasPresentModePressed) {
+                // a mode the surface did not support falls back to FIFO, continue from whichever is active
+                auto current = std::find(presentModes.begin(), presentModes.end(), lveRenderer.getPresentMode());
+                size_t next = (std::distance(presentModes.begin(), current) + 1) % presentModes.size();
+                lveRenderer.setPresentMode(presentModes[next]);
+                resetStats();
+            }
+            wasPresentModePressed = presentModePressed;
+
+            bool frameLimitPressed = glfwGetKey(lveWindow.getGLFWwindow(), GLFW_KEY_L) == GLFW_PRESS;
+            if (frameLimitPressed && !wasFrameLimitPressed) {
+                auto current = std::find(frameRateLimits.begin(), frameRateLimits.end(), framePacer.getTargetFrameRate());
+                size_t next = (std::distance(frameRateLimits.begin(), current) + 1) % frameRateLimits.size();
+                framePacer.setTargetFrameRate(frameRateLimits[next]);
+                std::cout << "Frame rate limit: ";
+                if (frameRateLimits[next] > 0.f) {
+                    std::cout << frameRateLimits[next] << " fps" << std::endl;
+                } else {
+                    std::cout << "off" << std::endl;
+                }
+                resetStats();
+            }
+            wasFrameLimitPressed = frameLimitPressed;
+
+            bool inputModePressed = glfwGetKey(lveWindow.getGLFWwindow(), GLFW_KEY_J) == GLFW_PRESS;
+            if (inputModePressed && !wasInputModePressed) {
+                justInTimeInput = !justInTimeInput;
+                std::cout << "Just in time input " << (justInTimeInput ? "on" : "off") << std::endl;
+                resetStats();
+            }
+            wasInputModePressed = inputModePressed;
+        };
+
+        // records and submits the frame begun on commandBuffer, also used to draw while a resize blocks event polling
+        auto recordFrame = [&](VkCommandBuffer commandBuffer, bool fromRefreshCallback) {
+            // beginFrame has already waited for the fence and acquired the image, so this excludes both
+            const auto recordStart = std::chrono::high_resolution_clock::now();
             float aspect = lveRenderer.getAspectRatio();
             // increase last value for more or less bounding box size
             camera.setPerspectiveProjection(glm::radians(50.f), aspect, 0.1f, 1000.f);
 
-			if (auto commandBuffer = lveRenderer.beginFrame()) {
-                int frameIndex = lveRenderer.getFrameIndex();
-                FrameInfo frameInfo{
-                    frameIndex,
-                    frameTime,
+            int frameIndex = lveRenderer.getFrameIndex();
+            FrameInfo frameInfo = sceneRenderer.beginFrame(commandBuffer, frameIndex, frameTime, camera);
+
+            // update
+            sceneRenderer.update(frameInfo);
+
+            // render
+            if (dynamicResolution) {
+                VkExtent2D swapChainExtent = lveRenderer.getSwapChainExtent();
+                VkExtent2D targetExtent = sceneTarget->getWindowExtent();
+                if (swapChainExtent.width != targetExtent.width || swapChainExtent.height != targetExtent.height) {
+                    sceneTarget->resize(swapChainExtent);
+                }
+                sceneRenderer.record(
+                    frameInfo,
+                    sceneTarget->getRenderPass(),
+                    sceneTarget->getFramebuffer(frameIndex),
+                    sceneTarget->getRenderExtent());
+            } else {
+                sceneRenderer.record(
+                    frameInfo,
+                    lveRenderer.getSwapChainRenderPass(),
+                    lveRenderer.getCurrentFrameBuffer(),
+                    lveRenderer.getSwapChainExtent());
+            }
+
+            if (dynamicResolution) {
+                sceneTarget->beginRenderPass(commandBuffer, frameIndex, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+                sceneRenderer.executeSecondaries(commandBuffer);
+                sceneTarget->endRenderPass(commandBuffer);
+                LveGpuProfiler::Zone blitZone{ &gpuProfiler, commandBuffer, "upscale blit" };
+                sceneTarget->blitToSwapChain(
                     commandBuffer,
-                    camera,
-                    globalDescriptorSets[frameIndex],
-                    gameObjects
-                };
-
-                // update
-                GlobalUbo ubo{};
-                ubo.projection = camera.getProjection();
-                ubo.view = camera.getView();
-                ubo.inverseView = camera.getInverseView();
-                pointLightSystem.update(frameInfo, ubo);
-                uboBuffers[frameIndex]->writeToBuffer(&ubo);
-                uboBuffers[frameIndex]->flush();
-
-                // render
-				lveRenderer.beginSwapChainRenderPass(commandBuffer);
-				simpleRenderSystem.renderGameObjects(frameInfo);
-                pointLightSystem.render(frameInfo);
-				lveRenderer.endSwapChainRenderPass(commandBuffer);
-				lveRenderer.endFrame();
-			}
+                    frameIndex,
+                    lveRenderer.getCurrentSwapChainImage(),
+                    lveRenderer.getSwapChainExtent());
+            } else {
+                lveRenderer.beginSwapChainRenderPass(commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+                sceneRenderer.executeSecondaries(commandBuffer);
+                lveRenderer.endSwapChainRenderPass(commandBuffer);
+            }
+            sceneRenderer.endFrame(commandBuffer);
+            const float recordTime = std::chrono::duration<float, std::chrono::seconds::period>(
+                std::chrono::high_resolution_clock::now() - recordStart).count();
+            lveRenderer.endFrame();
+            if (dynamicResolution) {
+                // the resolution follows the GPU's work rather than the time between frames, which includes waits
+                // on presentation and the frame limiter that a lower resolution cannot shorten. Without timestamps
+                // the CPU's recording time is the nearest measure of the frame's cost.
+                updateResolutionBudget();
+                const float gpuFrameMs = gpuProfiler.getLatestMs("frame");
+                sceneTarget->updateScale(gpuFrameMs > 0.f ? gpuFrameMs / 1000.f : recordTime);
+            }
+
+            // frames drawn from the refresh callback reuse the input of the last polled frame, so their frame time
+            // and latency are stale and would skew the averages
+            if (fromRefreshCallback) return;
+
+            // report the counts of the latest frame once per second
+            statsTimer += frameTime;
+            statsFrameTime += frameTime;
+            statsFenceWaitTime += lveRenderer.getFenceWaitTime();
+            statsInputLatency += std::chrono::duration<float>(lveRenderer.getLastSubmitTime() - inputTime).count();
+            statsFrameCount++;
+            if (statsTimer >= 1.f) {
+                // pipelines still compiling log from worker threads
+                std::lock_guard<std::mutex> logLock{ getLogMutex() };
+                if (sceneRenderer.isGpuDrivenRendering()) {
+                    GpuDrivenRenderSystem* gpuDrivenRenderSystem = sceneRenderer.getGpuDrivenRenderSystem();
+                    std::cout << "GPU driven: " << gpuDrivenRenderSystem->getObjectCount() << " objects, "
+                        << gpuDrivenRenderSystem->getMeshCount() << " indirect draws" << std::endl;
+                } else {
+                    const auto& culling = simpleRenderSystem.getCullingStats();
+                    std::cout << "Culling: " << culling.visibleCount << " visible, "
+                        << culling.culledCount << " culled, " << culling.occludedCount << " occluded, "
+                        << culling.drawCallCount << " draws, " << culling.bindCount << " binds, "
+                        << culling.recordingTaskCount << " recording threads" << std::endl;
+                    const ShadingVariant& variant = simpleRenderSystem.getShadingVariant();
+                    std::cout << "Depth pre-pass " << (simpleRenderSystem.isDepthPrepassEnabled() ? "on" : "off")
+                        << ", specular " << (variant.specularEnabled ? "on" : "off") << ", max cluster lights "
+                        << variant.maxClusterLights << std::endl;
+                }
+                // shared by both modes, so toggling G compares like with like
+                std::cout << "Frame time: " << 1000.f * statsFrameTime / statsFrameCount << " ms" << std::endl;
+                std::cout << "Frames in flight: " << framesInFlight << ", CPU waited "
+                    << 1000.f * statsFenceWaitTime / statsFrameCount << " ms per frame on frame fences" << std::endl;
+                const LveLightClusters& lightClusters = sceneRenderer.getLightClusters();
+                std::cout << "Lights: " << lightClusters.getLightCount() << " in view, "
+                    << lightClusters.getLightIndexCount() << " cluster entries, " << lightClusters.getDroppedCount()
+                    << " dropped" << std::endl;
+                std::cout << "Input to submit latency: " << 1000.f * statsInputLatency / statsFrameCount << " ms, "
+                    << LveSwapChain::getPresentModeName(lveRenderer.getPresentMode()) << ", just in time input "
+                    << (justInTimeInput ? "on" : "off") << std::endl;
+                gpuProfiler.logTimings(std::cout);
+                if (dynamicResolution) {
+                    VkExtent2D renderExtent = sceneTarget->getRenderExtent();
+                    std::cout << "Resolution scale: " << sceneTarget->getScale() << ", rendering "
+                        << renderExtent.width << "x" << renderExtent.height << std::endl;
+                }
+                resetStats();
+            }
+        };
+
+        lveWindow.setRefreshCallback([&]() {
+            if (lveRenderer.isFrameInProgress()) return;
+            // the window may be minimizing, waiting for events from inside the event loop would never return
+            if (auto commandBuffer = lveRenderer.beginFrame(false)) {
+                recordFrame(commandBuffer, true);
+            }
+        });
+
+		while (!lveWindow.shouldClose()) {
+            if (!pipelinesReported && pipelineCompiler.getPendingCount() == 0) {
+                std::cout << "Pipelines compiled in " << std::chrono::duration<float, std::milli>(
+                    std::chrono::high_resolution_clock::now() - compileStart).count() << " ms" << std::endl;
+                pipelinesReported = true;
+            }
+
+            framePacer.waitForNextFrame();
+            // the mode may change while sampling, so it is read once per frame
+            const bool sampleInputLate = justInTimeInput;
+            if (!sampleInputLate) {
+                sampleInput();
+            }
+
+			auto commandBuffer = lveRenderer.beginFrame();
+            if (sampleInputLate) {
+                sampleInput();
+            }
+            if (commandBuffer != nullptr) {
+                recordFrame(commandBuffer, false);
+            }
 		}
 
+		lveWindow.setRefreshCallback(nullptr);
 		vkDeviceWaitIdle(lveDevice.device());
 	}
 
     /**
      * @brief Loads the game objects to be rendered.
      *
-     * This method creates game objects from model files and sets up their initial transforms.
-     * It also creates point light game objects and positions them in the scene.
+     * Game objects are created from the binary scene file. If the file is missing or older than its text
+     * description it is converted first.
      */
 	void FirstApp::loadGameObjects() {
-        std::shared_ptr<LveModel> lveModel = 
-            LveModel::createModelFromFile(lveDevice, "models/sphere.obj");
-        auto flatVase = LveGameObject::createGameObject();
-        flatVase.model = lveModel;
-        flatVase.transform.translation = { -.5f, -.1f, 0.f };
-        flatVase.transform.scale = { .3f, .3f, .3f };
-        gameObjects.emplace(flatVase.getId(), std::move(flatVase));
-
-        lveModel =
-            LveModel::createModelFromFile(lveDevice, "models/smooth_vase.obj");
-        auto smoothVase = LveGameObject::createGameObject();
-        smoothVase.model = lveModel;
-        smoothVase.transform.translation = { .5f, .5f, 0.f };
-        smoothVase.transform.scale = { 3.f, 1.5f, 3.f };
-        gameObjects.emplace(smoothVase.getId(), std::move(smoothVase));
-
-        lveModel =
-            LveModel::createModelFromFile(lveDevice, "models/quad.obj");
-        auto floor = LveGameObject::createGameObject();
-        floor.model = lveModel;
-        floor.transform.translation = { 0.f, .5f, 0.f };
-        floor.transform.scale = { 3.f, 1.f, 3.f };
-        gameObjects.emplace(floor.getId(), std::move(floor));
-
-        std::vector<glm::vec3> lightColors{
-            {1.f, .1f, .1f},
-            {.1f, .1f, 1.f},
-            {.1f, 1.f, .1f},
-            {1.f, 1.f, .1f},
-            {.1f, 1.f, 1.f},
-            {1.f, 1.f, 1.f}  //
-        };
+        LveSceneFile::convertIfOutdated(SCENE_TEXT_PATH, SCENE_PATH);
+
+        auto loadStart = std::chrono::high_resolution_clock::now();
+        LveSceneFile scene{ SCENE_PATH };
+        const SceneLoadTimes times = scene.createGameObjects(lveDevice, gameObjects, sceneBvh);
+
+        float loadTime = std::chrono::duration<float, std::chrono::milliseconds::period>(
+            std::chrono::high_resolution_clock::now() - loadStart).count();
+        std::cout << "Loaded " << scene.getEntityCount() << " entities and " << scene.getModelCount()
+            << " models in " << loadTime << " ms (models " << times.modelMs << " ms, entities " << times.entityMs
+            << " ms, BVH build " << times.bvhMs << " ms)" << std::endl;
+    }
+
+    /**
+     * @brief Picks the object under the mouse cursor.
+     *
+     * Casts a ray from the camera through the cursor position into the scene BVH and reports the
+     * closest object that was hit.
+     *
+     * @param camera The camera the current frame is rendered with.
+     */
+    void FirstApp::pickObject(const LveCamera& camera) {
+        double cursorX, cursorY;
+        int width, height;
+        glfwGetCursorPos(lveWindow.getGLFWwindow(), &cursorX, &cursorY);
+        glfwGetWindowSize(lveWindow.getGLFWwindow(), &width, &height);
+        if (width == 0 || height == 0) return;
+
+        Ray ray = camera.getPickRay(
+            2.f * static_cast<float>(cursorX) / width - 1.f,
+            2.f * static_cast<float>(cursorY) / height - 1.f);
 
-        for (int i = 0; i < lightColors.size(); i++) {
-            auto pointLight = LveGameObject::makePointLight(0.2f);
-            pointLight.color = lightColors[i];
-            auto rotateLight = glm::rotate(
-                glm::mat4(1.f),
-                (i * glm::two_pi<float>()) / lightColors.size(),
-                { 0.f, -1.f, 0.f }
-            );
-            pointLight.transform.translation = glm::vec3(rotateLight * glm::vec4(-1.f, -1.f, -1.f, 1.f));
-            gameObjects.emplace(pointLight.getId(), std::move(pointLight));
+        LveSceneBvh::RayHit hit;
+        sceneBvh.refitMoved(gameObjects);
+        if (sceneBvh.raycast(ray, 1000.f, hit)) {
+            std::cout << "Picked object " << hit.objectId << " at distance " << hit.distance << std::endl;
+        } else {
+            std::cout << "Picked nothing" << std::endl;
         }
     }
 }
\ No newline at end of file
@@ -2,8 +2,11 @@
 
 #include "lve_descriptors.hpp"
 #include "lve_device.hpp"
+#include "lve_frame_pacer.hpp"
 #include "lve_game_object.hpp"
+#include "lve_job_system.hpp"
 #include "lve_renderer.hpp"
+#include "lve_scene_bvh.hpp"
 #include "lve_window.hpp"
 
 // std
@@ -16,8 +19,11 @@ namespace lve {
 	public:
 		static constexpr int WIDTH = 800;
 		static constexpr int HEIGHT = 600;
+		static constexpr const char* SCENE_PATH = "scenes/default.scene";
+		static constexpr const char* SCENE_TEXT_PATH = "scenes/default.scene.txt";
 
-		FirstApp();
+		// framesInFlight from 1 to LveSwapChain::MAX_FRAMES_IN_FLIGHT
+		explicit FirstApp(uint32_t framesInFlight = LveSwapChain::DEFAULT_FRAMES_IN_FLIGHT);
 		~FirstApp();
 
 		FirstApp(const FirstApp&) = delete;
@@ -25,15 +31,30 @@ namespace lve {
 
 		void run();
 
+		// culls and builds draws with compute shaders when supported, toggled with G while running
+		void setGpuDrivenRendering(bool enabled) { gpuDrivenRendering = enabled; }
+		// preferred present mode, falls back to FIFO when unsupported, cycled with M while running
+		void setPresentMode(VkPresentModeKHR presentMode) { lveRenderer.setPresentMode(presentMode); }
+		// 0 renders as fast as presentation allows, cycled with L while running
+		void setFrameRateLimit(float framesPerSecond) { framePacer.setTargetFrameRate(framesPerSecond); }
+		// samples input after the frame's fence wait and image acquisition instead of before, toggled with J
+		void setJustInTimeInput(bool enabled) { justInTimeInput = enabled; }
+
 	private:
 		void loadGameObjects();
+		void pickObject(const LveCamera& camera);
 
 		LveWindow lveWindow{ WIDTH, HEIGHT, "Hello Vulkan!" };
 		LveDevice lveDevice{lveWindow};
 		LveRenderer lveRenderer{ lveWindow, lveDevice };
+		LveJobSystem jobSystem{};
 
 		// order of declaration matters
 		std::unique_ptr<LveDescriptorPool> globalPool{};
 		LveGameObject::Map gameObjects;
+		LveSceneBvh sceneBvh{};
+		bool gpuDrivenRendering = false;
+		LveFramePacer framePacer{};
+		bool justInTimeInput = false;
 	};
 }
\ No newline at end of file
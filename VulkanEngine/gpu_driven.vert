@@ -0,0 +1,53 @@
+#version 450
+#extension GL_KHR_vulkan_glsl : enable
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 color;
+layout(location = 2) in vec3 normal;
+layout(location = 3) in vec2 uv;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec3 fragPosWorld;
+layout(location = 2) out vec3 fragNormalWorld;
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+	mat4 projection;
+	mat4 view;
+	mat4 invView;
+	vec4 ambientLightColor; // w is intensity
+	uvec4 clusterCounts; // w is the number of lights
+	vec4 clusterDepth; // x is the first slice's near depth, y the slices per unit of log depth
+} ubo;
+
+struct ObjectData {
+	mat3x4 transform; // rows of the affine model matrix, see AffineTransform
+	vec4 boundingSphere;
+	uint meshIndex;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer ObjectBuffer {
+	ObjectData objects[];
+};
+
+// filled by gpu_cull.comp, gl_InstanceIndex includes the mesh's firstInstance
+layout(std430, set = 1, binding = 2) readonly buffer VisibleInstanceBuffer {
+	uint visibleInstances[];
+};
+
+// The cofactor matrix equals inverse(transpose(m)) * determinant(m), the scale is removed by normalizing and the
+// sign of the determinant keeps normals of mirrored objects facing out.
+vec3 transformNormal(mat3x4 transform, vec3 normal) {
+	mat3 m = transpose(mat3(transform));
+	mat3 cofactor = mat3(cross(m[1], m[2]), cross(m[2], m[0]), cross(m[0], m[1]));
+	return normalize(cofactor * normal) * sign(dot(m[0], cofactor[0]));
+}
+
+void main() {
+	ObjectData object = objects[visibleInstances[gl_InstanceIndex]];
+	vec4 positionWorld = vec4(vec4(position, 1.0) * object.transform, 1.0);
+	gl_Position = ubo.projection * (ubo.view * positionWorld);
+
+	fragNormalWorld = transformNormal(object.transform, normal);
+	fragPosWorld = positionWorld.xyz;
+	fragColor = color;
+}
@@ -0,0 +1,429 @@
+/**
+ * @file gpu_driven_render_system.cpp
+ * @brief Implementation of the GpuDrivenRenderSystem class, which culls and builds draws on the GPU.
+ *
+ * This file contains the upload of object and mesh data into storage buffers, the per frame compute passes that
+ * frustum cull objects and write indirect draw commands, and the graphics pass that consumes those commands with
+ * indirect count draws. When VK_KHR_draw_indirect_count is unavailable every mesh is drawn with a plain indirect
+ * draw instead, meshes without visible instances then issue a draw with an instance count of zero.
+ */
+
+#include "gpu_driven_render_system.hpp"
+
+#include "lve_frustum.hpp"
+#include "lve_gpu_profiler.hpp"
+#include "lve_transform_buffer.hpp"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace lve {
+
+	// matches ObjectData in gpu_cull.comp and gpu_driven.vert (std430)
+	struct GpuObjectData {
+		AffineTransform transform;
+		glm::vec4 boundingSphere{ 0.f };
+		uint32_t meshIndex = 0;
+		uint32_t padding[3]{};
+	};
+
+	// matches MeshData in gpu_cull.comp and gpu_build_draws.comp
+	struct GpuMeshData {
+		uint32_t indexCount;
+		uint32_t vertexCount;
+		uint32_t firstInstance;
+		uint32_t instanceCapacity;
+	};
+
+	struct GpuCullPushConstants {
+		glm::vec4 frustumPlanes[LveFrustum::Count];
+		uint32_t objectCount;
+		uint32_t meshCount;
+	};
+
+	static_assert(sizeof(GpuObjectData) == 80, "GpuObjectData must match the std430 layout in the shaders");
+	static_assert(sizeof(VkDrawIndexedIndirectCommand) == 5 * sizeof(uint32_t), "unexpected indirect command size");
+
+	constexpr uint32_t CULL_WORKGROUP_SIZE = 64;
+
+	/**
+		 * @brief Constructs a `GpuDrivenRenderSystem` instance.
+		 *
+		 * @param device A reference to the `LveDevice` used to create Vulkan resources.
+		 * @param pipelineCompiler Compiles the culling, draw building and graphics pipelines in the background,
+		 *        nothing is culled or drawn until all three are ready.
+		 * @param renderPass A Vulkan `VkRenderPass` used for rendering.
+		 * @param globalSetLayout A Vulkan `VkDescriptorSetLayout` for global descriptor sets.
+		 * @param framesInFlight Number of frames the renderer keeps in flight, each gets its own culling output.
+		 */
+	GpuDrivenRenderSystem::GpuDrivenRenderSystem(
+		LveDevice& device,
+		LvePipelineCompiler& pipelineCompiler,
+		VkRenderPass renderPass,
+		VkDescriptorSetLayout globalSetLayout,
+		uint32_t framesInFlight)
+		: lveDevice{ device }, framesInFlight{ framesInFlight } {
+		createDescriptorResources();
+		createPipelineLayouts(globalSetLayout);
+		createPipelines(pipelineCompiler, renderPass);
+	}
+
+	/**
+		 * @brief Destructs the `GpuDrivenRenderSystem` instance.
+		 */
+	GpuDrivenRenderSystem::~GpuDrivenRenderSystem() {
+		// pending compilations still use the layouts
+		cullPipeline.wait();
+		buildDrawsPipeline.wait();
+		graphicsPipeline.wait();
+		vkDestroyPipelineLayout(lveDevice.device(), computePipelineLayout, nullptr);
+		vkDestroyPipelineLayout(lveDevice.device(), graphicsPipelineLayout, nullptr);
+	}
+
+	/**
+		 * @brief Creates the descriptor set layout and pool shared by the compute and graphics passes.
+		 *
+		 * Binding 0 holds objects, 1 meshes, 2 visible instances, 3 per mesh instance counts, 4 draw commands and
+		 * 5 draw counts. Each frame in flight gets its own set, since the compute pass writes bindings 2 to 5.
+		 */
+	void GpuDrivenRenderSystem::createDescriptorResources() {
+		const VkShaderStageFlags stages = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT;
+		cullSetLayout =
+			LveDescriptorSetLayout::Builder(lveDevice)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages)
+			.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages)
+			.addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages)
+			.addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages)
+			.addBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages)
+			.addBinding(5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages)
+			.build();
+		cullPool =
+			LveDescriptorPool::Builder(lveDevice)
+			.setMaxSets(framesInFlight)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 6 * framesInFlight)
+			.build();
+	}
+
+	/**
+		 * @brief Creates the compute and graphics pipeline layouts.
+		 *
+		 * @param globalSetLayout A Vulkan `VkDescriptorSetLayout` used as set 0 of both layouts.
+		 *
+		 * Throws an exception if pipeline layout creation fails.
+		 */
+	void GpuDrivenRenderSystem::createPipelineLayouts(VkDescriptorSetLayout globalSetLayout) {
+		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{
+			globalSetLayout,
+			cullSetLayout->getDescriptorSetLayout() };
+
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(GpuCullPushConstants);
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+		pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &computePipelineLayout) !=
+			VK_SUCCESS) {
+			throw std::runtime_error("Failed to create compute pipeline layout!");
+		}
+
+		pipelineLayoutInfo.pushConstantRangeCount = 0;
+		pipelineLayoutInfo.pPushConstantRanges = nullptr;
+		if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &graphicsPipelineLayout) !=
+			VK_SUCCESS) {
+			throw std::runtime_error("Failed to create graphics pipeline layout!");
+		}
+	}
+
+	/**
+		 * @brief Queues the culling and draw building compute pipelines and the graphics pipeline.
+		 *
+		 * @param pipelineCompiler The compiler the pipelines are created on.
+		 * @param renderPass A Vulkan `VkRenderPass` used for rendering.
+		 *
+		 * The three compile concurrently on the job system. A compilation error is rethrown by the first frame
+		 * that finds the failed pipeline.
+		 */
+	void GpuDrivenRenderSystem::createPipelines(LvePipelineCompiler& pipelineCompiler, VkRenderPass renderPass) {
+		assert(graphicsPipelineLayout != nullptr && "Cannot create pipeline before pipline layout.");
+
+		cullPipeline = pipelineCompiler.compileCompute("gpu_cull.comp.spv", computePipelineLayout);
+		buildDrawsPipeline = pipelineCompiler.compileCompute("gpu_build_draws.comp.spv", computePipelineLayout);
+
+		VkPipelineLayout layout = graphicsPipelineLayout;
+		graphicsPipeline = pipelineCompiler.compileGraphics(
+			"gpu_driven.vert.spv",
+			"simple_shader.frag.spv",
+			[renderPass, layout](PipelineConfigInfo& pipelineConfig) {
+				pipelineConfig.renderPass = renderPass;
+				pipelineConfig.pipelineLayout = layout;
+			});
+	}
+
+	/**
+		 * @brief Creates a device local buffer, optionally filled from host memory through a staging buffer.
+		 *
+		 * @param instanceSize Size of one element.
+		 * @param instanceCount Number of elements, at least one element is always allocated.
+		 * @param usage Usage flags, transfer destination is added automatically.
+		 * @param data Initial contents for `instanceCount` elements, or null.
+		 */
+	std::unique_ptr<LveBuffer> GpuDrivenRenderSystem::createDeviceLocalBuffer(
+		VkDeviceSize instanceSize, uint32_t instanceCount, VkBufferUsageFlags usage, const void* data) {
+		// zero sized buffers are not allowed, empty scenes still get a single element
+		const bool hasData = data != nullptr && instanceCount > 0;
+		instanceCount = std::max(instanceCount, 1u);
+		auto buffer = std::make_unique<LveBuffer>(
+			lveDevice,
+			instanceSize,
+			instanceCount,
+			usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		if (hasData) {
+			LveBuffer stagingBuffer{
+				lveDevice,
+				instanceSize,
+				instanceCount,
+				VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			};
+			stagingBuffer.map();
+			stagingBuffer.writeToBuffer(const_cast<void*>(data));
+			lveDevice.copyBuffer(stagingBuffer.getBuffer(), buffer->getBuffer(), buffer->getBufferSize());
+		}
+		return buffer;
+	}
+
+	/**
+		 * @brief Uploads the transforms and bounds of every object with a model.
+		 *
+		 * @param gameObjects The objects to render, objects without a model are ignored.
+		 *
+		 * Objects are grouped by model. Each model becomes a mesh owning a range of the visible instance buffer large
+		 * enough for all of its objects, so the culling pass never needs to allocate. Waits for the device to be idle
+		 * because the per frame buffers are replaced.
+		 */
+	void GpuDrivenRenderSystem::uploadScene(LveGameObject::Map& gameObjects) {
+		vkDeviceWaitIdle(lveDevice.device());
+
+		meshes.clear();
+		std::unordered_map<LveModel*, uint32_t> meshIndices;
+		std::vector<GpuObjectData> objects;
+		std::vector<GpuMeshData> meshData;
+		objects.reserve(gameObjects.size());
+
+		for (auto& kv : gameObjects) {
+			auto& obj = kv.second;
+			if (obj.model == nullptr) continue;
+
+			auto inserted = meshIndices.emplace(obj.model.get(), static_cast<uint32_t>(meshes.size()));
+			if (inserted.second) {
+				meshes.push_back(obj.model);
+				meshData.push_back(GpuMeshData{ obj.model->getIndexCount(), obj.model->getVertexCount(), 0, 0 });
+			}
+
+			GpuObjectData object{};
+			glm::mat4 modelMatrix = obj.transform.mat4();
+			object.transform = AffineTransform::fromMat4(modelMatrix);
+			BoundingSphere sphere = obj.model->getBoundingSphere().transformed(modelMatrix, obj.transform.scale);
+			object.boundingSphere = glm::vec4(sphere.center, sphere.radius);
+			object.meshIndex = inserted.first->second;
+			meshData[object.meshIndex].instanceCapacity++;
+			objects.push_back(object);
+		}
+
+		uint32_t firstInstance = 0;
+		for (auto& mesh : meshData) {
+			mesh.firstInstance = firstInstance;
+			firstInstance += mesh.instanceCapacity;
+		}
+		objectCount = static_cast<uint32_t>(objects.size());
+		const uint32_t meshCount = static_cast<uint32_t>(meshData.size());
+
+		objectBuffer = createDeviceLocalBuffer(
+			sizeof(GpuObjectData), objectCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, objects.data());
+		meshBuffer = createDeviceLocalBuffer(
+			sizeof(GpuMeshData), meshCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, meshData.data());
+
+		cullPool->resetPool();
+		frames.resize(framesInFlight);
+		for (auto& frame : frames) {
+			frame.visibleInstanceBuffer = createDeviceLocalBuffer(
+				sizeof(uint32_t), objectCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, nullptr);
+			frame.meshInstanceCountBuffer = createDeviceLocalBuffer(
+				sizeof(uint32_t), meshCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, nullptr);
+			frame.drawCommandBuffer = createDeviceLocalBuffer(
+				sizeof(VkDrawIndexedIndirectCommand),
+				meshCount,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+				nullptr);
+			frame.drawCountBuffer = createDeviceLocalBuffer(
+				sizeof(uint32_t),
+				meshCount,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+				nullptr);
+
+			auto objectInfo = objectBuffer->descriptorInfo();
+			auto meshInfo = meshBuffer->descriptorInfo();
+			auto visibleInfo = frame.visibleInstanceBuffer->descriptorInfo();
+			auto countInfo = frame.meshInstanceCountBuffer->descriptorInfo();
+			auto commandInfo = frame.drawCommandBuffer->descriptorInfo();
+			auto drawCountInfo = frame.drawCountBuffer->descriptorInfo();
+			if (!LveDescriptorWriter(*cullSetLayout, *cullPool)
+				.writeBuffer(0, &objectInfo)
+				.writeBuffer(1, &meshInfo)
+				.writeBuffer(2, &visibleInfo)
+				.writeBuffer(3, &countInfo)
+				.writeBuffer(4, &commandInfo)
+				.writeBuffer(5, &drawCountInfo)
+				.build(frame.descriptorSet)) {
+				throw std::runtime_error("Failed to allocate GPU culling descriptor set!");
+			}
+		}
+	}
+
+	/**
+		 * @brief Records the compute passes that cull objects and write this frame's indirect draws.
+		 *
+		 * @param frameInfo A reference to the `FrameInfo` struct containing frame-specific data.
+		 *
+		 * Clears the per mesh instance counts, culls one object per invocation, then builds one draw command per mesh.
+		 * A final barrier makes the results visible to indirect command reads and the vertex shader.
+		 */
+	void GpuDrivenRenderSystem::cull(FrameInfo& frameInfo) {
+		// get() caches each pipeline once it is ready, so all three are resolved here, on one thread
+		LvePipeline* culling = cullPipeline.get();
+		LvePipeline* buildDraws = buildDrawsPipeline.get();
+		LvePipeline* graphics = graphicsPipeline.get();
+		frameGraphicsPipeline = nullptr;
+		if (culling == nullptr || buildDraws == nullptr || graphics == nullptr) return;
+		if (frames.empty() || objectCount == 0) return;
+		frameGraphicsPipeline = graphics;
+
+		VkCommandBuffer commandBuffer = frameInfo.commandBuffer;
+		FrameResources& frame = frames[frameInfo.frameIndex];
+		LveGpuProfiler::Zone gpuZone{ frameInfo.gpuProfiler, commandBuffer, "gpu cull" };
+
+		vkCmdFillBuffer(commandBuffer, frame.meshInstanceCountBuffer->getBuffer(), 0, VK_WHOLE_SIZE, 0);
+
+		auto memoryBarrier = [commandBuffer](
+			VkAccessFlags srcAccess, VkAccessFlags dstAccess, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage) {
+			VkMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = srcAccess;
+			barrier.dstAccessMask = dstAccess;
+			vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+		};
+		memoryBarrier(
+			VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+		GpuCullPushConstants push{};
+		LveFrustum frustum{ frameInfo.camera.getProjection() * frameInfo.camera.getView() };
+		for (int i = 0; i < LveFrustum::Count; i++) {
+			push.frustumPlanes[i] = frustum.getPlanes()[i];
+		}
+		push.objectCount = objectCount;
+		push.meshCount = getMeshCount();
+
+		vkCmdBindDescriptorSets(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_COMPUTE,
+			computePipelineLayout,
+			1,
+			1,
+			&frame.descriptorSet,
+			0,
+			nullptr);
+		vkCmdPushConstants(
+			commandBuffer, computePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(GpuCullPushConstants), &push);
+
+		culling->bind(commandBuffer);
+		vkCmdDispatch(commandBuffer, (objectCount + CULL_WORKGROUP_SIZE - 1) / CULL_WORKGROUP_SIZE, 1, 1);
+
+		memoryBarrier(
+			VK_ACCESS_SHADER_WRITE_BIT,
+			VK_ACCESS_SHADER_READ_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+		buildDraws->bind(commandBuffer);
+		vkCmdDispatch(commandBuffer, (push.meshCount + CULL_WORKGROUP_SIZE - 1) / CULL_WORKGROUP_SIZE, 1, 1);
+
+		memoryBarrier(
+			VK_ACCESS_SHADER_WRITE_BIT,
+			VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT);
+	}
+
+	/**
+		 * @brief Draws every mesh with the commands written by cull().
+		 *
+		 * @param frameInfo A reference to the `FrameInfo` struct containing frame-specific data.
+		 *
+		 * Models own separate vertex and index buffers, so each mesh is bound and drawn with its own indirect count
+		 * draw whose count is zero when none of its instances are visible. Draws nothing when cull() did not record
+		 * this frame's commands.
+		 */
+	void GpuDrivenRenderSystem::render(FrameInfo& frameInfo) {
+		if (frameGraphicsPipeline == nullptr) return;
+
+		VkCommandBuffer commandBuffer = frameInfo.commandBuffer;
+		FrameResources& frame = frames[frameInfo.frameIndex];
+		LveGpuProfiler::Zone gpuZone{ frameInfo.gpuProfiler, commandBuffer, "indirect draws" };
+
+		frameGraphicsPipeline->bind(commandBuffer);
+
+		VkDescriptorSet descriptorSets[] = { frameInfo.globalDescriptorSet, frame.descriptorSet };
+		vkCmdBindDescriptorSets(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			graphicsPipelineLayout,
+			0,
+			2,
+			descriptorSets,
+			0,
+			nullptr);
+
+		const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+		auto drawIndexedIndirectCount = lveDevice.getCmdDrawIndexedIndirectCount();
+		// every mesh has its own vertex and index buffers, so each is a single draw and multiDrawIndirect is not
+		// needed
+		for (uint32_t i = 0; i < meshes.size(); i++) {
+			meshes[i]->bind(commandBuffer);
+			const VkDeviceSize commandOffset = i * stride;
+			if (meshes[i]->getIndexCount() == 0) {
+				vkCmdDrawIndirect(commandBuffer, frame.drawCommandBuffer->getBuffer(), commandOffset, 1, stride);
+			} else if (drawIndexedIndirectCount != nullptr) {
+				drawIndexedIndirectCount(
+					commandBuffer,
+					frame.drawCommandBuffer->getBuffer(),
+					commandOffset,
+					frame.drawCountBuffer->getBuffer(),
+					i * sizeof(uint32_t),
+					1,
+					stride);
+			} else {
+				vkCmdDrawIndexedIndirect(commandBuffer, frame.drawCommandBuffer->getBuffer(), commandOffset, 1, stride);
+			}
+		}
+	}
+}
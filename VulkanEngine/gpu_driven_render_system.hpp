@@ -0,0 +1,90 @@
+#pragma once
+
+#include "lve_buffer.hpp"
+#include "lve_descriptors.hpp"
+#include "lve_device.hpp"
+#include "lve_frame_info.hpp"
+#include "lve_game_object.hpp"
+#include "lve_pipeline.hpp"
+#include "lve_pipeline_compiler.hpp"
+
+// std
+#include <memory>
+#include <vector>
+
+namespace lve {
+
+	/**
+	 * Renders game objects with culling and draw generation done on the GPU.
+	 *
+	 * Object transforms and bounds are uploaded once with uploadScene(). Every frame a compute pass tests each object
+	 * against the view frustum, appends the visible ones to their mesh's instance range and writes one indexed
+	 * indirect command plus a draw count per mesh. The graphics pass then issues one indirect count draw per mesh,
+	 * so the CPU cost of a frame depends on the number of distinct models only.
+	 *
+	 * The pipelines compile on the pipeline compiler like the other render systems'. Until all three are ready
+	 * cull() and render() record nothing.
+	 */
+	class GpuDrivenRenderSystem {
+	public:
+		GpuDrivenRenderSystem(
+			LveDevice& device,
+			LvePipelineCompiler& pipelineCompiler,
+			VkRenderPass renderPass,
+			VkDescriptorSetLayout globalSetLayout,
+			uint32_t framesInFlight);
+		~GpuDrivenRenderSystem();
+
+		GpuDrivenRenderSystem(const GpuDrivenRenderSystem&) = delete;
+		GpuDrivenRenderSystem& operator=(const GpuDrivenRenderSystem&) = delete;
+
+		// indirect commands with a non zero firstInstance need drawIndirectFirstInstance
+		static bool isSupported(LveDevice& device) { return device.getEnabledFeatures().drawIndirectFirstInstance; }
+
+		// Uploads every object with a model, objects are treated as static until the next upload. Waits for the device.
+		void uploadScene(LveGameObject::Map& gameObjects);
+
+		// Records the culling dispatches, must be called outside of a render pass
+		void cull(FrameInfo& frameInfo);
+		void render(FrameInfo& frameInfo);
+
+		uint32_t getObjectCount() const { return objectCount; }
+		uint32_t getMeshCount() const { return static_cast<uint32_t>(meshes.size()); }
+
+	private:
+		struct FrameResources {
+			std::unique_ptr<LveBuffer> visibleInstanceBuffer;
+			std::unique_ptr<LveBuffer> meshInstanceCountBuffer;
+			std::unique_ptr<LveBuffer> drawCommandBuffer;
+			std::unique_ptr<LveBuffer> drawCountBuffer;
+			VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+		};
+
+		void createDescriptorResources();
+		void createPipelineLayouts(VkDescriptorSetLayout globalSetLayout);
+		void createPipelines(LvePipelineCompiler& pipelineCompiler, VkRenderPass renderPass);
+		std::unique_ptr<LveBuffer> createDeviceLocalBuffer(
+			VkDeviceSize instanceSize, uint32_t instanceCount, VkBufferUsageFlags usage, const void* data);
+
+		LveDevice& lveDevice;
+		uint32_t framesInFlight;
+
+		std::unique_ptr<LveDescriptorSetLayout> cullSetLayout;
+		std::unique_ptr<LveDescriptorPool> cullPool;
+		VkPipelineLayout computePipelineLayout;
+		VkPipelineLayout graphicsPipelineLayout;
+		LveAsyncPipeline cullPipeline;
+		LveAsyncPipeline buildDrawsPipeline;
+		LveAsyncPipeline graphicsPipeline;
+		// resolved by cull() on the recording thread, null while any of the three is still compiling, so render()
+		// never draws commands the current frame did not write
+		LvePipeline* frameGraphicsPipeline = nullptr;
+
+		// mesh i draws models[i], ordered by first appearance in the uploaded scene
+		std::vector<std::shared_ptr<LveModel>> meshes;
+		uint32_t objectCount = 0;
+		std::unique_ptr<LveBuffer> objectBuffer;
+		std::unique_ptr<LveBuffer> meshBuffer;
+		std::vector<FrameResources> frames;
+	};
+}
@@ -0,0 +1,225 @@
+/**
+ * @file headless_app.cpp
+ * @brief Implementation of the HeadlessApp class, which renders the scene without a window.
+ *
+ * This file sets up the scene renderer shared with FirstApp on a headless device and drives it through a list of
+ * camera poses into an offscreen target, reading the images back asynchronously to image files or a video stream.
+ */
+
+#include "headless_app.hpp"
+
+#include "lve_camera.hpp"
+#include "lve_frame_readback.hpp"
+#include "lve_scene_file.hpp"
+#include "lve_scene_renderer.hpp"
+#include "lve_y4m_writer.hpp"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace lve {
+
+	/**
+	 * @brief Creates the headless device, the offscreen renderer and the descriptor pool, and loads the scene.
+	 *
+	 * @param scenePath The binary scene, or its text description ending in `.txt`.
+	 * @param extent Size of the rendered images.
+	 * @param framesInFlight Number of frames the CPU may record ahead of the GPU.
+	 */
+	HeadlessApp::HeadlessApp(const std::string& scenePath, VkExtent2D extent, uint32_t framesInFlight)
+		: lveRenderer{ lveDevice, extent, framesInFlight } {
+		globalPool =
+			LveDescriptorPool::Builder(lveDevice)
+			.setMaxSets(framesInFlight)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, framesInFlight)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 * framesInFlight)
+			.build();
+		loadGameObjects(scenePath);
+	}
+
+	HeadlessApp::~HeadlessApp() {}
+
+	/**
+	 * @brief Renders one image per camera pose.
+	 *
+	 * @param poses The camera poses, rendered in order.
+	 * @param outputDirectory Directory the images are written to as `pose_<index>` with the configured extension,
+	 *        created if needed. Nothing is read back when it is empty, which measures rendering alone.
+	 *
+	 * Unlike the windowed application, nothing is drawn before every pipeline has compiled, so each image shows
+	 * the whole scene. Images are captured into the readback ring after the render pass and encoded on separate
+	 * threads, the render loop only polls it; everything still pending is flushed once all poses are submitted.
+	 * A video stream gets every frame in pose order, and the time the render loop waited for its reader is
+	 * reported as readback time.
+	 */
+	void HeadlessApp::render(const std::vector<CameraPose>& poses, const std::string& outputDirectory) {
+		const uint32_t framesInFlight = lveRenderer.getFramesInFlight();
+		LveSceneRenderer sceneRenderer{
+			lveDevice,
+			jobSystem,
+			*globalPool,
+			lveRenderer.getRenderPass(),
+			framesInFlight,
+			gameObjects,
+			sceneBvh,
+			gpuDrivenRendering };
+		if (gpuDrivenRendering && !sceneRenderer.supportsGpuDrivenRendering()) {
+			std::cout << "GPU driven rendering is not supported by this device, using CPU culling" << std::endl;
+		}
+		sceneRenderer.setGpuDrivenRendering(gpuDrivenRendering);
+		LveGpuProfiler& gpuProfiler = sceneRenderer.getGpuProfiler();
+
+		auto compileStart = std::chrono::high_resolution_clock::now();
+		sceneRenderer.getPipelineCompiler().waitIdle();
+		std::cout << "Pipelines compiled in " << std::chrono::duration<float, std::milli>(
+			std::chrono::high_resolution_clock::now() - compileStart).count() << " ms" << std::endl;
+
+		const bool writeVideo = !videoOutput.empty();
+		const bool writeImages = !writeVideo && !outputDirectory.empty();
+		const VkExtent2D extent = lveRenderer.getExtent();
+		const float frameTime = 1.f / static_cast<float>(frameRate);
+		// declared before the readback, whose encoders write to it until they are joined
+		std::unique_ptr<LveY4mWriter> videoWriter;
+		std::unique_ptr<LveFrameReadback> readback;
+		if (writeVideo) {
+			videoWriter = std::make_unique<LveY4mWriter>(videoOutput, extent.width, extent.height, frameRate);
+			readback = std::make_unique<LveFrameReadback>(lveDevice, lveRenderer, readbackSlots);
+			readback->setWaitWhenFull(true);
+		} else if (writeImages) {
+			std::filesystem::create_directories(outputDirectory);
+			readback = std::make_unique<LveFrameReadback>(lveDevice, lveRenderer, readbackSlots);
+		}
+
+		// seconds spent in each stage, summed over all images
+		float fenceWaitTime = 0.f;
+		float updateTime = 0.f;
+		float recordTime = 0.f;
+		float submitTime = 0.f;
+		float readbackTime = 0.f;
+		// lights and cluster entries left out of the fullest image's clusters
+		uint32_t maxDroppedLights = 0;
+		using Clock = std::chrono::high_resolution_clock;
+		auto secondsSince = [](Clock::time_point start) {
+			return std::chrono::duration<float>(Clock::now() - start).count();
+		};
+
+		LveCamera camera{};
+		camera.setPerspectiveProjection(glm::radians(50.f), lveRenderer.getAspectRatio(), 0.1f, 1000.f);
+
+		auto renderStart = Clock::now();
+		for (size_t poseIndex = 0; poseIndex < poses.size(); poseIndex++) {
+			VkCommandBuffer commandBuffer = lveRenderer.beginFrame();
+			fenceWaitTime += lveRenderer.getFenceWaitTime();
+
+			int frameIndex = lveRenderer.getFrameIndex();
+
+			auto updateStart = Clock::now();
+			camera.setViewYXZ(poses[poseIndex].position, poses[poseIndex].rotation);
+			FrameInfo frameInfo = sceneRenderer.beginFrame(commandBuffer, frameIndex, frameTime, camera);
+			sceneRenderer.update(frameInfo);
+			updateTime += secondsSince(updateStart);
+			maxDroppedLights = std::max(maxDroppedLights, sceneRenderer.getLightClusters().getDroppedCount());
+
+			auto recordStart = Clock::now();
+			sceneRenderer.record(frameInfo, lveRenderer.getRenderPass(), lveRenderer.getCurrentFrameBuffer(), extent);
+			lveRenderer.beginRenderPass(commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+			sceneRenderer.executeSecondaries(commandBuffer);
+			lveRenderer.endRenderPass(commandBuffer);
+			sceneRenderer.endFrame(commandBuffer);
+			recordTime += secondsSince(recordStart);
+
+			if (writeVideo) {
+				auto readbackStart = Clock::now();
+				LveY4mWriter* writer = videoWriter.get();
+				readback->capture(commandBuffer, [writer, poseIndex](const uint8_t* rgba) {
+					writer->writeFrame(poseIndex, rgba);
+				});
+				readbackTime += secondsSince(readbackStart);
+			} else if (writeImages) {
+				auto readbackStart = Clock::now();
+				std::ostringstream filename;
+				filename << "pose_" << std::setw(6) << std::setfill('0') << poseIndex << imageExtension;
+				readback->capture(commandBuffer, (std::filesystem::path{ outputDirectory } / filename.str()).string());
+				readbackTime += secondsSince(readbackStart);
+			}
+
+			auto submitStart = Clock::now();
+			lveRenderer.endFrame();
+			submitTime += secondsSince(submitStart);
+		}
+
+		auto drainStart = Clock::now();
+		lveRenderer.waitForAllFrames();
+		fenceWaitTime += secondsSince(drainStart);
+		float renderTime = secondsSince(renderStart);
+		float flushTime = 0.f;
+		if (readback) {
+			auto flushStart = Clock::now();
+			readback->flush();
+			flushTime = secondsSince(flushStart);
+		}
+
+		const size_t imageCount = poses.size();
+		std::cout << "Rendered " << imageCount << " images at " << extent.width << "x" << extent.height << " in "
+			<< 1000.f * renderTime << " ms";
+		if (imageCount > 0 && renderTime > 0.f) {
+			const float perImage = 1000.f / imageCount;
+			std::cout << ", " << imageCount / renderTime << " images/s, " << framesInFlight << " frames in flight"
+				<< std::endl;
+			std::cout << "Per image: fence wait " << perImage * fenceWaitTime << " ms, update "
+				<< perImage * updateTime << " ms, record " << perImage * recordTime << " ms, submit "
+				<< perImage * submitTime << " ms, readback " << perImage * readbackTime << " ms";
+		}
+		std::cout << std::endl;
+		std::cout << "Light clusters: up to " << maxDroppedLights << " lights and cluster entries dropped per image"
+			<< std::endl;
+		gpuProfiler.logTimings(std::cout);
+		if (writeVideo) {
+			std::cout << "Streamed " << videoWriter->getWrittenCount() << " frames at " << frameRate
+				<< " fps, blocked on the reader for " << 1000.f * readback->getBlockedTime() << " ms, waited "
+				<< 1000.f * flushTime << " ms for the last to be written" << std::endl;
+		} else if (writeImages) {
+			const uint64_t writtenCount = readback->getWrittenCount();
+			std::cout << "Wrote " << writtenCount << " images, dropped " << readback->getDroppedCount()
+				<< ", waited " << 1000.f * flushTime << " ms for the last to be written";
+			if (writtenCount > 0) {
+				std::cout << ", encoding " << 1000.f * readback->getEncodeTime() / writtenCount
+					<< " ms per image on the encoder threads";
+			}
+			std::cout << std::endl;
+		}
+
+		vkDeviceWaitIdle(lveDevice.device());
+	}
+
+	void HeadlessApp::loadGameObjects(const std::string& scenePath) {
+		std::string binaryPath = scenePath;
+		const std::string textSuffix = ".txt";
+		if (scenePath.size() > textSuffix.size() &&
+			scenePath.compare(scenePath.size() - textSuffix.size(), textSuffix.size(), textSuffix) == 0) {
+			binaryPath = scenePath.substr(0, scenePath.size() - textSuffix.size());
+			LveSceneFile::convertIfOutdated(scenePath, binaryPath);
+		}
+
+		auto loadStart = std::chrono::high_resolution_clock::now();
+		LveSceneFile scene{ binaryPath };
+		const SceneLoadTimes times = scene.createGameObjects(lveDevice, gameObjects, sceneBvh);
+
+		float loadTime = std::chrono::duration<float, std::chrono::milliseconds::period>(
+			std::chrono::high_resolution_clock::now() - loadStart).count();
+		std::cout << "Loaded " << scene.getEntityCount() << " entities and " << scene.getModelCount()
+			<< " models in " << loadTime << " ms (models " << times.modelMs << " ms, entities " << times.entityMs
+			<< " ms, BVH build " << times.bvhMs << " ms)" << std::endl;
+	}
+}
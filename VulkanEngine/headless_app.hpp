@@ -0,0 +1,85 @@
+#pragma once
+
+#include "lve_camera_poses.hpp"
+#include "lve_descriptors.hpp"
+#include "lve_device.hpp"
+#include "lve_game_object.hpp"
+#include "lve_headless_renderer.hpp"
+#include "lve_job_system.hpp"
+#include "lve_scene_bvh.hpp"
+
+// std
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+	/**
+	 * Renders the scene without a window or display, on a headless device and an offscreen target.
+	 *
+	 * Uses the render systems of FirstApp unchanged. Each frame renders one camera pose and frames advance with
+	 * a fixed time step, so the same poses always render the same images. Meant for batch rendering on render
+	 * farm nodes and CI machines without X11, where Mesa lavapipe provides the device.
+	 *
+	 * Throughput comes from keeping every frame in flight busy: a frame's image is copied into a staging buffer on
+	 * the GPU and encoded by LveFrameReadback on its own threads once the frame has completed, so the render loop
+	 * never waits for readback or encoding. When encoding falls behind for longer than the staging buffers can
+	 * absorb, images are dropped and reported rather than stalling the GPU.
+	 *
+	 * Alternatively the frames are streamed as raw Y4M video to a file, pipe or stdout. A video must contain every
+	 * frame, so the readback waits instead of dropping, and a slow reader such as an encoder process slows the
+	 * render loop down to its pace. The simulation still advances exactly one frame time per frame.
+	 */
+	class HeadlessApp {
+	public:
+		static constexpr uint32_t WIDTH = 800;
+		static constexpr uint32_t HEIGHT = 600;
+		static constexpr uint32_t DEFAULT_FRAME_RATE = 60;
+		static constexpr uint32_t DEFAULT_READBACK_SLOTS = 8;
+
+		// scenePath is a binary scene or a text description ending in .txt, converted next to it when outdated,
+		// framesInFlight from 1 to LveSwapChain::MAX_FRAMES_IN_FLIGHT
+		HeadlessApp(
+			const std::string& scenePath,
+			VkExtent2D extent = { WIDTH, HEIGHT },
+			uint32_t framesInFlight = LveSwapChain::DEFAULT_FRAMES_IN_FLIGHT);
+		~HeadlessApp();
+
+		HeadlessApp(const HeadlessApp&) = delete;
+		HeadlessApp& operator=(const HeadlessApp&) = delete;
+
+		// Renders one image per pose once every pipeline has compiled, streamed to the video output if one is set
+		// or else written to outputDirectory unless it is empty, then reports the throughput and the time spent in
+		// each stage
+		void render(const std::vector<CameraPose>& poses, const std::string& outputDirectory);
+
+		// culls and builds draws with compute shaders when supported
+		void setGpuDrivenRendering(bool enabled) { gpuDrivenRendering = enabled; }
+		// extension of the written images: .png, .ppm or .exr
+		void setImageExtension(const std::string& extension) { imageExtension = extension; }
+		// staging buffers for readback, more than the frames in flight
+		void setReadbackSlots(uint32_t slotCount) { readbackSlots = slotCount; }
+		// streams the frames as Y4M video to "-" for stdout, "fd:<n>" or a file or named pipe, empty to disable
+		void setVideoOutput(const std::string& output) { videoOutput = output; }
+		// frames per simulated second, the fixed time step the scene advances by each frame
+		void setFrameRate(uint32_t framesPerSecond) { frameRate = framesPerSecond; }
+
+	private:
+		void loadGameObjects(const std::string& scenePath);
+
+		LveDevice lveDevice{};
+		LveHeadlessRenderer lveRenderer;
+		LveJobSystem jobSystem{};
+
+		// order of declaration matters
+		std::unique_ptr<LveDescriptorPool> globalPool{};
+		LveGameObject::Map gameObjects;
+		LveSceneBvh sceneBvh{};
+		bool gpuDrivenRendering = false;
+		std::string imageExtension = ".png";
+		uint32_t readbackSlots = DEFAULT_READBACK_SLOTS;
+		std::string videoOutput;
+		uint32_t frameRate = DEFAULT_FRAME_RATE;
+	};
+}
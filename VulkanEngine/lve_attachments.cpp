@@ -0,0 +1,167 @@
+/**
+ * @file lve_attachments.cpp
+ * @brief Render pass and attachment image helpers shared by the swap chain and the offscreen targets.
+ *
+ * The swap chain, the dynamically scaled scene target and the headless offscreen target all render the scene
+ * into a color image and a depth buffer with the same attachment setup, which keeps their render passes
+ * compatible so the render systems' pipelines work with any of them.
+ *
+ * Depth is cleared at the start of the pass and never stored, and every frame is rendered on the same queue,
+ * so a single depth image serves every frame in flight: the render pass dependency makes a frame's depth
+ * clear wait for the depth writes of the frame before it. The image is a transient attachment, backed by
+ * lazily allocated memory where the device has it, which tile based GPUs may never back with real memory at all.
+ */
+
+#include "lve_attachments.hpp"
+
+// std
+#include <array>
+#include <stdexcept>
+
+namespace lve {
+
+	/**
+	 * @brief Creates a render pass with one color and one transient depth attachment.
+	 *
+	 * @param device The device the render pass is created on.
+	 * @param colorFormat Format of the color attachment.
+	 * @param depthFormat Format of the depth attachment.
+	 * @param colorFinalLayout Layout the color image is left in, like the present layout for the swap chain or
+	 *        the transfer source layout for images read by a transfer after the pass.
+	 * @return The render pass, owned by the caller.
+	 * @throws std::runtime_error If the render pass could not be created.
+	 */
+	VkRenderPass createColorDepthRenderPass(
+		LveDevice& device, VkFormat colorFormat, VkFormat depthFormat, VkImageLayout colorFinalLayout) {
+		VkAttachmentDescription colorAttachment{};
+		colorAttachment.format = colorFormat;
+		colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		colorAttachment.finalLayout = colorFinalLayout;
+
+		VkAttachmentDescription depthAttachment{};
+		depthAttachment.format = depthFormat;
+		depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		VkAttachmentReference colorAttachmentRef{ 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+		VkAttachmentReference depthAttachmentRef{ 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+
+		VkSubpassDescription subpass{};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = 1;
+		subpass.pColorAttachments = &colorAttachmentRef;
+		subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+		std::array<VkSubpassDependency, 2> dependencies{};
+		// the shared depth buffer was last written by the previous frame's pass, its writes finish in the late
+		// fragment tests
+		dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[0].dstSubpass = 0;
+		dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependencies[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+		dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		// a color image left for transfers is blitted or copied out after the pass
+		dependencies[1].srcSubpass = 0;
+		dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		const bool readByTransfer = colorFinalLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+		std::array<VkAttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
+		VkRenderPassCreateInfo renderPassInfo{};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+		renderPassInfo.pAttachments = attachments.data();
+		renderPassInfo.subpassCount = 1;
+		renderPassInfo.pSubpasses = &subpass;
+		renderPassInfo.dependencyCount = readByTransfer ? 2 : 1;
+		renderPassInfo.pDependencies = dependencies.data();
+
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+		if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create render pass!");
+		}
+		return renderPass;
+	}
+
+	/**
+	 * @brief Creates an attachment image and a view of it.
+	 *
+	 * @param device The device the image is created on.
+	 * @param format Format of the image and view.
+	 * @param extent Size of the image.
+	 * @param usage How the image is used.
+	 * @param memoryProperties Properties of the memory bound to the image.
+	 * @param aspect Aspect of the image the view covers.
+	 * @throws std::runtime_error If the image or its view could not be created.
+	 */
+	LveAttachmentImage createAttachmentImage(
+		LveDevice& device,
+		VkFormat format,
+		VkExtent2D extent,
+		VkImageUsageFlags usage,
+		VkMemoryPropertyFlags memoryProperties,
+		VkImageAspectFlags aspect) {
+		LveAttachmentImage attachment{};
+
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.extent = { extent.width, extent.height, 1 };
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.format = format;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageInfo.usage = usage;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		device.createImageWithInfo(imageInfo, memoryProperties, attachment.image, attachment.memory);
+
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = attachment.image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = format;
+		viewInfo.subresourceRange = { aspect, 0, 1, 0, 1 };
+		if (vkCreateImageView(device.device(), &viewInfo, nullptr, &attachment.view) != VK_SUCCESS) {
+			destroyAttachmentImage(device, attachment);
+			throw std::runtime_error("Failed to create attachment image view!");
+		}
+		return attachment;
+	}
+
+	LveAttachmentImage createTransientDepthImage(LveDevice& device, VkFormat format, VkExtent2D extent) {
+		VkMemoryPropertyFlags memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		if (device.hasMemoryType(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)) {
+			memoryProperties |= VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+		}
+		return createAttachmentImage(
+			device,
+			format,
+			extent,
+			VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT,
+			memoryProperties,
+			VK_IMAGE_ASPECT_DEPTH_BIT);
+	}
+
+	void destroyAttachmentImage(LveDevice& device, LveAttachmentImage& attachment) {
+		vkDestroyImageView(device.device(), attachment.view, nullptr);
+		vkDestroyImage(device.device(), attachment.image, nullptr);
+		vkFreeMemory(device.device(), attachment.memory, nullptr);
+		attachment = {};
+	}
+}
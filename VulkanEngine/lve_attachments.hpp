@@ -0,0 +1,31 @@
+#pragma once
+
+#include "lve_device.hpp"
+
+namespace lve {
+
+	// An image with its memory and a view of the whole image, as used for framebuffer attachments
+	struct LveAttachmentImage {
+		VkImage image = VK_NULL_HANDLE;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkImageView view = VK_NULL_HANDLE;
+	};
+
+	// Creates the render pass shared by the swap chain and the offscreen targets: a stored color attachment
+	// ending in colorFinalLayout and a transient depth attachment, see lve_attachments.cpp
+	VkRenderPass createColorDepthRenderPass(
+		LveDevice& device, VkFormat colorFormat, VkFormat depthFormat, VkImageLayout colorFinalLayout);
+
+	// Creates a single sample 2D image with one mip level and its view
+	LveAttachmentImage createAttachmentImage(
+		LveDevice& device,
+		VkFormat format,
+		VkExtent2D extent,
+		VkImageUsageFlags usage,
+		VkMemoryPropertyFlags memoryProperties,
+		VkImageAspectFlags aspect);
+	// Creates the depth buffer of a color and depth render pass, shared by every frame in flight
+	LveAttachmentImage createTransientDepthImage(LveDevice& device, VkFormat format, VkExtent2D extent);
+	// Destroys the image, its view and memory and resets the handles, null handles are ignored
+	void destroyAttachmentImage(LveDevice& device, LveAttachmentImage& attachment);
+}
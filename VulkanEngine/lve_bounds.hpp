@@ -0,0 +1,86 @@
+#pragma once
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace lve {
+
+	// Axis aligned bounding box, empty until the first point is added
+	struct BoundingBox {
+		glm::vec3 min{ std::numeric_limits<float>::max() };
+		glm::vec3 max{ -std::numeric_limits<float>::max() };
+
+		bool isValid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+		glm::vec3 center() const { return (min + max) * 0.5f; }
+		glm::vec3 extents() const { return (max - min) * 0.5f; }
+
+		void expand(const glm::vec3& point) {
+			min = glm::min(min, point);
+			max = glm::max(max, point);
+		}
+
+		void expand(const BoundingBox& other) {
+			min = glm::min(min, other.min);
+			max = glm::max(max, other.max);
+		}
+
+		bool contains(const BoundingBox& other) const {
+			return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z &&
+				max.x >= other.max.x && max.y >= other.max.y && max.z >= other.max.z;
+		}
+
+		bool overlaps(const BoundingBox& other) const {
+			return min.x <= other.max.x && min.y <= other.max.y && min.z <= other.max.z &&
+				max.x >= other.min.x && max.y >= other.min.y && max.z >= other.min.z;
+		}
+
+		float surfaceArea() const {
+			const glm::vec3 d = max - min;
+			return 2.f * (d.x * d.y + d.y * d.z + d.z * d.x);
+		}
+
+		// Arvo's method, the result bounds the transformed box (not the transformed vertices)
+		BoundingBox transformed(const glm::mat4& transform) const {
+			const glm::vec3 c = glm::vec3(transform * glm::vec4(center(), 1.f));
+			const glm::vec3 e = extents();
+			glm::vec3 worldExtents{};
+			for (int i = 0; i < 3; i++) {
+				worldExtents[i] =
+					glm::abs(transform[0][i]) * e.x +
+					glm::abs(transform[1][i]) * e.y +
+					glm::abs(transform[2][i]) * e.z;
+			}
+			return BoundingBox{ c - worldExtents, c + worldExtents };
+		}
+	};
+
+	struct BoundingSphere {
+		glm::vec3 center{};
+		float radius = 0.f;
+
+		// scale is the per axis scale baked into transform, the largest axis bounds the radius
+		BoundingSphere transformed(const glm::mat4& transform, const glm::vec3& scale) const {
+			const glm::vec3 absScale = glm::abs(scale);
+			const float maxScale = glm::max(absScale.x, glm::max(absScale.y, absScale.z));
+			return BoundingSphere{ glm::vec3(transform * glm::vec4(center, 1.f)), radius * maxScale };
+		}
+	};
+
+	// Position only triangle mesh rasterized on the CPU by the occlusion culler
+	struct OccluderMesh {
+		std::vector<glm::vec3> positions{};
+		std::vector<uint32_t> indices{};
+	};
+
+	struct Ray {
+		glm::vec3 origin{};
+		glm::vec3 direction{ 0.f, 0.f, 1.f }; // expected to be normalized
+	};
+}
@@ -36,6 +36,8 @@ namespace lve {
 		projectionMatrix[3][0] = -(right + left) / (right - left);
 		projectionMatrix[3][1] = -(bottom + top) / (bottom - top);
 		projectionMatrix[3][2] = -near / (far - near);
+		nearPlane = near;
+		farPlane = far;
 	}
 
 	/**
@@ -57,6 +59,8 @@ namespace lve {
 		projectionMatrix[2][2] = far / (far - near);
 		projectionMatrix[2][3] = 1.f;
 		projectionMatrix[3][2] = -(far * near) / (far - near);
+		nearPlane = near;
+		farPlane = far;
 	}
 
 	/**
@@ -115,6 +119,25 @@ namespace lve {
 		setViewDirection(position, target - position, up);
 	}
 
+	/**
+	 * @brief Builds a world space ray through a point on the screen.
+	 *
+	 * Unprojects the point on the near and far planes with the inverse of projection * view, so this
+	 * works for both perspective and orthographic projections.
+	 *
+	 * @param ndcX The x coordinate in normalized device coordinates, -1 is the left edge.
+	 * @param ndcY The y coordinate in normalized device coordinates, -1 is the top edge.
+	 * @return A ray starting on the near plane with a normalized direction.
+	 */
+	Ray LveCamera::getPickRay(float ndcX, float ndcY) const {
+		const glm::mat4 inverseViewProjection = glm::inverse(projectionMatrix * viewMatrix);
+		glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, 0.f, 1.f);
+		glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, 1.f, 1.f);
+		nearPoint /= nearPoint.w;
+		farPoint /= farPoint.w;
+		return Ray{ glm::vec3(nearPoint), glm::normalize(glm::vec3(farPoint - nearPoint)) };
+	}
+
 	/**
 	 * @brief Sets the camera's view matrix based on yaw, pitch, and roll.
 	 *
@@ -5,6 +5,8 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 
+#include "lve_bounds.hpp"
+
 namespace lve {
 
     class LveCamera {
@@ -23,10 +25,18 @@ namespace lve {
         const glm::mat4& getProjection() const { return projectionMatrix; }
         const glm::mat4& getView() const { return viewMatrix; }
         const glm::mat4& getInverseView() const { return inverseViewMatrix; }
+        // view space depth range of the current projection
+        float getNear() const { return nearPlane; }
+        float getFar() const { return farPlane; }
+
+        // ray from the near plane through a point given in normalized device coordinates
+        Ray getPickRay(float ndcX, float ndcY) const;
 
     private:
         glm::mat4 projectionMatrix{ 1.f };
         glm::mat4 viewMatrix{ 1.f };
         glm::mat4 inverseViewMatrix{ 1.f };
+        float nearPlane = 0.1f;
+        float farPlane = 1000.f;
     };
 } 
\ No newline at end of file
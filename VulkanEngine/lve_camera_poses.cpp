@@ -0,0 +1,63 @@
+/**
+ * @file lve_camera_poses.cpp
+ * @brief Reader of the camera pose files rendered by the batch renderer.
+ */
+
+#include "lve_camera_poses.hpp"
+
+// std
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace lve {
+
+	/**
+	 * @brief Reads the camera poses of a text file.
+	 *
+	 * The format follows the text scene description, one statement per line and `#` starting a comment:
+	 *
+	 *     pose [position x y z] [rotation x y z]
+	 *
+	 * Omitted properties keep the start pose of the interactive application.
+	 *
+	 * @param filepath Path of the pose file.
+	 * @return The poses in file order.
+	 * @throws std::runtime_error On IO failures or syntax errors, reporting the offending line.
+	 */
+	std::vector<CameraPose> loadCameraPoses(const std::string& filepath) {
+		std::ifstream input{ filepath };
+		if (!input.is_open()) {
+			throw std::runtime_error("failed to open camera pose file: " + filepath);
+		}
+
+		std::vector<CameraPose> poses;
+		std::string line;
+		int lineNumber = 0;
+		while (std::getline(input, line)) {
+			lineNumber++;
+			auto fail = [&](const std::string& message) {
+				throw std::runtime_error(filepath + ":" + std::to_string(lineNumber) + ": " + message);
+			};
+
+			std::istringstream tokens{ line.substr(0, line.find('#')) };
+			std::string keyword;
+			if (!(tokens >> keyword)) continue;
+			if (keyword != "pose") fail("unknown statement '" + keyword + "'");
+
+			auto readVec3 = [&](glm::vec3& value, const std::string& name) {
+				if (!(tokens >> value.x >> value.y >> value.z)) fail("expected three numbers after '" + name + "'");
+			};
+
+			CameraPose pose{};
+			std::string property;
+			while (tokens >> property) {
+				if (property == "position") readVec3(pose.position, property);
+				else if (property == "rotation") readVec3(pose.rotation, property);
+				else fail("unknown pose property '" + property + "'");
+			}
+			poses.push_back(pose);
+		}
+		return poses;
+	}
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <string>
+#include <vector>
+
+namespace lve {
+
+	// camera placement in the convention of LveCamera::setViewYXZ, rotations in radians
+	struct CameraPose {
+		glm::vec3 position{ 0.f, 0.f, -2.5f };
+		glm::vec3 rotation{ 0.f };
+	};
+
+	// Reads a camera pose file, one `pose [position x y z] [rotation x y z]` per line, throws on syntax errors
+	std::vector<CameraPose> loadCameraPoses(const std::string& filepath);
+}
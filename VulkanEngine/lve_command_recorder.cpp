@@ -0,0 +1,198 @@
+/**
+ * @file lve_command_recorder.cpp
+ * @brief Implementation of the LveCommandRecorder class for recording render pass contents on several threads.
+ *
+ * This file contains the creation of the per frame, per thread command pools, the allocation and inheritance
+ * setup of secondary command buffers, and their execution from the frame's primary command buffer.
+ */
+
+#include "lve_command_recorder.hpp"
+
+// std
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+	/**
+	 * @brief Creates one transient command pool per frame in flight and thread slot.
+	 *
+	 * @param device The device the pools are created on, using its graphics queue family.
+	 * @param jobSystem The job system parallel recordings run on.
+	 * @param framesInFlight Number of frames the renderer keeps in flight.
+	 * @throws std::runtime_error If a command pool cannot be created.
+	 */
+	LveCommandRecorder::LveCommandRecorder(LveDevice& device, LveJobSystem& jobSystem, uint32_t framesInFlight)
+		: lveDevice{ device }, jobSystem{ jobSystem }, threadSlotCount{ jobSystem.getWorkerCount() + 1 } {
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = lveDevice.findPhysicalQueueFamilies().graphicsFamily;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+		frames.resize(framesInFlight);
+		for (auto& slots : frames) {
+			slots.resize(threadSlotCount);
+			for (auto& slot : slots) {
+				if (vkCreateCommandPool(lveDevice.device(), &poolInfo, nullptr, &slot.commandPool) != VK_SUCCESS) {
+					throw std::runtime_error("Failed to create secondary command pool!");
+				}
+			}
+		}
+	}
+
+	/**
+	 * @brief Destroys the command pools, freeing all secondaries allocated from them.
+	 */
+	LveCommandRecorder::~LveCommandRecorder() {
+		for (auto& slots : frames) {
+			for (auto& slot : slots) {
+				vkDestroyCommandPool(lveDevice.device(), slot.commandPool, nullptr);
+			}
+		}
+	}
+
+	/**
+	 * @brief Prepares recording for the renderer's current frame.
+	 *
+	 * @param renderer The renderer, between beginFrame and beginSwapChainRenderPass.
+	 *
+	 * Resetting a pool returns all its command buffers to the initial state at once, which is cheaper than resetting
+	 * them one by one.
+	 */
+	void LveCommandRecorder::beginFrame(const LveRenderer& renderer) {
+		beginFrame(
+			renderer.getFrameIndex(),
+			renderer.getSwapChainRenderPass(),
+			renderer.getCurrentFrameBuffer(),
+			renderer.getSwapChainExtent());
+	}
+
+	/**
+	 * @brief Resets the pools of a frame whose secondaries render into the given framebuffer.
+	 *
+	 * @param frameIndex The renderer's current frame index.
+	 * @param frameRenderPass The render pass the secondaries are executed in.
+	 * @param frameFramebuffer The framebuffer the render pass is begun on.
+	 * @param frameExtent The viewport and scissor extent the secondaries start with.
+	 */
+	void LveCommandRecorder::beginFrame(
+		int frameIndex, VkRenderPass frameRenderPass, VkFramebuffer frameFramebuffer, VkExtent2D frameExtent) {
+		assert(recorded.empty() && "Secondaries of the previous frame were never executed.");
+
+		currentFrameIndex = frameIndex;
+		renderPass = frameRenderPass;
+		framebuffer = frameFramebuffer;
+		extent = frameExtent;
+
+		for (auto& slot : frames[currentFrameIndex]) {
+			vkResetCommandPool(lveDevice.device(), slot.commandPool, 0);
+			slot.usedCount = 0;
+		}
+	}
+
+	/**
+	 * @brief Records a single secondary command buffer on the calling thread.
+	 *
+	 * @param recordFunction Records the commands, receiving the secondary in the recording state.
+	 *
+	 * Must not be called while a parallel recording is in progress, it uses the first thread slot.
+	 */
+	void LveCommandRecorder::record(const RecordFunction& recordFunction) {
+		assert(currentFrameIndex >= 0 && "Cannot record before beginFrame.");
+
+		VkCommandBuffer commandBuffer = beginSecondary(frames[currentFrameIndex][0]);
+		recordFunction(commandBuffer);
+		endSecondary(commandBuffer);
+		recorded.push_back(commandBuffer);
+	}
+
+	/**
+	 * @brief Records one secondary command buffer per task on the job system.
+	 *
+	 * @param taskCount Number of tasks, at most getThreadSlotCount().
+	 * @param recordFunction Records the commands of one task, called concurrently for different tasks.
+	 */
+	void LveCommandRecorder::recordParallel(uint32_t taskCount, const ParallelRecordFunction& recordFunction) {
+		assert(currentFrameIndex >= 0 && "Cannot record before beginFrame.");
+		assert(taskCount <= threadSlotCount && "More recording tasks than thread slots.");
+
+		auto& slots = frames[currentFrameIndex];
+		parallelRecorded.assign(taskCount, VK_NULL_HANDLE);
+		jobSystem.parallelFor(taskCount, [&](uint32_t taskIndex) {
+			VkCommandBuffer commandBuffer = beginSecondary(slots[taskIndex]);
+			recordFunction(taskIndex, commandBuffer);
+			endSecondary(commandBuffer);
+			parallelRecorded[taskIndex] = commandBuffer;
+		});
+		recorded.insert(recorded.end(), parallelRecorded.begin(), parallelRecorded.end());
+	}
+
+	/**
+	 * @brief Executes all secondaries recorded since the last call.
+	 *
+	 * @param primaryCommandBuffer The frame's primary, inside a render pass begun with secondary contents.
+	 */
+	void LveCommandRecorder::executeSecondaries(VkCommandBuffer primaryCommandBuffer) {
+		if (!recorded.empty()) {
+			vkCmdExecuteCommands(primaryCommandBuffer, static_cast<uint32_t>(recorded.size()), recorded.data());
+		}
+		recorded.clear();
+	}
+
+	/**
+	 * @brief Takes the next free secondary of a slot, allocating one if needed, and begins it.
+	 *
+	 * @param slot The thread slot of the current frame, only ever used by one thread at a time.
+	 * @return The secondary in the recording state, with viewport and scissor set.
+	 * @throws std::runtime_error If allocation or beginning the command buffer fails.
+	 */
+	VkCommandBuffer LveCommandRecorder::beginSecondary(ThreadSlot& slot) {
+		if (slot.usedCount == slot.commandBuffers.size()) {
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandPool = slot.commandPool;
+			allocInfo.commandBufferCount = 1;
+
+			VkCommandBuffer commandBuffer;
+			if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to allocate secondary command buffer!");
+			}
+			slot.commandBuffers.push_back(commandBuffer);
+		}
+		VkCommandBuffer commandBuffer = slot.commandBuffers[slot.usedCount++];
+
+		VkCommandBufferInheritanceInfo inheritanceInfo{};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = renderPass;
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = framebuffer;
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to begin recording secondary command buffer!");
+		}
+
+		// dynamic state is not inherited from the primary
+		VkViewport viewport{};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = static_cast<float>(extent.width);
+		viewport.height = static_cast<float>(extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		VkRect2D scissor{ {0, 0}, extent };
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+		return commandBuffer;
+	}
+
+	void LveCommandRecorder::endSecondary(VkCommandBuffer commandBuffer) {
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to record secondary command buffer!");
+		}
+	}
+}
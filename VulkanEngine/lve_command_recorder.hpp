@@ -0,0 +1,79 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_job_system.hpp"
+#include "lve_renderer.hpp"
+
+// std
+#include <functional>
+#include <vector>
+
+namespace lve {
+
+	/**
+	 * Records the contents of the swap chain render pass into secondary command buffers, optionally in parallel.
+	 *
+	 * Every frame in flight owns one transient command pool per thread slot, slot i being used by task i of a
+	 * parallel recording, so no two threads ever allocate from or record into the same pool. Pools are reset as a
+	 * whole when their frame begins again, after the renderer has waited for that frame's previous submission.
+	 *
+	 * Secondaries inherit the render pass, subpass and framebuffer of the current frame and start with the swap
+	 * chain viewport and scissor already set. They are executed in recording order, parallel tasks in task order,
+	 * so draw order across a split draw list is preserved. The render pass must be begun with
+	 * `VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS` while secondaries are used.
+	 */
+	class LveCommandRecorder {
+	public:
+		using RecordFunction = std::function<void(VkCommandBuffer commandBuffer)>;
+		using ParallelRecordFunction = std::function<void(uint32_t taskIndex, VkCommandBuffer commandBuffer)>;
+
+		LveCommandRecorder(LveDevice& device, LveJobSystem& jobSystem, uint32_t framesInFlight);
+		~LveCommandRecorder();
+
+		LveCommandRecorder(const LveCommandRecorder&) = delete;
+		LveCommandRecorder& operator=(const LveCommandRecorder&) = delete;
+
+		// upper bound for the task count of recordParallel, one slot per worker plus the calling thread
+		uint32_t getThreadSlotCount() const { return threadSlotCount; }
+
+		// Resets the pools of the renderer's current frame, call after LveRenderer::beginFrame
+		void beginFrame(const LveRenderer& renderer);
+		// Same for a render pass other than the swap chain's, like an offscreen scene target
+		void beginFrame(int frameIndex, VkRenderPass renderPass, VkFramebuffer framebuffer, VkExtent2D extent);
+
+		// Records one secondary on the calling thread
+		void record(const RecordFunction& recordFunction);
+		// Records one secondary per task, spread over the job system
+		void recordParallel(uint32_t taskCount, const ParallelRecordFunction& recordFunction);
+
+		// Executes the secondaries recorded since the last call in the primary's current render pass
+		void executeSecondaries(VkCommandBuffer primaryCommandBuffer);
+
+		uint32_t getRecordedCount() const { return static_cast<uint32_t>(recorded.size()); }
+
+	private:
+		struct ThreadSlot {
+			VkCommandPool commandPool = VK_NULL_HANDLE;
+			// reused after every pool reset, grown when a frame needs more
+			std::vector<VkCommandBuffer> commandBuffers;
+			uint32_t usedCount = 0;
+		};
+
+		VkCommandBuffer beginSecondary(ThreadSlot& slot);
+		void endSecondary(VkCommandBuffer commandBuffer);
+
+		LveDevice& lveDevice;
+		LveJobSystem& jobSystem;
+		uint32_t threadSlotCount;
+
+		// frames[frameIndex][slot]
+		std::vector<std::vector<ThreadSlot>> frames;
+		int currentFrameIndex = -1;
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+		VkFramebuffer framebuffer = VK_NULL_HANDLE;
+		VkExtent2D extent{};
+
+		std::vector<VkCommandBuffer> recorded;
+		std::vector<VkCommandBuffer> parallelRecorded;
+	};
+}
@@ -2,12 +2,29 @@
 
 // std headers
 #include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <set>
 #include <unordered_set>
 
 namespace lve {
 
+    // Prefix of the pipeline cache file, followed by the driver's cache data. Drivers reject foreign data on their
+    // own, but a few crash on it, so a file from another device or driver version is never handed to them.
+    struct PipelineCacheFileHeader {
+        char magic[4];
+        uint32_t fileVersion;
+        uint32_t vendorID;
+        uint32_t deviceID;
+        uint32_t driverVersion;
+        uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+        uint64_t dataSize;
+    };
+
+    static constexpr char PIPELINE_CACHE_MAGIC[4] = { 'L', 'V', 'P', 'C' };
+    static constexpr uint32_t PIPELINE_CACHE_FILE_VERSION = 1;
+
     // local callback functions
     static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
         VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
@@ -48,16 +65,35 @@ namespace lve {
     }
 
     // class member functions
-    LveDevice::LveDevice(LveWindow& window) : window{ window } {
+    LveDevice::LveDevice(LveWindow& window) : window{ &window } {
         createInstance();
         setupDebugMessenger();
         createSurface();
         pickPhysicalDevice();
         createLogicalDevice();
         createCommandPool();
+        createPipelineCache();
+    }
+
+    // Without a window GLFW is never initialized, no surface or swap chain extension is requested and the present
+    // queue is the graphics queue. Software drivers like Mesa lavapipe qualify, so this runs without a display.
+    LveDevice::LveDevice() {
+        createInstance();
+        setupDebugMessenger();
+        pickPhysicalDevice();
+        createLogicalDevice();
+        createCommandPool();
+        createPipelineCache();
     }
 
     LveDevice::~LveDevice() {
+        try {
+            savePipelineCache();
+        } catch (const std::exception& e) {
+            // a missing cache only costs the next startup time
+            std::cerr << e.what() << std::endl;
+        }
+        vkDestroyPipelineCache(device_, pipelineCache, nullptr);
         vkDestroyCommandPool(device_, commandPool, nullptr);
         vkDestroyDevice(device_, nullptr);
 
@@ -65,7 +101,9 @@ namespace lve {
             DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
         }
 
-        vkDestroySurfaceKHR(instance, surface_, nullptr);
+        if (surface_ != VK_NULL_HANDLE) {
+            vkDestroySurfaceKHR(instance, surface_, nullptr);
+        }
         vkDestroyInstance(instance, nullptr);
     }
 
@@ -155,8 +193,29 @@ namespace lve {
             queueCreateInfos.push_back(queueCreateInfo);
         }
 
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
         VkPhysicalDeviceFeatures deviceFeatures = {};
         deviceFeatures.samplerAnisotropy = VK_TRUE;
+        // used by the GPU driven renderer, which falls back to CPU culling without it
+        deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+        enabledFeatures = deviceFeatures;
+
+        uint32_t extensionCount;
+        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+
+        enabledExtensions = getRequiredDeviceExtensions();
+        for (const char* optional : optionalDeviceExtensions) {
+            for (const auto& extension : availableExtensions) {
+                if (strcmp(optional, extension.extensionName) == 0) {
+                    enabledExtensions.push_back(optional);
+                    break;
+                }
+            }
+        }
 
         VkDeviceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -165,8 +224,8 @@ namespace lve {
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
         createInfo.pEnabledFeatures = &deviceFeatures;
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+        createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
         // might not really be necessary anymore because device specific validation layers
         // have been deprecated
@@ -184,6 +243,20 @@ namespace lve {
 
         vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
         vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+
+        if (isExtensionEnabled(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME)) {
+            cmdDrawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(
+                vkGetDeviceProcAddr(device_, "vkCmdDrawIndexedIndirectCountKHR"));
+        }
+    }
+
+    bool LveDevice::isExtensionEnabled(const char* extensionName) const {
+        for (const char* extension : enabledExtensions) {
+            if (strcmp(extension, extensionName) == 0) {
+                return true;
+            }
+        }
+        return false;
     }
 
     void LveDevice::createCommandPool() {
@@ -200,15 +273,113 @@ namespace lve {
         }
     }
 
-    void LveDevice::createSurface() { window.createWindowSurface(instance, &surface_); }
+    void LveDevice::createPipelineCache() {
+        std::vector<char> initialData;
+        std::ifstream file{ PIPELINE_CACHE_PATH, std::ios::binary | std::ios::ate };
+        if (file.is_open()) {
+            size_t fileSize = static_cast<size_t>(file.tellg());
+            file.seekg(0);
+
+            PipelineCacheFileHeader header{};
+            VkPipelineCacheHeaderVersionOne driverHeader{};
+            bool valid = fileSize >= sizeof(header) + sizeof(driverHeader) &&
+                file.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+                std::memcmp(header.magic, PIPELINE_CACHE_MAGIC, sizeof(PIPELINE_CACHE_MAGIC)) == 0 &&
+                header.fileVersion == PIPELINE_CACHE_FILE_VERSION &&
+                header.vendorID == properties.vendorID &&
+                header.deviceID == properties.deviceID &&
+                header.driverVersion == properties.driverVersion &&
+                std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0 &&
+                header.dataSize == fileSize - sizeof(header);
+            if (valid) {
+                initialData.resize(static_cast<size_t>(header.dataSize));
+                valid = static_cast<bool>(file.read(initialData.data(), initialData.size()));
+            }
+            if (valid) {
+                // the driver's own header has to agree as well
+                std::memcpy(&driverHeader, initialData.data(), sizeof(driverHeader));
+                valid = driverHeader.headerSize >= sizeof(driverHeader) &&
+                    driverHeader.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+                    driverHeader.vendorID == properties.vendorID &&
+                    driverHeader.deviceID == properties.deviceID &&
+                    std::memcmp(driverHeader.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+            }
+            if (!valid) {
+                std::cout << "pipeline cache: " << PIPELINE_CACHE_PATH << " is stale or damaged, starting cold" << std::endl;
+                initialData.clear();
+            }
+        }
+
+        VkPipelineCacheCreateInfo cacheInfo{};
+        cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        cacheInfo.initialDataSize = initialData.size();
+        cacheInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+        if (vkCreatePipelineCache(device_, &cacheInfo, nullptr, &pipelineCache) != VK_SUCCESS) {
+            // some drivers refuse data that passed the checks above, an empty cache is always accepted
+            cacheInfo.initialDataSize = 0;
+            cacheInfo.pInitialData = nullptr;
+            initialData.clear();
+            if (vkCreatePipelineCache(device_, &cacheInfo, nullptr, &pipelineCache) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create pipeline cache!");
+            }
+        }
+
+        pipelineCacheWarm = !initialData.empty();
+        if (pipelineCacheWarm) {
+            std::cout << "pipeline cache: loaded " << initialData.size() << " bytes" << std::endl;
+        }
+    }
+
+    void LveDevice::savePipelineCache() {
+        size_t dataSize = 0;
+        if (vkGetPipelineCacheData(device_, pipelineCache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0) {
+            return;
+        }
+        std::vector<char> data(dataSize);
+        if (vkGetPipelineCacheData(device_, pipelineCache, &dataSize, data.data()) != VK_SUCCESS) {
+            throw std::runtime_error("failed to read pipeline cache data!");
+        }
+
+        PipelineCacheFileHeader header{};
+        std::memcpy(header.magic, PIPELINE_CACHE_MAGIC, sizeof(PIPELINE_CACHE_MAGIC));
+        header.fileVersion = PIPELINE_CACHE_FILE_VERSION;
+        header.vendorID = properties.vendorID;
+        header.deviceID = properties.deviceID;
+        header.driverVersion = properties.driverVersion;
+        std::memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+        header.dataSize = dataSize;
+
+        // readers only ever see the old file or the complete new one
+        const std::string tempPath = std::string{ PIPELINE_CACHE_PATH } + ".tmp";
+        {
+            std::ofstream output{ tempPath, std::ios::binary | std::ios::trunc };
+            if (!output.is_open()) {
+                throw std::runtime_error("failed to create pipeline cache file: " + tempPath);
+            }
+            output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            output.write(data.data(), dataSize);
+            if (!output.flush()) {
+                throw std::runtime_error("failed to write pipeline cache file: " + tempPath);
+            }
+        }
+        std::error_code error;
+        std::filesystem::rename(tempPath, PIPELINE_CACHE_PATH, error);
+        if (error) {
+            std::filesystem::remove(tempPath, error);
+            throw std::runtime_error(std::string{ "failed to replace pipeline cache file: " } + PIPELINE_CACHE_PATH);
+        }
+    }
+
+    void LveDevice::createSurface() { window->createWindowSurface(instance, &surface_); }
 
     bool LveDevice::isDeviceSuitable(VkPhysicalDevice device) {
         QueueFamilyIndices indices = findQueueFamilies(device);
 
         bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-        bool swapChainAdequate = false;
-        if (extensionsSupported) {
+        // nothing is presented by a headless device
+        bool swapChainAdequate = isHeadless();
+        if (extensionsSupported && !isHeadless()) {
             SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
             swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
         }
@@ -268,11 +439,13 @@ namespace lve {
     }
 
     std::vector<const char*> LveDevice::getRequiredExtensions() {
-        uint32_t glfwExtensionCount = 0;
-        const char** glfwExtensions;
-        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-        std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        std::vector<const char*> extensions;
+        if (!isHeadless()) {
+            uint32_t glfwExtensionCount = 0;
+            const char** glfwExtensions;
+            glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+            extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        }
 
         if (enableValidationLayers) {
             extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -304,6 +477,13 @@ namespace lve {
         }
     }
 
+    std::vector<const char*> LveDevice::getRequiredDeviceExtensions() const {
+        if (isHeadless()) {
+            return {};
+        }
+        return deviceExtensions;
+    }
+
     bool LveDevice::checkDeviceExtensionSupport(VkPhysicalDevice device) {
         uint32_t extensionCount;
         vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
@@ -315,6 +495,7 @@ namespace lve {
             &extensionCount,
             availableExtensions.data());
 
+        auto deviceExtensions = getRequiredDeviceExtensions();
         std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
 
         for (const auto& extension : availableExtensions) {
@@ -340,7 +521,12 @@ namespace lve {
                 indices.graphicsFamilyHasValue = true;
             }
             VkBool32 presentSupport = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+            if (isHeadless()) {
+                // never presented to, the graphics queue stands in for the present queue
+                presentSupport = (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+            } else {
+                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+            }
             if (queueFamily.queueCount > 0 && presentSupport) {
                 indices.presentFamily = i;
                 indices.presentFamilyHasValue = true;
@@ -411,6 +597,25 @@ namespace lve {
         throw std::runtime_error("failed to find suitable memory type!");
     }
 
+    bool LveDevice::hasMemoryType(VkMemoryPropertyFlags properties) {
+        VkPhysicalDeviceMemoryProperties memProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+        for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+            if ((memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint32_t LveDevice::getTimestampValidBits() {
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+        return queueFamilies[findPhysicalQueueFamilies().graphicsFamily].timestampValidBits;
+    }
+
     void LveDevice::createBuffer(
         VkDeviceSize size,
         VkBufferUsageFlags usage,
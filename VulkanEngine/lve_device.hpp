@@ -30,7 +30,12 @@ namespace lve {
         const bool enableValidationLayers = true;
 #endif
 
+        // driver pipeline cache, loaded at startup and saved when the device is destroyed
+        static constexpr const char* PIPELINE_CACHE_PATH = "pipeline_cache.bin";
+
         LveDevice(LveWindow& window);
+        // headless device without a surface or present support, for offscreen rendering without a display
+        LveDevice();
         ~LveDevice();
 
         // Not copyable or movable
@@ -42,11 +47,16 @@ namespace lve {
         VkCommandPool getCommandPool() { return commandPool; }
         VkDevice device() { return device_; }
         VkSurfaceKHR surface() { return surface_; }
+        bool isHeadless() const { return window == nullptr; }
         VkQueue graphicsQueue() { return graphicsQueue_; }
         VkQueue presentQueue() { return presentQueue_; }
 
         SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
         uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+        // true if any memory type has all the given properties, like lazily allocated memory on tiled GPUs
+        bool hasMemoryType(VkMemoryPropertyFlags properties);
+        // bits of the graphics queue's timestamps that are valid, 0 if it cannot write timestamps
+        uint32_t getTimestampValidBits();
         QueueFamilyIndices findPhysicalQueueFamilies() { return findQueueFamilies(physicalDevice); }
         VkFormat findSupportedFormat(
             const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
@@ -70,6 +80,19 @@ namespace lve {
             VkImage& image,
             VkDeviceMemory& imageMemory);
 
+        // optional capabilities, detected when the logical device is created
+        const VkPhysicalDeviceFeatures& getEnabledFeatures() const { return enabledFeatures; }
+        bool isExtensionEnabled(const char* extensionName) const;
+        // null when VK_KHR_draw_indirect_count is not available
+        PFN_vkCmdDrawIndexedIndirectCountKHR getCmdDrawIndexedIndirectCount() const { return cmdDrawIndexedIndirectCount; }
+
+        // shared by every pipeline created on this device
+        VkPipelineCache getPipelineCache() const { return pipelineCache; }
+        // true if the cache was seeded from a file written by this device and driver version
+        bool isPipelineCacheWarm() const { return pipelineCacheWarm; }
+        // writes the cache to PIPELINE_CACHE_PATH through a temporary file, so a crash never leaves a torn cache
+        void savePipelineCache();
+
         VkPhysicalDeviceProperties properties;
 
     private:
@@ -79,10 +102,12 @@ namespace lve {
         void pickPhysicalDevice();
         void createLogicalDevice();
         void createCommandPool();
+        void createPipelineCache();
 
         // helper functions
         bool isDeviceSuitable(VkPhysicalDevice device);
         std::vector<const char*> getRequiredExtensions();
+        std::vector<const char*> getRequiredDeviceExtensions() const;
         bool checkValidationLayerSupport();
         QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device);
         void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
@@ -93,16 +118,24 @@ namespace lve {
         VkInstance instance;
         VkDebugUtilsMessengerEXT debugMessenger;
         VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-        LveWindow& window;
+        LveWindow* window = nullptr; // null for a headless device
         VkCommandPool commandPool;
 
         VkDevice device_;
-        VkSurfaceKHR surface_;
+        VkSurfaceKHR surface_ = VK_NULL_HANDLE;
         VkQueue graphicsQueue_;
         VkQueue presentQueue_;
 
         const std::vector<const char*> validationLayers = { "VK_LAYER_KHRONOS_validation" };
+        // not required by a headless device
         const std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+        // enabled when supported, features relying on them check isExtensionEnabled()
+        const std::vector<const char*> optionalDeviceExtensions = { VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME };
+        std::vector<const char*> enabledExtensions;
+        VkPhysicalDeviceFeatures enabledFeatures{};
+        PFN_vkCmdDrawIndexedIndirectCountKHR cmdDrawIndexedIndirectCount = nullptr;
+        VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+        bool pipelineCacheWarm = false;
     };
 
 }  // namespace lve
\ No newline at end of file
@@ -2,16 +2,22 @@
 
 #include "lve_camera.hpp"
 #include "lve_game_object.hpp"
+#include "lve_scene_bvh.hpp"
 
 // lib
 #include <vulkan/vulkan.h>
 
 namespace lve {
 
-#define MAX_LIGHTS 10
+// capacity of the per frame light buffer, further lights are not shaded
+#define MAX_LIGHTS 4096
 
+	class LveCommandRecorder;
+	class LveGpuProfiler;
+
+	// element of the light storage buffer (std430)
 	struct PointLight {
-		glm::vec4 position{}; // ignore w
+		glm::vec4 position{}; // w is the range of influence
 		glm::vec4 color{}; // w is intensity
 	};
 
@@ -20,8 +26,8 @@ namespace lve {
 		glm::mat4 view{ 1.f };
 		glm::mat4 inverseView{ 1.f };
 		glm::vec4 ambientLightColor{ 1.f, 1.f, 1.f, .02f }; // w is intensity
-		PointLight pointLights[MAX_LIGHTS];
-		int numLights;
+		glm::uvec4 clusterCounts{ 0 }; // clusters along x, y and depth, w is the number of lights
+		glm::vec4 clusterDepth{ 0.f }; // x is the first slice's near depth, y the slices per unit of log depth
 	};
 
 	struct FrameInfo {
@@ -31,5 +37,11 @@ namespace lve {
 		LveCamera& camera;
 		VkDescriptorSet globalDescriptorSet;
 		LveGameObject::Map& gameObjects;
+		// optional, culling falls back to a linear pass without it. Systems moving objects mark them moved.
+		LveSceneBvh* sceneBvh = nullptr;
+		// optional, systems that support it record their draws into secondaries instead of commandBuffer
+		LveCommandRecorder* commandRecorder = nullptr;
+		// optional, systems time their GPU work in named zones with it
+		LveGpuProfiler* gpuProfiler = nullptr;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,52 @@
+/**
+ * @file lve_frame_pacer.cpp
+ * @brief Implementation of the LveFramePacer class, a frame rate limiter.
+ *
+ * This file contains the frame schedule and the wait for the next frame, which sleeps for most of it and spins
+ * for the remainder since sleeps overshoot by up to the scheduler's timer resolution.
+ */
+
+#include "lve_frame_pacer.hpp"
+
+// std
+#include <thread>
+
+namespace lve {
+
+	namespace {
+		// the last part of a wait is spent spinning, sleeps may overshoot by about this much
+		constexpr std::chrono::microseconds SPIN_DURATION{ 2000 };
+	}
+
+	/**
+	 * @brief Sets the frame rate frames are limited to.
+	 *
+	 * @param framesPerSecond The maximum frame rate, 0 or less removes the limit.
+	 */
+	void LveFramePacer::setTargetFrameRate(float framesPerSecond) {
+		targetFrameRate = framesPerSecond > 0.f ? framesPerSecond : 0.f;
+		frameInterval = targetFrameRate > 0.f
+			? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / targetFrameRate))
+			: Clock::duration{};
+		nextFrameStart = Clock::time_point{};
+	}
+
+	void LveFramePacer::waitForNextFrame() {
+		if (targetFrameRate <= 0.f) return;
+
+		auto now = Clock::now();
+		if (now > nextFrameStart + frameInterval) {
+			// first frame, or more than a frame late
+			nextFrameStart = now + frameInterval;
+			return;
+		}
+
+		if (nextFrameStart - now > SPIN_DURATION) {
+			std::this_thread::sleep_until(nextFrameStart - SPIN_DURATION);
+		}
+		while (Clock::now() < nextFrameStart) {
+			std::this_thread::yield();
+		}
+		nextFrameStart += frameInterval;
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+// std
+#include <chrono>
+
+namespace lve {
+
+	/**
+	 * Limits the frame rate by holding each frame back until its start time.
+	 *
+	 * Start times are spaced one frame interval apart rather than measured from the end of the previous wait, so
+	 * the average rate matches the target even when individual waits overshoot. A frame that starts more than one
+	 * interval late restarts the schedule instead of rushing the following frames to catch up.
+	 *
+	 * Waiting at the start of a frame, before input is sampled, moves the idle time in front of the input sample
+	 * instead of between the sample and the submission, which is what lowers latency compared to blocking in the
+	 * presentation engine.
+	 */
+	class LveFramePacer {
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		// 0 removes the limit
+		void setTargetFrameRate(float framesPerSecond);
+		float getTargetFrameRate() const { return targetFrameRate; }
+
+		// Blocks until the next frame may start, returns at once without a limit
+		void waitForNextFrame();
+
+	private:
+		float targetFrameRate = 0.f;
+		Clock::duration frameInterval{};
+		Clock::time_point nextFrameStart{};
+	};
+}
@@ -0,0 +1,196 @@
+/**
+ * @file lve_frame_readback.cpp
+ * @brief Implementation of the LveFrameReadback class, the staging ring reading rendered frames back to files.
+ *
+ * This file contains the staging buffer ring, the fence gated hand over of completed copies to the encoder
+ * threads and the accounting of written and dropped frames.
+ */
+
+#include "lve_frame_readback.hpp"
+
+#include "lve_image_writer.hpp"
+
+// std
+#include <chrono>
+#include <stdexcept>
+#include <string>
+
+namespace lve {
+
+	/**
+	 * @brief Creates the staging buffers and starts the encoder threads.
+	 *
+	 * @param device The device the staging buffers are allocated on.
+	 * @param renderer The renderer whose frames are captured.
+	 * @param slotCount Number of staging buffers. Frames in flight each hold one until they complete, the rest
+	 *        absorb encoding that is slower than rendering for a while.
+	 * @param encoderThreadCount Number of encoder threads, 0 for one per hardware thread minus one.
+	 * @throws std::runtime_error If there are not more slots than frames in flight.
+	 */
+	LveFrameReadback::LveFrameReadback(
+		LveDevice& device, LveHeadlessRenderer& renderer, uint32_t slotCount, uint32_t encoderThreadCount)
+		: lveRenderer{ renderer }, extent{ renderer.getExtent() }, encoders{ encoderThreadCount } {
+		if (slotCount <= renderer.getFramesInFlight()) {
+			throw std::runtime_error("Readback needs more staging buffers than frames in flight, got "
+				+ std::to_string(slotCount) + "!");
+		}
+
+		// reading back through uncached memory is many times slower
+		VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+		if (device.hasMemoryType(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT)) {
+			properties |= VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+		}
+		const VkDeviceSize imageSize = static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+		slots.resize(slotCount);
+		for (auto& slot : slots) {
+			slot.buffer = std::make_unique<LveBuffer>(device, imageSize, 1, VK_BUFFER_USAGE_TRANSFER_DST_BIT, properties);
+			slot.buffer->map();
+		}
+	}
+
+	LveFrameReadback::~LveFrameReadback() {}
+
+	/**
+	 * @brief Records the copy of the current frame's image, to be written to an image file.
+	 *
+	 * @param commandBuffer The frame's command buffer, after the render pass has ended.
+	 * @param filepath The file the image is written to.
+	 * @return False if the frame was dropped because no staging buffer was free.
+	 */
+	bool LveFrameReadback::capture(VkCommandBuffer commandBuffer, const std::string& filepath) {
+		const VkExtent2D imageExtent = extent;
+		return capture(commandBuffer, [filepath, imageExtent](const uint8_t* rgba) {
+			writeImage(filepath, rgba, imageExtent.width, imageExtent.height);
+		});
+	}
+
+	/**
+	 * @brief Records the copy of the current frame's image into the next free staging buffer.
+	 *
+	 * @param commandBuffer The frame's command buffer, after the render pass has ended.
+	 * @param encoder Called with the pixels on an encoder thread once the frame has completed.
+	 * @return False if the frame was dropped because no staging buffer was free.
+	 *
+	 * Buffers are taken in ring order. When every buffer is busy and waiting is enabled, the oldest capture is
+	 * waited for, first on the GPU if its frame has not completed yet and then on its encoder.
+	 */
+	bool LveFrameReadback::capture(VkCommandBuffer commandBuffer, Encoder encoder) {
+		poll();
+
+		int index = findFreeSlot();
+		if (index < 0 && waitWhenFull) {
+			auto blockStart = std::chrono::high_resolution_clock::now();
+			while ((index = findFreeSlot()) < 0) {
+				waitForOldestCapture();
+			}
+			blockedTime += std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - blockStart).count();
+		}
+		if (index < 0) {
+			droppedCount++;
+			return false;
+		}
+
+		Slot& slot = slots[index];
+		lveRenderer.copyCurrentImage(commandBuffer, slot.buffer->getBuffer());
+		slot.state = SlotState::Copying;
+		slot.frameSerial = lveRenderer.getFrameSerial();
+		slot.encoder = std::move(encoder);
+		nextSlot = (static_cast<uint32_t>(index) + 1) % static_cast<uint32_t>(slots.size());
+		pendingSlots.push_back(static_cast<uint32_t>(index));
+		capturedCount++;
+		return true;
+	}
+
+	/**
+	 * @brief Advances every staging buffer whose copy or encoding has finished.
+	 *
+	 * A copy has finished once its frame's fence has signaled, which is checked without waiting. Copies are handed
+	 * to the encoders in capture order, stopping at the first frame still in flight, so consumers that depend on
+	 * the order, like a video stream, never wait for a frame that has not been handed over yet.
+	 */
+	void LveFrameReadback::poll() {
+		for (uint32_t index : pendingSlots) {
+			Slot& slot = slots[index];
+			if (slot.state != SlotState::Copying) continue;
+			if (!lveRenderer.isFrameComplete(slot.frameSerial)) break;
+			startEncoding(slot);
+		}
+		for (size_t i = 0; i < pendingSlots.size();) {
+			Slot& slot = slots[pendingSlots[i]];
+			if (slot.state == SlotState::Encoding &&
+				slot.encoding.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+				pendingSlots.erase(pendingSlots.begin() + i);
+				finishEncoding(slot);
+			} else {
+				i++;
+			}
+		}
+	}
+
+	/**
+	 * @brief Waits for every captured frame to complete on the GPU and to be written.
+	 */
+	void LveFrameReadback::flush() {
+		lveRenderer.waitForAllFrames();
+		for (uint32_t index : pendingSlots) {
+			if (slots[index].state == SlotState::Copying) {
+				startEncoding(slots[index]);
+			}
+		}
+		while (!pendingSlots.empty()) {
+			Slot& slot = slots[pendingSlots.front()];
+			pendingSlots.pop_front();
+			finishEncoding(slot);
+		}
+	}
+
+	int LveFrameReadback::findFreeSlot() const {
+		for (uint32_t i = 0; i < slots.size(); i++) {
+			const uint32_t index = (nextSlot + i) % static_cast<uint32_t>(slots.size());
+			if (slots[index].state == SlotState::Free) return static_cast<int>(index);
+		}
+		return -1;
+	}
+
+	/**
+	 * @brief Blocks until the oldest pending capture has been encoded and frees its buffer.
+	 *
+	 * Every earlier capture has been handed to the encoders already, so the wait never depends on a frame that is
+	 * still waiting for its turn.
+	 */
+	void LveFrameReadback::waitForOldestCapture() {
+		Slot& slot = slots[pendingSlots.front()];
+		if (slot.state == SlotState::Copying) {
+			lveRenderer.waitForFrameComplete(slot.frameSerial);
+			startEncoding(slot);
+		}
+		pendingSlots.pop_front();
+		finishEncoding(slot);
+	}
+
+	/**
+	 * @brief Hands a completed copy to the encoder threads.
+	 *
+	 * The mapped range is invalidated here, so the encoder reads what the GPU wrote even from non coherent memory.
+	 * The slot is not reused before the encoder has finished with it.
+	 */
+	void LveFrameReadback::startEncoding(Slot& slot) {
+		slot.buffer->invalidate();
+		const uint8_t* pixels = static_cast<const uint8_t*>(slot.buffer->getMappedMemory());
+		slot.encoding = encoders.submit([pixels, encoder = std::move(slot.encoder)]() {
+			auto encodeStart = std::chrono::high_resolution_clock::now();
+			encoder(pixels);
+			return std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - encodeStart).count();
+		});
+		slot.state = SlotState::Encoding;
+	}
+
+	/**
+	 * @brief Blocks until a slot's encoder has finished and frees the slot, rethrowing the encoder's error.
+	 */
+	void LveFrameReadback::finishEncoding(Slot& slot) {
+		slot.state = SlotState::Free;
+		encodeTime += slot.encoding.get();
+		writtenCount++;
+	}
+}
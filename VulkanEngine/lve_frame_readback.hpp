@@ -0,0 +1,103 @@
+#pragma once
+
+#include "lve_buffer.hpp"
+#include "lve_device.hpp"
+#include "lve_headless_renderer.hpp"
+#include "lve_job_system.hpp"
+
+// std
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+	/**
+	 * Asynchronous readback of rendered frames to image files through a ring of staging buffers.
+	 *
+	 * capture() records a copy of the frame's color image into a free staging buffer. Once the frame's fence shows
+	 * the copy has completed, poll() hands the buffer to a pool of encoder threads writing the file, and reclaims it
+	 * when the encoder is done. Buffers are handed over in capture order. By default nothing ever waits for the GPU
+	 * or for encoding on the render thread: when every buffer is still in use the frame is dropped and counted
+	 * instead, so a slow disk shows up as dropped frames rather than a stalled GPU. Consumers that need every frame,
+	 * like a video stream, enable waiting instead, which passes their back-pressure on to the render loop.
+	 *
+	 * The encoders run on their own job system, so encoding never delays the render systems' parallel work.
+	 */
+	class LveFrameReadback {
+	public:
+		// Consumes a read back frame's tightly packed 8 bit RGBA pixels, called on an encoder thread
+		using Encoder = std::function<void(const uint8_t* rgba)>;
+
+		// slotCount staging buffers, at least one more than the frames in flight; 0 encoder threads picks one per
+		// hardware thread minus one
+		LveFrameReadback(
+			LveDevice& device, LveHeadlessRenderer& renderer, uint32_t slotCount, uint32_t encoderThreadCount = 0);
+		~LveFrameReadback();
+
+		LveFrameReadback(const LveFrameReadback&) = delete;
+		LveFrameReadback& operator=(const LveFrameReadback&) = delete;
+
+		// Copies the current frame's image after its render pass, to be written to filepath once the frame has
+		// completed, the format following the extension. Returns false and counts the frame as dropped when every
+		// staging buffer is busy.
+		bool capture(VkCommandBuffer commandBuffer, const std::string& filepath);
+		// Same, handing the pixels to encoder instead of writing a file
+		bool capture(VkCommandBuffer commandBuffer, Encoder encoder);
+		// Hands the buffers of completed frames to the encoders and reclaims encoded ones, never blocks. Rethrows
+		// the first encoding error.
+		void poll();
+		// Blocks until every captured frame has been written
+		void flush();
+
+		// when enabled capture() waits for the oldest capture to be encoded instead of dropping the frame
+		void setWaitWhenFull(bool enabled) { waitWhenFull = enabled; }
+
+		uint64_t getCapturedCount() const { return capturedCount; }
+		uint64_t getWrittenCount() const { return writtenCount; }
+		uint64_t getDroppedCount() const { return droppedCount; }
+		// seconds the encoder threads spent encoding and writing, summed over every written frame
+		float getEncodeTime() const { return encodeTime; }
+		// seconds capture() blocked on full buffers while waiting is enabled
+		float getBlockedTime() const { return blockedTime; }
+
+	private:
+		enum class SlotState { Free, Copying, Encoding };
+
+		struct Slot {
+			std::unique_ptr<LveBuffer> buffer;
+			SlotState state = SlotState::Free;
+			uint64_t frameSerial = 0;
+			Encoder encoder;
+			// seconds spent encoding
+			std::future<float> encoding;
+		};
+
+		// index of a free slot in ring order, or -1 when every slot is busy
+		int findFreeSlot() const;
+		void waitForOldestCapture();
+		void startEncoding(Slot& slot);
+		void finishEncoding(Slot& slot);
+
+		LveHeadlessRenderer& lveRenderer;
+		VkExtent2D extent;
+		std::vector<Slot> slots;
+		uint32_t nextSlot = 0;
+		// indices of the busy slots in capture order
+		std::deque<uint32_t> pendingSlots;
+		bool waitWhenFull = false;
+
+		uint64_t capturedCount = 0;
+		uint64_t writtenCount = 0;
+		uint64_t droppedCount = 0;
+		float encodeTime = 0.f;
+		float blockedTime = 0.f;
+
+		// declared last so it is destroyed first, finishing the queued encodes while the buffers still exist
+		LveJobSystem encoders;
+	};
+}
@@ -0,0 +1,159 @@
+/**
+ * @file lve_frustum.cpp
+ * @brief Implementation of the LveFrustum class used for view frustum culling.
+ *
+ * This file contains plane extraction from a combined projection * view matrix and the sphere and box
+ * tests used to reject objects outside of the camera's view before any draw commands are recorded.
+ * The batched sphere test uses SSE when the target supports it and falls back to scalar code otherwise.
+ */
+
+#include "lve_frustum.hpp"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define LVE_FRUSTUM_SSE 1
+#include <xmmintrin.h>
+#endif
+
+namespace lve {
+
+	/**
+	 * @brief Extracts the six frustum planes from a projection * view matrix.
+	 *
+	 * Uses the Gribb/Hartmann method adapted to Vulkan's clip space, where depth ranges from 0 to w
+	 * (GLM_FORCE_DEPTH_ZERO_TO_ONE). Planes are normalized so plane tests return true signed distances.
+	 *
+	 * @param viewProjection The combined matrix, typically camera.getProjection() * camera.getView().
+	 */
+	LveFrustum::LveFrustum(const glm::mat4& viewProjection) {
+		auto row = [&viewProjection](int i) {
+			return glm::vec4{ viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i] };
+		};
+		const glm::vec4 r0 = row(0);
+		const glm::vec4 r1 = row(1);
+		const glm::vec4 r2 = row(2);
+		const glm::vec4 r3 = row(3);
+
+		planes[Left] = r3 + r0;
+		planes[Right] = r3 - r0;
+		planes[Bottom] = r3 + r1;
+		planes[Top] = r3 - r1;
+		planes[Near] = r2;
+		planes[Far] = r3 - r2;
+
+		for (auto& plane : planes) {
+			plane /= glm::length(glm::vec3(plane));
+		}
+	}
+
+	/**
+	 * @brief Tests whether a world space sphere intersects the frustum.
+	 *
+	 * @param sphere The sphere to test.
+	 * @return True if any part of the sphere may be visible.
+	 */
+	bool LveFrustum::intersects(const BoundingSphere& sphere) const {
+		for (const auto& plane : planes) {
+			if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Tests whether a world space box intersects the frustum.
+	 *
+	 * Only the corner furthest along each plane normal is tested, so the test is conservative
+	 * and may report boxes near frustum corners as visible.
+	 *
+	 * @param box The box to test.
+	 * @return True if any part of the box may be visible.
+	 */
+	bool LveFrustum::intersects(const BoundingBox& box) const {
+		for (const auto& plane : planes) {
+			const glm::vec3 positive{
+				plane.x >= 0.f ? box.max.x : box.min.x,
+				plane.y >= 0.f ? box.max.y : box.min.y,
+				plane.z >= 0.f ? box.max.z : box.min.z };
+			if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.f) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Tests whether a world space box lies entirely inside the frustum.
+	 *
+	 * @param box The box to test.
+	 * @return True if every point of the box is inside all six planes.
+	 */
+	bool LveFrustum::contains(const BoundingBox& box) const {
+		for (const auto& plane : planes) {
+			const glm::vec3 negative{
+				plane.x >= 0.f ? box.min.x : box.max.x,
+				plane.y >= 0.f ? box.min.y : box.max.y,
+				plane.z >= 0.f ? box.min.z : box.max.z };
+			if (glm::dot(glm::vec3(plane), negative) + plane.w < 0.f) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Culls a batch of spheres against the frustum.
+	 *
+	 * Four spheres are tested against all six planes per iteration using SSE. The tail that does not
+	 * fill a full vector is handled with the scalar test.
+	 *
+	 * @param spheres The world space spheres in structure of arrays layout.
+	 * @param visibleIndices Receives the indices of the spheres that intersect the frustum.
+	 */
+	void LveFrustum::cullSpheres(const SphereList& spheres, std::vector<uint32_t>& visibleIndices) const {
+		const size_t count = spheres.size();
+		size_t i = 0;
+
+#ifdef LVE_FRUSTUM_SSE
+		__m128 planeX[Count], planeY[Count], planeZ[Count], planeW[Count];
+		for (int p = 0; p < Count; p++) {
+			planeX[p] = _mm_set1_ps(planes[p].x);
+			planeY[p] = _mm_set1_ps(planes[p].y);
+			planeZ[p] = _mm_set1_ps(planes[p].z);
+			planeW[p] = _mm_set1_ps(planes[p].w);
+		}
+
+		for (; i + 4 <= count; i += 4) {
+			const __m128 x = _mm_loadu_ps(&spheres.centerX[i]);
+			const __m128 y = _mm_loadu_ps(&spheres.centerY[i]);
+			const __m128 z = _mm_loadu_ps(&spheres.centerZ[i]);
+			const __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&spheres.radius[i]));
+
+			__m128 inside = _mm_cmpeq_ps(_mm_setzero_ps(), _mm_setzero_ps());
+			for (int p = 0; p < Count; p++) {
+				__m128 distance = _mm_add_ps(_mm_mul_ps(planeX[p], x), planeW[p]);
+				distance = _mm_add_ps(distance, _mm_mul_ps(planeY[p], y));
+				distance = _mm_add_ps(distance, _mm_mul_ps(planeZ[p], z));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negRadius));
+			}
+
+			int mask = _mm_movemask_ps(inside);
+			while (mask != 0) {
+				int lane = 0;
+				while ((mask & (1 << lane)) == 0) lane++;
+				visibleIndices.push_back(static_cast<uint32_t>(i + lane));
+				mask &= mask - 1;
+			}
+		}
+#endif
+
+		for (; i < count; i++) {
+			BoundingSphere sphere{
+				{ spheres.centerX[i], spheres.centerY[i], spheres.centerZ[i] },
+				spheres.radius[i] };
+			if (intersects(sphere)) {
+				visibleIndices.push_back(static_cast<uint32_t>(i));
+			}
+		}
+	}
+}
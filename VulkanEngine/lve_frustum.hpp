@@ -0,0 +1,56 @@
+#pragma once
+
+#include "lve_bounds.hpp"
+
+// std
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+	// Structure of arrays layout so four spheres can be tested per SIMD iteration
+	struct SphereList {
+		std::vector<float> centerX{};
+		std::vector<float> centerY{};
+		std::vector<float> centerZ{};
+		std::vector<float> radius{};
+
+		size_t size() const { return radius.size(); }
+
+		void clear() {
+			centerX.clear();
+			centerY.clear();
+			centerZ.clear();
+			radius.clear();
+		}
+
+		void push(const BoundingSphere& sphere) {
+			centerX.push_back(sphere.center.x);
+			centerY.push_back(sphere.center.y);
+			centerZ.push_back(sphere.center.z);
+			radius.push_back(sphere.radius);
+		}
+	};
+
+	class LveFrustum {
+	public:
+		enum Plane { Left = 0, Right, Bottom, Top, Near, Far, Count };
+
+		LveFrustum() = default;
+		explicit LveFrustum(const glm::mat4& viewProjection);
+
+		bool intersects(const BoundingSphere& sphere) const;
+		bool intersects(const BoundingBox& box) const;
+		bool contains(const BoundingBox& box) const;
+
+		// Appends the index of every sphere intersecting the frustum to visibleIndices
+		void cullSpheres(const SphereList& spheres, std::vector<uint32_t>& visibleIndices) const;
+
+		const std::array<glm::vec4, Count>& getPlanes() const { return planes; }
+
+	private:
+		// xyz is the inward facing normal, w the distance, normalized so dot(n, p) + w is a signed distance
+		std::array<glm::vec4, Count> planes{};
+	};
+}
@@ -82,6 +82,19 @@ namespace lve {
 		};
 	}
 
+	/**
+	 * @brief Calculates the world space bounding box of the object's model.
+	 *
+	 * @return The model's object space box transformed by the object's transform, or an invalid
+	 *         box if the object has no model.
+	 */
+	BoundingBox LveGameObject::getWorldBounds() {
+		if (model == nullptr) {
+			return BoundingBox{};
+		}
+		return model->getBoundingBox().transformed(transform.mat4());
+	}
+
 	/**
 	 * @brief Creates a point light game object.
 	 *
@@ -26,6 +26,11 @@ namespace lve {
 		float lightIntensity = 1.0f;
 	};
 
+	struct OccluderComponent {
+		// null uses the model's own triangles, set a simplified mesh for detailed models
+		std::shared_ptr<const OccluderMesh> mesh{};
+	};
+
 	class LveGameObject {
 	public:
 		using id_t = unsigned int;
@@ -47,12 +52,16 @@ namespace lve {
 		// instead of const, might need to be id_t
 		id_t getId() { return id; }
 
+		// world space bounds of the model, invalid if the object has no model
+		BoundingBox getWorldBounds();
+
 		glm::vec3 color{};
 		TransformComponent transform{};
 
 		// optional pointer components
 		std::shared_ptr<LveModel> model{};
 		std::unique_ptr<PointLightComponent> pointLight = nullptr;
+		std::unique_ptr<OccluderComponent> occluder = nullptr;
 
 	private:
 		LveGameObject(id_t objId) :id{ objId } {}
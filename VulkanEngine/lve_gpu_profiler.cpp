@@ -0,0 +1,231 @@
+/**
+ * @file lve_gpu_profiler.cpp
+ * @brief Implementation of the LveGpuProfiler class, which times command buffer zones with timestamp queries.
+ *
+ * This file contains the per frame query pools, the thread safe allocation of zone queries and the delayed,
+ * non blocking readback of their results into rolling averages.
+ */
+
+#include "lve_gpu_profiler.hpp"
+
+// std
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <stdexcept>
+
+namespace lve {
+
+	/**
+	 * @brief Begins a zone on the command buffer, if there is a profiler.
+	 *
+	 * @param profiler The profiler, or null to time nothing.
+	 * @param commandBuffer The primary or secondary command buffer the zone's commands are recorded into.
+	 * @param name The zone's name, a string literal or otherwise valid for the profiler's lifetime.
+	 */
+	LveGpuProfiler::Zone::Zone(LveGpuProfiler* profiler, VkCommandBuffer commandBuffer, const char* name)
+		: profiler{ profiler }, commandBuffer{ commandBuffer } {
+		if (profiler != nullptr) {
+			handle = profiler->beginZone(commandBuffer, name);
+		}
+	}
+
+	LveGpuProfiler::Zone::~Zone() {
+		if (profiler != nullptr) {
+			profiler->endZone(commandBuffer, handle);
+		}
+	}
+
+	/**
+	 * @brief Creates one timestamp query pool per frame in flight.
+	 *
+	 * @param device The device whose graphics queue is timed.
+	 * @param framesInFlight Number of frames the renderer keeps in flight, each gets its own pool.
+	 *
+	 * Timestamps count ticks of `timestampPeriod` nanoseconds, of which only the queue's valid bits are
+	 * meaningful. A device whose graphics queue has no valid bits gets no pools and ignores every zone.
+	 */
+	LveGpuProfiler::LveGpuProfiler(LveDevice& device, uint32_t framesInFlight) : lveDevice{ device } {
+		const uint32_t validBits = lveDevice.getTimestampValidBits();
+		if (validBits == 0) return;
+		timestampMask = validBits >= 64 ? ~uint64_t{ 0 } : (uint64_t{ 1 } << validBits) - 1;
+		timestampPeriod = lveDevice.properties.limits.timestampPeriod;
+
+		frames.resize(framesInFlight);
+		for (auto& frame : frames) {
+			VkQueryPoolCreateInfo poolInfo{};
+			poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+			poolInfo.queryCount = 2 * MAX_ZONES_PER_FRAME;
+			if (vkCreateQueryPool(lveDevice.device(), &poolInfo, nullptr, &frame.queryPool) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create timestamp query pool!");
+			}
+			frame.zones.reserve(MAX_ZONES_PER_FRAME);
+		}
+	}
+
+	LveGpuProfiler::~LveGpuProfiler() {
+		for (auto& frame : frames) {
+			vkDestroyQueryPool(lveDevice.device(), frame.queryPool, nullptr);
+		}
+	}
+
+	/**
+	 * @brief Reads back the frame slot's previous zones and resets its query pool.
+	 *
+	 * @param commandBuffer The frame's primary command buffer, outside of any render pass.
+	 * @param frameIndex The frame in flight being recorded.
+	 *
+	 * The slot's previous submission has completed once its fence was waited for, so its results are read
+	 * without waiting, framesInFlight frames after they were recorded.
+	 */
+	void LveGpuProfiler::beginFrame(VkCommandBuffer commandBuffer, int frameIndex) {
+		if (!isSupported()) return;
+
+		FrameQueries& frame = frames[frameIndex];
+		collectResults(frame);
+		vkCmdResetQueryPool(commandBuffer, frame.queryPool, 0, 2 * MAX_ZONES_PER_FRAME);
+
+		std::lock_guard<std::mutex> lock{ zoneMutex };
+		currentFrameIndex = frameIndex;
+	}
+
+	/**
+	 * @brief Writes the zone's start timestamp once the GPU reaches the following commands.
+	 *
+	 * Safe to call from several threads recording different command buffers of the current frame.
+	 */
+	LveGpuProfiler::ZoneHandle LveGpuProfiler::beginZone(VkCommandBuffer commandBuffer, const char* name) {
+		if (!isSupported()) return ZoneHandle{};
+
+		ZoneHandle zone{};
+		{
+			std::lock_guard<std::mutex> lock{ zoneMutex };
+			if (currentFrameIndex < 0) return ZoneHandle{};
+			FrameQueries& frame = frames[currentFrameIndex];
+			if (frame.zones.size() >= MAX_ZONES_PER_FRAME) return ZoneHandle{};
+			zone.query = 2 * static_cast<uint32_t>(frame.zones.size());
+			zone.queryPool = frame.queryPool;
+			frame.zones.push_back({ name, zone.query });
+		}
+		// the command buffer belongs to the calling thread, only the query allocation needs the lock
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, zone.queryPool, zone.query);
+		return zone;
+	}
+
+	/**
+	 * @brief Writes the zone's end timestamp once every preceding command has completed.
+	 *
+	 * Only touches the pool captured when the zone began, so it needs no lock and stays correct when another
+	 * frame has begun in the meantime.
+	 */
+	void LveGpuProfiler::endZone(VkCommandBuffer commandBuffer, const ZoneHandle& zone) {
+		if (zone.query == NO_QUERY) return;
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, zone.queryPool, zone.query + 1);
+	}
+
+	/**
+	 * @brief Turns the frame's timestamp pairs into one sample per zone name.
+	 *
+	 * Results are read together with their availability, so a zone that was never ended, or a frame that was
+	 * never submitted, is skipped rather than waited for.
+	 */
+	void LveGpuProfiler::collectResults(FrameQueries& frame) {
+		if (frame.zones.empty()) return;
+
+		// value and availability of every query
+		const uint32_t queryCount = 2 * static_cast<uint32_t>(frame.zones.size());
+		std::vector<uint64_t> results(2 * static_cast<size_t>(queryCount));
+		vkGetQueryPoolResults(
+			lveDevice.device(),
+			frame.queryPool,
+			0,
+			queryCount,
+			results.size() * sizeof(uint64_t),
+			results.data(),
+			2 * sizeof(uint64_t),
+			VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+		std::vector<std::pair<const char*, float>> frameSamples;
+		for (const ZoneQuery& zone : frame.zones) {
+			const uint64_t* begin = &results[2 * static_cast<size_t>(zone.firstQuery)];
+			const uint64_t* end = begin + 2;
+			if (begin[1] == 0 || end[1] == 0) continue;
+
+			// masking the difference also handles a counter that wrapped around within the zone
+			const uint64_t ticks = (end[0] - begin[0]) & timestampMask;
+			const float milliseconds = static_cast<float>(static_cast<double>(ticks) * timestampPeriod * 1e-6);
+			auto sample = std::find_if(frameSamples.begin(), frameSamples.end(), [&](const auto& entry) {
+				return std::strcmp(entry.first, zone.name) == 0;
+			});
+			if (sample == frameSamples.end()) {
+				frameSamples.emplace_back(zone.name, milliseconds);
+			} else {
+				sample->second += milliseconds;
+			}
+		}
+		frame.zones.clear();
+
+		for (const auto& [name, milliseconds] : frameSamples) {
+			addSample(name, milliseconds);
+		}
+	}
+
+	void LveGpuProfiler::addSample(const std::string& name, float milliseconds) {
+		auto index = historyIndices.find(name);
+		if (index == historyIndices.end()) {
+			index = historyIndices.emplace(name, histories.size()).first;
+			histories.push_back(ZoneHistory{});
+			histories.back().name = name;
+		}
+		ZoneHistory& history = histories[index->second];
+		history.samples[history.nextSample] = milliseconds;
+		history.nextSample = (history.nextSample + 1) % AVERAGE_WINDOW;
+		history.sampleCount = std::min(history.sampleCount + 1, AVERAGE_WINDOW);
+	}
+
+	std::vector<LveGpuProfiler::ZoneTiming> LveGpuProfiler::getZoneTimings() const {
+		std::vector<ZoneTiming> timings;
+		timings.reserve(histories.size());
+		for (const ZoneHistory& history : histories) {
+			ZoneTiming timing{};
+			timing.name = history.name;
+			timing.sampleCount = history.sampleCount;
+			timing.latestMs = history.samples[(history.nextSample + AVERAGE_WINDOW - 1) % AVERAGE_WINDOW];
+			// the window is filled from the front, so its first sampleCount entries are the valid ones
+			float sum = 0.f;
+			for (uint32_t i = 0; i < history.sampleCount; i++) {
+				sum += history.samples[i];
+				timing.maxMs = std::max(timing.maxMs, history.samples[i]);
+			}
+			timing.averageMs = history.sampleCount > 0 ? sum / history.sampleCount : 0.f;
+			timings.push_back(timing);
+		}
+		return timings;
+	}
+
+	float LveGpuProfiler::getLatestMs(const std::string& name) const {
+		auto index = historyIndices.find(name);
+		if (index == historyIndices.end()) return 0.f;
+		const ZoneHistory& history = histories[index->second];
+		return history.samples[(history.nextSample + AVERAGE_WINDOW - 1) % AVERAGE_WINDOW];
+	}
+
+	void LveGpuProfiler::logTimings(std::ostream& output) const {
+		if (histories.empty()) return;
+
+		const std::streamsize precision = output.precision();
+		output << "GPU time:" << std::fixed << std::setprecision(3);
+		const char* separator = " ";
+		for (const ZoneTiming& timing : getZoneTimings()) {
+			output << separator << timing.name << " " << timing.averageMs << " ms (max " << timing.maxMs << ")";
+			separator = ", ";
+		}
+		output << std::defaultfloat << std::setprecision(precision) << std::endl;
+	}
+
+	void LveGpuProfiler::resetTimings() {
+		histories.clear();
+		historyIndices.clear();
+	}
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "lve_device.hpp"
+
+// std
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lve {
+
+	/**
+	 * Measures how long named zones of command buffers take on the GPU with timestamp queries.
+	 *
+	 * Every frame in flight owns a query pool. beginFrame() resets it at the start of the frame and first reads
+	 * back the results the same frame slot recorded framesInFlight frames ago, whose fence has been waited for, so
+	 * the CPU never stalls on a query. A zone writes one timestamp when it begins and one when it ends. Zones may
+	 * be written from several threads into secondary command buffers executed by the same frame; zones sharing a
+	 * name, like the parallel recordings of one pass, are summed into one sample per frame.
+	 *
+	 * Averages are taken over the latest AVERAGE_WINDOW samples of each zone.
+	 */
+	class LveGpuProfiler {
+	public:
+		static constexpr uint32_t MAX_ZONES_PER_FRAME = 128;
+		static constexpr uint32_t AVERAGE_WINDOW = 120;
+
+		struct ZoneTiming {
+			std::string name;
+			float averageMs = 0.f;
+			float latestMs = 0.f;
+			float maxMs = 0.f;
+			uint32_t sampleCount = 0;
+		};
+
+		static constexpr uint32_t NO_QUERY = ~0u;
+
+		// the queries of a begun zone, in the pool of the frame it was begun in
+		struct ZoneHandle {
+			VkQueryPool queryPool = VK_NULL_HANDLE;
+			uint32_t query = NO_QUERY;
+		};
+
+		// Times the commands recorded while it is alive, does nothing for a null profiler
+		class Zone {
+		public:
+			Zone(LveGpuProfiler* profiler, VkCommandBuffer commandBuffer, const char* name);
+			~Zone();
+
+			Zone(const Zone&) = delete;
+			Zone& operator=(const Zone&) = delete;
+
+		private:
+			LveGpuProfiler* profiler;
+			VkCommandBuffer commandBuffer;
+			ZoneHandle handle;
+		};
+
+		LveGpuProfiler(LveDevice& device, uint32_t framesInFlight);
+		~LveGpuProfiler();
+
+		LveGpuProfiler(const LveGpuProfiler&) = delete;
+		LveGpuProfiler& operator=(const LveGpuProfiler&) = delete;
+
+		// false if the graphics queue cannot write timestamps, zones are then ignored
+		bool isSupported() const { return timestampMask != 0; }
+
+		// Collects the frame slot's previous results and resets its queries. Call after the frame's fence wait,
+		// recording into the primary command buffer outside of any render pass, before the frame's first zone.
+		void beginFrame(VkCommandBuffer commandBuffer, int frameIndex);
+
+		// Explicit zone bounds for zones that do not follow a scope. name must stay valid for the profiler's
+		// lifetime, like a string literal. The handle's query is NO_QUERY when the frame has run out of queries.
+		// The end timestamp goes to the pool the zone was begun in, even if another frame has begun since.
+		ZoneHandle beginZone(VkCommandBuffer commandBuffer, const char* name);
+		void endZone(VkCommandBuffer commandBuffer, const ZoneHandle& zone);
+
+		// rolling timings in the order the zones were first seen
+		std::vector<ZoneTiming> getZoneTimings() const;
+		// the zone's most recent sample, 0 until it has one
+		float getLatestMs(const std::string& name) const;
+		// One line with the average of every zone
+		void logTimings(std::ostream& output) const;
+		// Forgets the collected samples, for example after a setting affecting them has changed
+		void resetTimings();
+
+	private:
+		struct ZoneQuery {
+			const char* name;
+			uint32_t firstQuery;
+		};
+
+		struct FrameQueries {
+			VkQueryPool queryPool = VK_NULL_HANDLE;
+			std::vector<ZoneQuery> zones;
+		};
+
+		struct ZoneHistory {
+			std::string name;
+			std::array<float, AVERAGE_WINDOW> samples{};
+			uint32_t sampleCount = 0;
+			uint32_t nextSample = 0;
+		};
+
+		void collectResults(FrameQueries& frame);
+		void addSample(const std::string& name, float milliseconds);
+
+		LveDevice& lveDevice;
+		uint64_t timestampMask = 0;
+		float timestampPeriod = 1.f; // nanoseconds per tick
+
+		std::vector<FrameQueries> frames;
+		int currentFrameIndex = -1;
+		// guards the zones of the current frame, begun from several recording threads
+		std::mutex zoneMutex;
+
+		std::vector<ZoneHistory> histories;
+		std::unordered_map<std::string, size_t> historyIndices;
+	};
+}
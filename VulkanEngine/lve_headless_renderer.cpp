@@ -0,0 +1,204 @@
+/**
+ * @file lve_headless_renderer.cpp
+ * @brief Implementation of the LveHeadlessRenderer class, the frame loop of rendering without a display.
+ *
+ * This file contains the command buffer management and the begin and end of offscreen frames.
+ */
+
+#include "lve_headless_renderer.hpp"
+
+// std
+#include <array>
+#include <stdexcept>
+#include <string>
+
+namespace lve {
+
+	/**
+	 * @brief Creates the offscreen target and one command buffer per frame in flight.
+	 *
+	 * @param device The device rendering is done on, usually a headless one.
+	 * @param extent Size of the rendered images.
+	 * @param framesInFlight Number of frames the CPU may record ahead of the GPU, from 1 to
+	 *        `LveSwapChain::MAX_FRAMES_IN_FLIGHT`.
+	 * @throws std::runtime_error If framesInFlight or the extent is out of range.
+	 */
+	LveHeadlessRenderer::LveHeadlessRenderer(LveDevice& device, VkExtent2D extent, uint32_t framesInFlight)
+		: lveDevice{ device }, framesInFlight{ framesInFlight } {
+		if (framesInFlight < 1 || framesInFlight > LveSwapChain::MAX_FRAMES_IN_FLIGHT) {
+			throw std::runtime_error("Frames in flight must be between 1 and "
+				+ std::to_string(LveSwapChain::MAX_FRAMES_IN_FLIGHT) + "!");
+		}
+		if (extent.width == 0 || extent.height == 0) {
+			throw std::runtime_error("Offscreen extent must not be empty!");
+		}
+		offscreenTarget = std::make_unique<LveOffscreenTarget>(lveDevice, extent, framesInFlight);
+		createCommandBuffers();
+	}
+
+	LveHeadlessRenderer::~LveHeadlessRenderer() { freeCommandBuffers(); }
+
+	void LveHeadlessRenderer::createCommandBuffers() {
+		commandBuffers.resize(framesInFlight);
+
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandPool = lveDevice.getCommandPool();
+		allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+
+		if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to allocate command buffers!");
+		}
+	}
+
+	void LveHeadlessRenderer::freeCommandBuffers() {
+		vkFreeCommandBuffers(
+			lveDevice.device(),
+			lveDevice.getCommandPool(),
+			static_cast<uint32_t>(commandBuffers.size()),
+			commandBuffers.data());
+		commandBuffers.clear();
+	}
+
+	/**
+	 * @brief Begins a new frame once the frame's previous submission has completed.
+	 *
+	 * @return VkCommandBuffer The command buffer to record commands for the current frame, never null.
+	 */
+	VkCommandBuffer LveHeadlessRenderer::beginFrame() {
+		assert(!isFrameStarted && "Can't call beginFrame while already in progress.");
+
+		offscreenTarget->waitForFrame(currentFrameIndex);
+		isFrameStarted = true;
+
+		auto commandBuffer = getCurrentCommandBuffer();
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to begin recording command buffer!");
+		}
+
+		return commandBuffer;
+	}
+
+	/**
+	 * @brief Ends the current frame and submits its command buffer.
+	 */
+	void LveHeadlessRenderer::endFrame() {
+		assert(isFrameStarted && "Can't call endFrame while frame is not in progress.");
+		auto commandBuffer = getCurrentCommandBuffer();
+
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to record command buffer!");
+		}
+
+		offscreenTarget->submitCommandBuffers(&commandBuffer, currentFrameIndex);
+
+		isFrameStarted = false;
+		currentFrameIndex = (currentFrameIndex + 1) % static_cast<int>(framesInFlight);
+	}
+
+	/**
+	 * @brief Begins the offscreen render pass for the current frame.
+	 *
+	 * @param commandBuffer The command buffer to begin the render pass on.
+	 * @param contents Whether the pass is recorded inline or executed from secondary command buffers.
+	 *
+	 * Clears like the swap chain render pass. With secondary contents the viewport and scissor are left to the
+	 * secondaries.
+	 */
+	void LveHeadlessRenderer::beginRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents) {
+		assert(isFrameStarted && "Can't call beginRenderPass if frame is not in progress.");
+		assert(commandBuffer == getCurrentCommandBuffer() && "Can't begin render pass on command buffer from a different frame.");
+
+		const VkExtent2D extent = offscreenTarget->getExtent();
+
+		VkRenderPassBeginInfo renderPassInfo{};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		renderPassInfo.renderPass = offscreenTarget->getRenderPass();
+		renderPassInfo.framebuffer = offscreenTarget->getFrameBuffer(currentFrameIndex);
+		renderPassInfo.renderArea.offset = { 0, 0 };
+		renderPassInfo.renderArea.extent = extent;
+
+		std::array<VkClearValue, 2> clearValues{};
+		clearValues[0].color = { 0.01f, 0.01f, 0.01f, 1.0f };
+		clearValues[1].depthStencil = { 1.0f, 0 };
+		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+		renderPassInfo.pClearValues = clearValues.data();
+
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+		if (contents != VK_SUBPASS_CONTENTS_INLINE) {
+			return;
+		}
+
+		VkViewport viewport{};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = static_cast<float>(extent.width);
+		viewport.height = static_cast<float>(extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		VkRect2D scissor{ {0, 0}, extent };
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+	}
+
+	void LveHeadlessRenderer::endRenderPass(VkCommandBuffer commandBuffer) {
+		assert(isFrameStarted && "Can't call endRenderPass if frame is not in progress.");
+		assert(commandBuffer == getCurrentCommandBuffer() && "Can't end render pass on command buffer from a different frame.");
+
+		vkCmdEndRenderPass(commandBuffer);
+	}
+
+	/**
+	 * @brief Records a copy of the frame's color image into a host readable buffer.
+	 *
+	 * @param commandBuffer The frame's command buffer, after endRenderPass.
+	 * @param buffer Receives the pixels as tightly packed rows, at least width * height * 4 bytes.
+	 *
+	 * The render pass already orders its color writes before transfers and leaves the image in the transfer
+	 * source layout. The barrier after the copy makes the pixels visible to the host once the frame's fence has
+	 * been waited for.
+	 */
+	void LveHeadlessRenderer::copyCurrentImage(VkCommandBuffer commandBuffer, VkBuffer buffer) {
+		assert(isFrameStarted && "Can't call copyCurrentImage if frame is not in progress.");
+
+		const VkExtent2D extent = offscreenTarget->getExtent();
+		VkBufferImageCopy region{};
+		region.bufferOffset = 0;
+		region.bufferRowLength = 0;
+		region.bufferImageHeight = 0;
+		region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		region.imageOffset = { 0, 0, 0 };
+		region.imageExtent = { extent.width, extent.height, 1 };
+		vkCmdCopyImageToBuffer(
+			commandBuffer,
+			offscreenTarget->getImage(currentFrameIndex),
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			buffer,
+			1,
+			&region);
+
+		VkBufferMemoryBarrier toHost{};
+		toHost.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		toHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		toHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		toHost.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		toHost.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		toHost.buffer = buffer;
+		toHost.offset = 0;
+		toHost.size = VK_WHOLE_SIZE;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_HOST_BIT,
+			0,
+			0, nullptr,
+			1, &toHost,
+			0, nullptr);
+	}
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_offscreen_target.hpp"
+#include "lve_swap_chain.hpp"
+
+// std
+#include <cassert>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace lve {
+
+	/**
+	 * Frame loop of LveRenderer for a headless device, rendering into an LveOffscreenTarget instead of a swap chain.
+	 *
+	 * Frames are begun and ended the same way, so the render systems and the command recorder are driven as in
+	 * the windowed application. There is no window to resize and nothing to present, so beginFrame never fails
+	 * and the only wait is on the fence of the frame whose resources are about to be reused.
+	 */
+	class LveHeadlessRenderer {
+	public:
+		LveHeadlessRenderer(
+			LveDevice& device,
+			VkExtent2D extent,
+			uint32_t framesInFlight = LveSwapChain::DEFAULT_FRAMES_IN_FLIGHT);
+		~LveHeadlessRenderer();
+
+		LveHeadlessRenderer(const LveHeadlessRenderer&) = delete;
+		LveHeadlessRenderer& operator=(const LveHeadlessRenderer&) = delete;
+
+		VkRenderPass getRenderPass() const { return offscreenTarget->getRenderPass(); }
+		VkExtent2D getExtent() const { return offscreenTarget->getExtent(); }
+		VkFormat getColorFormat() const { return offscreenTarget->getColorFormat(); }
+		float getAspectRatio() const { return offscreenTarget->extentAspectRatio(); }
+		bool isFrameInProgress() const { return isFrameStarted; }
+		uint32_t getFramesInFlight() const { return framesInFlight; }
+		// seconds beginFrame of the latest frame blocked on the frame's fence
+		float getFenceWaitTime() const { return offscreenTarget->getFenceWaitTime(); }
+		std::chrono::high_resolution_clock::time_point getLastSubmitTime() const {
+			return offscreenTarget->getLastSubmitTime();
+		}
+
+		VkCommandBuffer getCurrentCommandBuffer() const {
+			assert(isFrameStarted && "Cannot get command buffer when frame is not in progress.");
+			return commandBuffers[currentFrameIndex];
+		}
+
+		VkFramebuffer getCurrentFrameBuffer() const {
+			assert(isFrameStarted && "Cannot get frame buffer when frame is not in progress.");
+			return offscreenTarget->getFrameBuffer(currentFrameIndex);
+		}
+
+		// the frame's color image, in the transfer source layout once the render pass has ended
+		VkImage getCurrentImage() const {
+			assert(isFrameStarted && "Cannot get image when frame is not in progress.");
+			return offscreenTarget->getImage(currentFrameIndex);
+		}
+
+		// serial of the frame in progress, frames are numbered from 0 in submission order
+		uint64_t getFrameSerial() const {
+			assert(isFrameStarted && "Cannot get frame serial when frame is not in progress.");
+			return offscreenTarget->getSubmittedCount();
+		}
+		// Non blocking check whether the frame with the given serial has completed on the GPU
+		bool isFrameComplete(uint64_t serial) const { return offscreenTarget->isSubmissionComplete(serial); }
+		// Blocks until the submitted frame with the given serial has completed on the GPU
+		void waitForFrameComplete(uint64_t serial) { offscreenTarget->waitForSubmission(serial); }
+
+		int getFrameIndex() const {
+			assert(isFrameStarted && "Cannot get frame index when frame is not in progress.");
+			return currentFrameIndex;
+		}
+
+		VkCommandBuffer beginFrame();
+		void endFrame();
+		void beginRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+		void endRenderPass(VkCommandBuffer commandBuffer);
+		// Copies the frame's color image into a buffer after the render pass, readable once the frame's fence signals
+		void copyCurrentImage(VkCommandBuffer commandBuffer, VkBuffer buffer);
+		// Blocks until every submitted frame has completed
+		void waitForAllFrames() { offscreenTarget->waitForAllFrames(); }
+
+	private:
+		void createCommandBuffers();
+		void freeCommandBuffers();
+
+		LveDevice& lveDevice;
+		uint32_t framesInFlight;
+		std::unique_ptr<LveOffscreenTarget> offscreenTarget;
+		std::vector<VkCommandBuffer> commandBuffers;
+
+		int currentFrameIndex{ 0 };
+		bool isFrameStarted{ false };
+	};
+}
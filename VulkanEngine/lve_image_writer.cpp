@@ -0,0 +1,279 @@
+/**
+ * @file lve_image_writer.cpp
+ * @brief Encoders writing read back frames to image files.
+ *
+ * This file contains dependency free PPM, PNG and OpenEXR writers. They favour encoding speed over file size:
+ * PNG data is stored in uncompressed deflate blocks and EXR scanlines are written without compression.
+ */
+
+#include "lve_image_writer.hpp"
+
+// std
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace lve {
+
+	namespace {
+		std::ofstream createImageFile(const std::string& filepath) {
+			std::ofstream output{ filepath, std::ios::binary | std::ios::trunc };
+			if (!output.is_open()) {
+				throw std::runtime_error("failed to create image file: " + filepath);
+			}
+			return output;
+		}
+
+		void checkWritten(const std::ofstream& output, const std::string& filepath) {
+			if (!output) {
+				throw std::runtime_error("failed to write image file: " + filepath);
+			}
+		}
+
+		const std::array<uint32_t, 256>& crcTable() {
+			static const std::array<uint32_t, 256> table = []() {
+				std::array<uint32_t, 256> values{};
+				for (uint32_t n = 0; n < 256; n++) {
+					uint32_t c = n;
+					for (int k = 0; k < 8; k++) {
+						c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+					}
+					values[n] = c;
+				}
+				return values;
+			}();
+			return table;
+		}
+
+		uint32_t updateCrc(uint32_t crc, const uint8_t* data, size_t size) {
+			const auto& table = crcTable();
+			for (size_t i = 0; i < size; i++) {
+				crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+			}
+			return crc;
+		}
+
+		void appendBigEndian(std::vector<uint8_t>& bytes, uint32_t value) {
+			bytes.push_back(static_cast<uint8_t>(value >> 24));
+			bytes.push_back(static_cast<uint8_t>(value >> 16));
+			bytes.push_back(static_cast<uint8_t>(value >> 8));
+			bytes.push_back(static_cast<uint8_t>(value));
+		}
+
+		void writePngChunk(std::ofstream& output, const char type[4], const std::vector<uint8_t>& data) {
+			std::vector<uint8_t> chunk;
+			chunk.reserve(data.size() + 12);
+			appendBigEndian(chunk, static_cast<uint32_t>(data.size()));
+			chunk.insert(chunk.end(), type, type + 4);
+			chunk.insert(chunk.end(), data.begin(), data.end());
+			uint32_t crc = updateCrc(0xffffffffu, chunk.data() + 4, chunk.size() - 4) ^ 0xffffffffu;
+			appendBigEndian(chunk, crc);
+			output.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+		}
+
+		template <typename T>
+		void appendLittleEndian(std::vector<uint8_t>& bytes, T value) {
+			uint8_t raw[sizeof(T)];
+			std::memcpy(raw, &value, sizeof(T));
+			bytes.insert(bytes.end(), raw, raw + sizeof(T));
+		}
+
+		void appendExrAttribute(
+			std::vector<uint8_t>& bytes, const char* name, const char* type, const std::vector<uint8_t>& value) {
+			bytes.insert(bytes.end(), name, name + std::strlen(name) + 1);
+			bytes.insert(bytes.end(), type, type + std::strlen(type) + 1);
+			appendLittleEndian(bytes, static_cast<int32_t>(value.size()));
+			bytes.insert(bytes.end(), value.begin(), value.end());
+		}
+
+		float srgbToLinear(uint8_t value) {
+			float c = value / 255.f;
+			return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+		}
+	}
+
+	/**
+	 * @brief Writes an image as a binary PPM (P6).
+	 *
+	 * PPM stores 8 bit RGB rows top to bottom without compression, so writing is a copy of each pixel's first
+	 * three bytes. The bytes are written as they are, sRGB encoded for images read back from an sRGB target.
+	 */
+	void writePpm(const std::string& filepath, const uint8_t* rgba, uint32_t width, uint32_t height) {
+		std::ofstream output = createImageFile(filepath);
+		output << "P6\n" << width << " " << height << "\n255\n";
+
+		std::vector<uint8_t> row(static_cast<size_t>(width) * 3);
+		for (uint32_t y = 0; y < height; y++) {
+			const uint8_t* source = rgba + static_cast<size_t>(y) * width * 4;
+			for (uint32_t x = 0; x < width; x++) {
+				row[x * 3 + 0] = source[x * 4 + 0];
+				row[x * 3 + 1] = source[x * 4 + 1];
+				row[x * 3 + 2] = source[x * 4 + 2];
+			}
+			output.write(reinterpret_cast<const char*>(row.data()), row.size());
+		}
+		checkWritten(output, filepath);
+	}
+
+	/**
+	 * @brief Writes an image as an 8 bit RGBA PNG.
+	 *
+	 * Rows use no filter and the zlib stream is made of stored deflate blocks, so encoding is a copy plus the
+	 * CRC and Adler checksums. Files are as large as the raw pixels; recompress them offline if size matters.
+	 */
+	void writePng(const std::string& filepath, const uint8_t* rgba, uint32_t width, uint32_t height) {
+		static constexpr uint8_t SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+		static constexpr size_t MAX_STORED_BLOCK = 65535;
+
+		std::ofstream output = createImageFile(filepath);
+		output.write(reinterpret_cast<const char*>(SIGNATURE), sizeof(SIGNATURE));
+
+		std::vector<uint8_t> header;
+		appendBigEndian(header, width);
+		appendBigEndian(header, height);
+		header.insert(header.end(), { 8, 6, 0, 0, 0 }); // 8 bits, RGBA, deflate, adaptive filters, no interlace
+		writePngChunk(output, "IHDR", header);
+
+		// every row starts with its filter type, 0 for none
+		const size_t rowSize = static_cast<size_t>(width) * 4;
+		std::vector<uint8_t> raw;
+		raw.reserve((rowSize + 1) * height);
+		for (uint32_t y = 0; y < height; y++) {
+			raw.push_back(0);
+			const uint8_t* row = rgba + y * rowSize;
+			raw.insert(raw.end(), row, row + rowSize);
+		}
+
+		std::vector<uint8_t> zlib;
+		zlib.reserve(raw.size() + raw.size() / MAX_STORED_BLOCK * 5 + 16);
+		zlib.push_back(0x78);
+		zlib.push_back(0x01);
+		uint32_t adlerA = 1, adlerB = 0;
+		for (size_t offset = 0; offset < raw.size() || offset == 0; offset += MAX_STORED_BLOCK) {
+			const size_t blockSize = std::min(MAX_STORED_BLOCK, raw.size() - offset);
+			const bool last = offset + blockSize >= raw.size();
+			zlib.push_back(last ? 1 : 0);
+			zlib.push_back(static_cast<uint8_t>(blockSize));
+			zlib.push_back(static_cast<uint8_t>(blockSize >> 8));
+			zlib.push_back(static_cast<uint8_t>(~blockSize));
+			zlib.push_back(static_cast<uint8_t>(~blockSize >> 8));
+			zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + blockSize);
+			for (size_t i = offset; i < offset + blockSize; i++) {
+				adlerA = (adlerA + raw[i]) % 65521;
+				adlerB = (adlerB + adlerA) % 65521;
+			}
+			if (last) break;
+		}
+		appendBigEndian(zlib, (adlerB << 16) | adlerA);
+		writePngChunk(output, "IDAT", zlib);
+		writePngChunk(output, "IEND", {});
+		checkWritten(output, filepath);
+	}
+
+	/**
+	 * @brief Writes an image as a scanline OpenEXR file with 32 bit float channels.
+	 *
+	 * The 8 bit values are decoded from sRGB to linear, as EXR expects. Scanlines are stored without
+	 * compression, one per block, with the channels in the alphabetical order the format requires.
+	 */
+	void writeExr(const std::string& filepath, const uint8_t* rgba, uint32_t width, uint32_t height) {
+		static constexpr int32_t PIXEL_TYPE_FLOAT = 2;
+		// ABGR is alphabetical, the source offset of each channel within an RGBA pixel
+		static constexpr std::array<const char*, 4> CHANNEL_NAMES = { "A", "B", "G", "R" };
+		static constexpr std::array<int, 4> CHANNEL_OFFSETS = { 3, 2, 1, 0 };
+
+		std::array<float, 256> linear{};
+		for (int i = 0; i < 256; i++) {
+			linear[i] = srgbToLinear(static_cast<uint8_t>(i));
+		}
+
+		std::vector<uint8_t> bytes;
+		appendLittleEndian(bytes, static_cast<int32_t>(20000630)); // magic number
+		appendLittleEndian(bytes, static_cast<int32_t>(2)); // version 2, scanline image
+
+		std::vector<uint8_t> channels;
+		for (const char* name : CHANNEL_NAMES) {
+			channels.insert(channels.end(), name, name + std::strlen(name) + 1);
+			appendLittleEndian(channels, PIXEL_TYPE_FLOAT);
+			channels.insert(channels.end(), { 0, 0, 0, 0 }); // linear hint and reserved bytes
+			appendLittleEndian(channels, static_cast<int32_t>(1)); // x sampling
+			appendLittleEndian(channels, static_cast<int32_t>(1)); // y sampling
+		}
+		channels.push_back(0);
+		appendExrAttribute(bytes, "channels", "chlist", channels);
+		appendExrAttribute(bytes, "compression", "compression", { 0 });
+
+		std::vector<uint8_t> window;
+		appendLittleEndian(window, static_cast<int32_t>(0));
+		appendLittleEndian(window, static_cast<int32_t>(0));
+		appendLittleEndian(window, static_cast<int32_t>(width) - 1);
+		appendLittleEndian(window, static_cast<int32_t>(height) - 1);
+		appendExrAttribute(bytes, "dataWindow", "box2i", window);
+		appendExrAttribute(bytes, "displayWindow", "box2i", window);
+		appendExrAttribute(bytes, "lineOrder", "lineOrder", { 0 }); // increasing y
+
+		std::vector<uint8_t> value;
+		appendLittleEndian(value, 1.f);
+		appendExrAttribute(bytes, "pixelAspectRatio", "float", value);
+		value.clear();
+		appendLittleEndian(value, 0.f);
+		appendLittleEndian(value, 0.f);
+		appendExrAttribute(bytes, "screenWindowCenter", "v2f", value);
+		value.clear();
+		appendLittleEndian(value, 1.f);
+		appendExrAttribute(bytes, "screenWindowWidth", "float", value);
+		bytes.push_back(0); // end of header
+
+		const size_t lineDataSize = static_cast<size_t>(width) * CHANNEL_NAMES.size() * sizeof(float);
+		const size_t lineBlockSize = 8 + lineDataSize;
+		uint64_t blockOffset = bytes.size() + static_cast<uint64_t>(height) * sizeof(uint64_t);
+		for (uint32_t y = 0; y < height; y++) {
+			appendLittleEndian(bytes, blockOffset);
+			blockOffset += lineBlockSize;
+		}
+
+		std::ofstream output = createImageFile(filepath);
+		output.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+
+		std::vector<uint8_t> line;
+		line.reserve(lineBlockSize);
+		for (uint32_t y = 0; y < height; y++) {
+			line.clear();
+			appendLittleEndian(line, static_cast<int32_t>(y));
+			appendLittleEndian(line, static_cast<int32_t>(lineDataSize));
+			const uint8_t* source = rgba + static_cast<size_t>(y) * width * 4;
+			for (size_t channel = 0; channel < CHANNEL_NAMES.size(); channel++) {
+				const int sourceOffset = CHANNEL_OFFSETS[channel];
+				// alpha is stored as it is, only color is sRGB encoded
+				const bool isAlpha = sourceOffset == 3;
+				for (uint32_t x = 0; x < width; x++) {
+					const uint8_t byte = source[x * 4 + sourceOffset];
+					appendLittleEndian(line, isAlpha ? byte / 255.f : linear[byte]);
+				}
+			}
+			output.write(reinterpret_cast<const char*>(line.data()), line.size());
+		}
+		checkWritten(output, filepath);
+	}
+
+	bool isImageExtensionSupported(const std::string& extension) {
+		return extension == ".ppm" || extension == ".png" || extension == ".exr";
+	}
+
+	void writeImage(const std::string& filepath, const uint8_t* rgba, uint32_t width, uint32_t height) {
+		const std::string extension = std::filesystem::path{ filepath }.extension().string();
+		if (extension == ".ppm") {
+			writePpm(filepath, rgba, width, height);
+		} else if (extension == ".png") {
+			writePng(filepath, rgba, width, height);
+		} else if (extension == ".exr") {
+			writeExr(filepath, rgba, width, height);
+		} else {
+			throw std::runtime_error("unsupported image format: " + filepath);
+		}
+	}
+}
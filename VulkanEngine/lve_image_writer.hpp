@@ -0,0 +1,21 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <string>
+
+namespace lve {
+
+	// Encoders of tightly packed 8 bit sRGB RGBA pixels, all of them throw on IO failures.
+	// Writes a binary PPM, dropping alpha
+	void writePpm(const std::string& filepath, const uint8_t* rgba, uint32_t width, uint32_t height);
+	// Writes an 8 bit RGBA PNG
+	void writePng(const std::string& filepath, const uint8_t* rgba, uint32_t width, uint32_t height);
+	// Writes a linear 32 bit float RGBA OpenEXR image, decoding sRGB
+	void writeExr(const std::string& filepath, const uint8_t* rgba, uint32_t width, uint32_t height);
+
+	// True if writeImage supports the extension, given with its dot like ".png"
+	bool isImageExtensionSupported(const std::string& extension);
+	// Picks the encoder from the file extension: .ppm, .png or .exr
+	void writeImage(const std::string& filepath, const uint8_t* rgba, uint32_t width, uint32_t height);
+}
@@ -0,0 +1,117 @@
+/**
+ * @file lve_job_system.cpp
+ * @brief Implementation of the LveJobSystem class, a small thread pool for CPU side engine work.
+ *
+ * This file contains the worker loop, job submission and the blocking parallelFor helper used to spread
+ * work such as occlusion rasterization across all cores.
+ */
+
+#include "lve_job_system.hpp"
+
+// std
+#include <algorithm>
+#include <atomic>
+
+namespace lve {
+
+	/**
+	 * @brief Starts the worker threads.
+	 *
+	 * @param workerCount Number of workers to start, 0 picks one per hardware thread minus the caller.
+	 */
+	LveJobSystem::LveJobSystem(uint32_t workerCount) {
+		if (workerCount == 0) {
+			uint32_t hardwareThreads = std::thread::hardware_concurrency();
+			workerCount = std::max(1u, hardwareThreads > 1 ? hardwareThreads - 1 : 1u);
+		}
+
+		workers.reserve(workerCount);
+		for (uint32_t i = 0; i < workerCount; i++) {
+			workers.emplace_back([this]() { workerLoop(); });
+		}
+	}
+
+	/**
+	 * @brief Finishes all queued jobs and joins the worker threads.
+	 */
+	LveJobSystem::~LveJobSystem() {
+		{
+			std::lock_guard<std::mutex> lock{ queueMutex };
+			stopping = true;
+		}
+		queueCondition.notify_all();
+		for (auto& worker : workers) {
+			worker.join();
+		}
+	}
+
+	/**
+	 * @brief Runs a task for every index in [0, taskCount) on the workers and the calling thread.
+	 *
+	 * The calling thread takes part in the work, so this is safe to call even when every worker is busy.
+	 * Helper jobs that start after all tasks were claimed return immediately.
+	 *
+	 * @param taskCount Number of tasks to run.
+	 * @param task Function invoked once per task index.
+	 */
+	void LveJobSystem::parallelFor(uint32_t taskCount, const std::function<void(uint32_t taskIndex)>& task) {
+		if (taskCount == 0) return;
+		if (taskCount == 1) {
+			task(0);
+			return;
+		}
+
+		struct SharedState {
+			std::atomic<uint32_t> nextTask{ 0 };
+			std::atomic<uint32_t> completedTasks{ 0 };
+			std::mutex doneMutex;
+			std::condition_variable doneCondition;
+		};
+		auto state = std::make_shared<SharedState>();
+
+		// helper jobs can outlive this call, but they only use task after claiming an index, which keeps this call waiting
+		auto runTasks = [state, taskCount, &task]() {
+			uint32_t index;
+			while ((index = state->nextTask.fetch_add(1)) < taskCount) {
+				task(index);
+				if (state->completedTasks.fetch_add(1) + 1 == taskCount) {
+					std::lock_guard<std::mutex> lock{ state->doneMutex };
+					state->doneCondition.notify_all();
+				}
+			}
+		};
+
+		uint32_t helperCount = std::min(getWorkerCount(), taskCount - 1);
+		for (uint32_t i = 0; i < helperCount; i++) {
+			enqueue(runTasks);
+		}
+		runTasks();
+
+		std::unique_lock<std::mutex> lock{ state->doneMutex };
+		state->doneCondition.wait(lock, [&state, taskCount]() { return state->completedTasks.load() == taskCount; });
+	}
+
+	void LveJobSystem::enqueue(std::function<void()> job) {
+		{
+			std::lock_guard<std::mutex> lock{ queueMutex };
+			jobs.push_back(std::move(job));
+		}
+		queueCondition.notify_one();
+	}
+
+	void LveJobSystem::workerLoop() {
+		while (true) {
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock{ queueMutex };
+				queueCondition.wait(lock, [this]() { return stopping || !jobs.empty(); });
+				if (stopping && jobs.empty()) {
+					return;
+				}
+				job = std::move(jobs.front());
+				jobs.pop_front();
+			}
+			job();
+		}
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+// std
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lve {
+
+	/**
+	 * Fixed pool of worker threads shared by the engine's CPU side systems.
+	 *
+	 * submit() queues a single job and returns a future, parallelFor() splits work into tasks that run on the
+	 * workers and the calling thread and only returns once every task has finished.
+	 */
+	class LveJobSystem {
+	public:
+		// 0 uses one worker per hardware thread, minus the calling thread
+		explicit LveJobSystem(uint32_t workerCount = 0);
+		~LveJobSystem();
+
+		LveJobSystem(const LveJobSystem&) = delete;
+		LveJobSystem& operator=(const LveJobSystem&) = delete;
+
+		uint32_t getWorkerCount() const { return static_cast<uint32_t>(workers.size()); }
+
+		template <typename F>
+		auto submit(F&& job) -> std::future<decltype(job())> {
+			using Result = decltype(job());
+			auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(job));
+			std::future<Result> result = task->get_future();
+			enqueue([task]() { (*task)(); });
+			return result;
+		}
+
+		// Runs task(i) for every i in [0, taskCount), blocking until all have completed
+		void parallelFor(uint32_t taskCount, const std::function<void(uint32_t taskIndex)>& task);
+
+	private:
+		void enqueue(std::function<void()> job);
+		void workerLoop();
+
+		std::vector<std::thread> workers;
+		std::deque<std::function<void()>> jobs;
+		std::mutex queueMutex;
+		std::condition_variable queueCondition;
+		bool stopping = false;
+	};
+}
@@ -0,0 +1,265 @@
+/**
+ * @file lve_light_clusters.cpp
+ * @brief Implementation of the LveLightClusters class, which bins point lights into view frustum clusters.
+ *
+ * This file contains the gathering of lights into the per frame light buffer, the per depth slice binning that
+ * projects each light's view space bounds to a range of screen tiles, and the compaction of all slices into the
+ * cluster and light index buffers read by the fragment shader.
+ */
+
+#include "lve_light_clusters.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace lve {
+
+	namespace {
+		// light contribution, intensity / distance^2, below which a light is treated as out of range
+		constexpr float LIGHT_CUTOFF = 0.01f;
+		// guards the logarithmic slicing against orthographic projections with a near plane at 0
+		constexpr float MIN_CLUSTER_NEAR = 0.01f;
+		constexpr uint32_t TILE_COUNT = LveLightClusters::CLUSTER_COUNT_X * LveLightClusters::CLUSTER_COUNT_Y;
+
+		// matches the cluster records in simple_shader.frag
+		struct ClusterRange {
+			uint32_t offset;
+			uint32_t count;
+		};
+
+		// Maps a normalized device coordinate range to the inclusive range of tiles it overlaps, false if none
+		bool tileRange(float ndcMin, float ndcMax, uint32_t tileCount, uint32_t& first, uint32_t& last) {
+			if (ndcMax < -1.f || ndcMin > 1.f) return false;
+			auto toTile = [tileCount](float ndc) {
+				float tile = std::floor((ndc * .5f + .5f) * static_cast<float>(tileCount));
+				return static_cast<uint32_t>(std::clamp(tile, 0.f, static_cast<float>(tileCount - 1)));
+			};
+			first = toTile(ndcMin);
+			last = toTile(ndcMax);
+			return true;
+		}
+	}
+
+	/**
+	 * @brief Creates and maps the light, cluster and light index buffers of every frame in flight.
+	 *
+	 * @param device The device the buffers are created on.
+	 * @param jobSystem The job system depth slices are binned on.
+	 * @param framesInFlight Number of frames the renderer keeps in flight.
+	 */
+	LveLightClusters::LveLightClusters(LveDevice& device, LveJobSystem& jobSystem, uint32_t framesInFlight)
+		: lveDevice{ device }, jobSystem{ jobSystem }, slices(CLUSTER_COUNT_Z) {
+		auto createBuffer = [this](VkDeviceSize instanceSize, uint32_t instanceCount) {
+			auto buffer = std::make_unique<LveBuffer>(
+				lveDevice,
+				instanceSize,
+				instanceCount,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+			buffer->map();
+			return buffer;
+		};
+
+		frames.resize(framesInFlight);
+		for (auto& frame : frames) {
+			frame.lightBuffer = createBuffer(sizeof(PointLight), MAX_LIGHTS);
+			frame.clusterBuffer = createBuffer(sizeof(ClusterRange), CLUSTER_COUNT);
+			frame.lightIndexBuffer = createBuffer(sizeof(uint32_t), MAX_LIGHT_INDICES);
+		}
+		for (auto& slice : slices) {
+			slice.tileCounts.resize(TILE_COUNT);
+			slice.tileOffsets.resize(TILE_COUNT);
+		}
+	}
+
+	/**
+	 * @brief Returns the range of influence of a light.
+	 *
+	 * @param intensity The light's intensity.
+	 * @return Distance at which intensity / distance^2 falls to LIGHT_CUTOFF. The shader fades the light to zero
+	 * towards this distance.
+	 */
+	float LveLightClusters::getLightRange(float intensity) {
+		return std::sqrt(std::max(intensity, 0.f) / LIGHT_CUTOFF);
+	}
+
+	/**
+	 * @brief Uploads the frame's lights and rebuilds the cluster light lists.
+	 *
+	 * @param frameInfo A reference to the `FrameInfo` struct containing frame-specific data.
+	 * @param ubo The frame's global uniform data, receives the light count and cluster parameters.
+	 *
+	 * The depth range of the camera's projection is divided into slices whose far depth grows by a constant factor,
+	 * so clusters keep a similar shape in view space. Lights are binned per slice in parallel, then the slices are
+	 * laid out one after another in the index buffer.
+	 */
+	void LveLightClusters::update(FrameInfo& frameInfo, GlobalUbo& ubo) {
+		FrameBuffers& buffers = frames[frameInfo.frameIndex];
+		const glm::mat4& view = frameInfo.camera.getView();
+		const glm::mat4& projection = frameInfo.camera.getProjection();
+		nearDepth = std::max(frameInfo.camera.getNear(), MIN_CLUSTER_NEAR);
+		const float farDepth = std::max(frameInfo.camera.getFar(), nearDepth * 2.f);
+		slicesPerLogDepth = static_cast<float>(CLUSTER_COUNT_Z) / std::log(farDepth / nearDepth);
+
+		auto sliceOf = [this](float depth) {
+			float slice = std::floor(std::log(depth / nearDepth) * slicesPerLogDepth);
+			return static_cast<uint32_t>(std::clamp(slice, 0.f, static_cast<float>(CLUSTER_COUNT_Z - 1)));
+		};
+
+		viewLights.clear();
+		droppedCount = 0;
+		auto* lights = static_cast<PointLight*>(buffers.lightBuffer->getMappedMemory());
+		for (auto& kv : frameInfo.gameObjects) {
+			auto& obj = kv.second;
+			if (obj.pointLight == nullptr) continue;
+			if (viewLights.size() == MAX_LIGHTS) {
+				droppedCount++;
+				continue;
+			}
+
+			const float intensity = obj.pointLight->lightIntensity;
+			const float range = getLightRange(intensity);
+			lights[viewLights.size()].position = glm::vec4(obj.transform.translation, range);
+			lights[viewLights.size()].color = glm::vec4(obj.color, intensity);
+
+			ViewLight viewLight{ glm::vec3(view * glm::vec4(obj.transform.translation, 1.f)), range, 1, 0 };
+			const float minDepth = viewLight.center.z - range;
+			const float maxDepth = viewLight.center.z + range;
+			if (maxDepth >= nearDepth && minDepth <= farDepth) {
+				viewLight.firstSlice = sliceOf(std::max(minDepth, nearDepth));
+				viewLight.lastSlice = sliceOf(std::min(maxDepth, farDepth));
+			}
+			viewLights.push_back(viewLight);
+		}
+		if (!viewLights.empty()) {
+			buffers.lightBuffer->flush();
+		}
+
+		const uint32_t taskCount = std::min(CLUSTER_COUNT_Z, jobSystem.getWorkerCount() + 1);
+		jobSystem.parallelFor(taskCount, [&](uint32_t task) {
+			for (uint32_t slice = task; slice < CLUSTER_COUNT_Z; slice += taskCount) {
+				binSlice(slice, projection);
+			}
+		});
+
+		lightIndexCount = 0;
+		for (auto& slice : slices) {
+			slice.firstIndex = lightIndexCount;
+			lightIndexCount += static_cast<uint32_t>(slice.lightIndices.size());
+		}
+
+		jobSystem.parallelFor(taskCount, [&](uint32_t task) {
+			for (uint32_t slice = task; slice < CLUSTER_COUNT_Z; slice += taskCount) {
+				writeSlice(slice, buffers);
+			}
+		});
+		for (auto& slice : slices) {
+			droppedCount += slice.droppedCount;
+		}
+		lightIndexCount = std::min(lightIndexCount, MAX_LIGHT_INDICES);
+
+		buffers.clusterBuffer->flush();
+		buffers.lightIndexBuffer->flush();
+
+		ubo.clusterCounts = glm::uvec4(
+			CLUSTER_COUNT_X, CLUSTER_COUNT_Y, CLUSTER_COUNT_Z, static_cast<uint32_t>(viewLights.size()));
+		ubo.clusterDepth = glm::vec4(nearDepth, slicesPerLogDepth, 0.f, 0.f);
+	}
+
+	/**
+	 * @brief Collects the lights reaching every tile of one depth slice.
+	 *
+	 * @param slice Index of the depth slice.
+	 * @param projection The camera's projection matrix.
+	 *
+	 * Each light's view space box is clipped to the slice's depth range and its corners are projected, which gives
+	 * a conservative range of tiles. The entries are then counting sorted by tile, keeping lights in index order.
+	 */
+	void LveLightClusters::binSlice(uint32_t slice, const glm::mat4& projection) {
+		SliceBins& bins = slices[slice];
+		bins.entries.clear();
+		const float sliceNear = nearDepth * std::exp(static_cast<float>(slice) / slicesPerLogDepth);
+		const float sliceFar = nearDepth * std::exp(static_cast<float>(slice + 1) / slicesPerLogDepth);
+
+		for (uint32_t lightIndex = 0; lightIndex < viewLights.size(); lightIndex++) {
+			const ViewLight& light = viewLights[lightIndex];
+			if (slice < light.firstSlice || slice > light.lastSlice) continue;
+
+			const float depths[2] = {
+				std::max(light.center.z - light.range, sliceNear),
+				std::min(light.center.z + light.range, sliceFar) };
+			glm::vec2 ndcMin{ std::numeric_limits<float>::max() };
+			glm::vec2 ndcMax{ std::numeric_limits<float>::lowest() };
+			for (float depth : depths) {
+				// x and y enter the projection linearly and w only depends on depth, so the box's extremes project
+				// to the extremes on screen
+				for (float sx : { -1.f, 1.f }) {
+					for (float sy : { -1.f, 1.f }) {
+						glm::vec4 clip = projection * glm::vec4(
+							light.center.x + sx * light.range, light.center.y + sy * light.range, depth, 1.f);
+						glm::vec2 ndc{ clip.x / clip.w, clip.y / clip.w };
+						ndcMin = glm::min(ndcMin, ndc);
+						ndcMax = glm::max(ndcMax, ndc);
+					}
+				}
+			}
+
+			uint32_t firstX, lastX, firstY, lastY;
+			if (!tileRange(ndcMin.x, ndcMax.x, CLUSTER_COUNT_X, firstX, lastX)
+				|| !tileRange(ndcMin.y, ndcMax.y, CLUSTER_COUNT_Y, firstY, lastY)) {
+				continue;
+			}
+			for (uint32_t y = firstY; y <= lastY; y++) {
+				for (uint32_t x = firstX; x <= lastX; x++) {
+					bins.entries.push_back((static_cast<uint64_t>(y * CLUSTER_COUNT_X + x) << 32) | lightIndex);
+				}
+			}
+		}
+
+		std::fill(bins.tileCounts.begin(), bins.tileCounts.end(), 0u);
+		for (uint64_t entry : bins.entries) {
+			bins.tileCounts[entry >> 32]++;
+		}
+		uint32_t offset = 0;
+		for (uint32_t tile = 0; tile < TILE_COUNT; tile++) {
+			bins.tileOffsets[tile] = offset;
+			offset += bins.tileCounts[tile];
+		}
+		bins.lightIndices.resize(bins.entries.size());
+		for (uint64_t entry : bins.entries) {
+			bins.lightIndices[bins.tileOffsets[entry >> 32]++] = static_cast<uint32_t>(entry);
+		}
+	}
+
+	/**
+	 * @brief Writes the cluster ranges and light indices of one depth slice into the frame's buffers.
+	 *
+	 * @param slice Index of the depth slice, whose firstIndex has been assigned.
+	 * @param buffers The buffers of the frame being built.
+	 */
+	void LveLightClusters::writeSlice(uint32_t slice, FrameBuffers& buffers) {
+		SliceBins& bins = slices[slice];
+		auto* clusters = static_cast<ClusterRange*>(buffers.clusterBuffer->getMappedMemory()) + slice * TILE_COUNT;
+		auto* indices = static_cast<uint32_t*>(buffers.lightIndexBuffer->getMappedMemory());
+
+		bins.droppedCount = 0;
+		uint32_t offset = bins.firstIndex;
+		for (uint32_t tile = 0; tile < TILE_COUNT; tile++) {
+			const uint32_t available = offset < MAX_LIGHT_INDICES ? MAX_LIGHT_INDICES - offset : 0;
+			const uint32_t count = std::min(bins.tileCounts[tile], available);
+			clusters[tile] = ClusterRange{ offset, count };
+			bins.droppedCount += bins.tileCounts[tile] - count;
+			offset += bins.tileCounts[tile];
+		}
+
+		const uint32_t copyCount = bins.firstIndex < MAX_LIGHT_INDICES
+			? std::min(static_cast<uint32_t>(bins.lightIndices.size()), MAX_LIGHT_INDICES - bins.firstIndex)
+			: 0;
+		if (copyCount > 0) {
+			std::memcpy(indices + bins.firstIndex, bins.lightIndices.data(), copyCount * sizeof(uint32_t));
+		}
+	}
+}
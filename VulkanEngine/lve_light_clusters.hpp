@@ -0,0 +1,97 @@
+#pragma once
+
+#include "lve_buffer.hpp"
+#include "lve_device.hpp"
+#include "lve_frame_info.hpp"
+#include "lve_job_system.hpp"
+
+// std
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace lve {
+
+	/**
+	 * Bins the scene's point lights into a 3D grid of view frustum clusters for clustered forward shading.
+	 *
+	 * The grid splits the screen into CLUSTER_COUNT_X x CLUSTER_COUNT_Y tiles and the view depth into
+	 * CLUSTER_COUNT_Z exponentially growing slices. Every light has a finite range of influence, and its view space
+	 * bounds are tested per depth slice so each cluster lists only the lights that can reach it. The fragment
+	 * shader locates its cluster from its position and only iterates that list, so shading cost follows the local
+	 * light density. Slices are binned in parallel on the job system.
+	 *
+	 * Each frame in flight owns three persistently mapped storage buffers: the lights, one (offset, count) pair
+	 * per cluster and the concatenated light index lists. They are bound to set 0 at bindings 1 to 3.
+	 */
+	class LveLightClusters {
+	public:
+		static constexpr uint32_t CLUSTER_COUNT_X = 16;
+		static constexpr uint32_t CLUSTER_COUNT_Y = 9;
+		static constexpr uint32_t CLUSTER_COUNT_Z = 24;
+		static constexpr uint32_t CLUSTER_COUNT = CLUSTER_COUNT_X * CLUSTER_COUNT_Y * CLUSTER_COUNT_Z;
+		// capacity of the index lists, clusters past it lose lights
+		static constexpr uint32_t MAX_LIGHT_INDICES = 256 * 1024;
+
+		LveLightClusters(LveDevice& device, LveJobSystem& jobSystem, uint32_t framesInFlight);
+
+		LveLightClusters(const LveLightClusters&) = delete;
+		LveLightClusters& operator=(const LveLightClusters&) = delete;
+
+		// Distance at which a light of this intensity has faded to a negligible contribution
+		static float getLightRange(float intensity);
+
+		// Gathers the point lights of the frame's game objects, bins them and writes the cluster parameters to ubo
+		void update(FrameInfo& frameInfo, GlobalUbo& ubo);
+
+		VkDescriptorBufferInfo getLightBufferInfo(int frameIndex) { return frames[frameIndex].lightBuffer->descriptorInfo(); }
+		VkDescriptorBufferInfo getClusterBufferInfo(int frameIndex) { return frames[frameIndex].clusterBuffer->descriptorInfo(); }
+		VkDescriptorBufferInfo getLightIndexBufferInfo(int frameIndex) { return frames[frameIndex].lightIndexBuffer->descriptorInfo(); }
+
+		// counts from the most recent update
+		uint32_t getLightCount() const { return static_cast<uint32_t>(viewLights.size()); }
+		uint32_t getLightIndexCount() const { return lightIndexCount; }
+		// lights beyond MAX_LIGHTS and cluster entries beyond MAX_LIGHT_INDICES that were left out
+		uint32_t getDroppedCount() const { return droppedCount; }
+
+	private:
+		struct FrameBuffers {
+			std::unique_ptr<LveBuffer> lightBuffer;
+			std::unique_ptr<LveBuffer> clusterBuffer;
+			std::unique_ptr<LveBuffer> lightIndexBuffer;
+		};
+
+		// view space bounds of a light and the depth slices they touch
+		struct ViewLight {
+			glm::vec3 center;
+			float range;
+			uint32_t firstSlice;
+			uint32_t lastSlice;
+		};
+
+		struct SliceBins {
+			// (tile << 32) | light, before sorting by tile
+			std::vector<uint64_t> entries;
+			std::vector<uint32_t> tileCounts;
+			std::vector<uint32_t> tileOffsets;
+			// sorted by tile, the lights of tile t start at the sum of the counts before it
+			std::vector<uint32_t> lightIndices;
+			uint32_t firstIndex = 0;
+			uint32_t droppedCount = 0;
+		};
+
+		void binSlice(uint32_t slice, const glm::mat4& projection);
+		void writeSlice(uint32_t slice, FrameBuffers& buffers);
+
+		LveDevice& lveDevice;
+		LveJobSystem& jobSystem;
+		std::vector<FrameBuffers> frames;
+
+		float nearDepth = 0.1f;
+		float slicesPerLogDepth = 1.f;
+		std::vector<ViewLight> viewLights;
+		std::vector<SliceBins> slices;
+		uint32_t lightIndexCount = 0;
+		uint32_t droppedCount = 0;
+	};
+}
@@ -16,6 +16,7 @@
 #include <glm/gtx/hash.hpp>
 
 // std
+#include <atomic>
 #include <cassert>
 #include <cstring>
 #include <unordered_map>
@@ -44,8 +45,31 @@ namespace lve {
 	 * @param builder The builder containing the vertices and indices for the model.
 	 */
 	LveModel::LveModel(LveDevice& device, const LveModel::Builder& builder) : lveDevice{ device } {
+		static std::atomic<uint32_t> nextId{ 0 };
+		id = nextId++;
+
 		createVertexBuffers(builder.vertices);
 		createIndexBuffers(builder.indices);
+
+		if (builder.boundingBox.isValid()) {
+			boundingBox = builder.boundingBox;
+			boundingSphere = builder.boundingSphere;
+		} else {
+			// builders filled by hand may not have computed their bounds
+			Builder bounds{};
+			bounds.vertices = builder.vertices;
+			bounds.computeBounds();
+			boundingBox = bounds.boundingBox;
+			boundingSphere = bounds.boundingSphere;
+		}
+
+		auto mesh = std::make_shared<OccluderMesh>();
+		mesh->positions.reserve(builder.vertices.size());
+		for (const auto& vertex : builder.vertices) {
+			mesh->positions.push_back(vertex.position);
+		}
+		mesh->indices = builder.indices;
+		occluderMesh = std::move(mesh);
 	}
 
 	/**
@@ -99,6 +123,36 @@ namespace lve {
 			);
 
 		lveDevice.copyBuffer(stagingBuffer.getBuffer(), vertexBuffer->getBuffer(), bufferSize);
+
+		// a second, position only copy keeps the vertex fetch of depth only passes at 12 bytes per vertex
+		std::vector<glm::vec3> positions;
+		positions.reserve(vertexCount);
+		for (const auto& vertex : vertices) {
+			positions.push_back(vertex.position);
+		}
+		uint32_t positionSize = sizeof(positions[0]);
+
+		LveBuffer positionStagingBuffer{
+			lveDevice,
+			positionSize,
+			vertexCount,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		};
+
+		positionStagingBuffer.map();
+		positionStagingBuffer.writeToBuffer((void*)positions.data());
+
+		positionBuffer = std::make_unique<LveBuffer>(
+			lveDevice,
+			positionSize,
+			vertexCount,
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+			);
+
+		lveDevice.copyBuffer(
+			positionStagingBuffer.getBuffer(), positionBuffer->getBuffer(), static_cast<VkDeviceSize>(positionSize) * vertexCount);
 	}
 
 	/**
@@ -143,13 +197,15 @@ namespace lve {
 	 * @brief Draws the model using the specified command buffer.
 	 *
 	 * @param commandBuffer The command buffer used for issuing the draw commands.
+	 * @param instanceCount The number of instances to draw.
+	 * @param firstInstance The instance index of the first instance, offsets `gl_InstanceIndex` in the shaders.
 	 */
-	void LveModel::draw(VkCommandBuffer commandBuffer) {
+	void LveModel::draw(VkCommandBuffer commandBuffer, uint32_t instanceCount, uint32_t firstInstance) {
 		if (hasIndexBuffer) {
-			vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+			vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, 0, 0, firstInstance);
 		}
 		else {
-			vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+			vkCmdDraw(commandBuffer, vertexCount, instanceCount, 0, firstInstance);
 		}
 	}
 
@@ -168,6 +224,21 @@ namespace lve {
 		}
 	}
 
+	/**
+	 * @brief Binds the model's position only vertex buffer and its index buffer to the command buffer.
+	 *
+	 * @param commandBuffer The command buffer used for binding the buffers.
+	 */
+	void LveModel::bindPositions(VkCommandBuffer commandBuffer) {
+		VkBuffer buffers[] = { positionBuffer->getBuffer() };
+		VkDeviceSize offsets[] = { 0 };
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+
+		if (hasIndexBuffer) {
+			vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+		}
+	}
+
 	/**
 	 * @brief Gets the binding descriptions for the vertex attributes.
 	 *
@@ -197,6 +268,28 @@ namespace lve {
 		return attributeDescriptions;
 	}
 
+	/**
+	 * @brief Gets the binding descriptions for the position only vertex stream.
+	 *
+	 * @return A vector of binding descriptions.
+	 */
+	std::vector<VkVertexInputBindingDescription> LveModel::Vertex::getPositionBindingDescriptions() {
+		std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+		bindingDescriptions[0].binding = 0;
+		bindingDescriptions[0].stride = sizeof(glm::vec3);
+		bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+		return bindingDescriptions;
+	}
+
+	/**
+	 * @brief Gets the attribute descriptions for the position only vertex stream.
+	 *
+	 * @return A vector of attribute descriptions.
+	 */
+	std::vector<VkVertexInputAttributeDescription> LveModel::Vertex::getPositionAttributeDescriptions() {
+		return { { 0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0 } };
+	}
+
 	/**
 	 * @brief Loads a model from an OBJ file.
 	 *
@@ -257,6 +350,34 @@ namespace lve {
 
 			}
 		}
+
+		computeBounds();
+	}
+
+	/**
+	 * @brief Computes the object space bounding box and bounding sphere of the vertices.
+	 *
+	 * The sphere is centered on the box and its radius is the distance to the furthest vertex,
+	 * which is tighter than the half diagonal of the box for rounded meshes.
+	 */
+	void LveModel::Builder::computeBounds() {
+		boundingBox = BoundingBox{};
+		for (const auto& vertex : vertices) {
+			boundingBox.expand(vertex.position);
+		}
+
+		boundingSphere = BoundingSphere{};
+		if (!boundingBox.isValid()) {
+			return;
+		}
+
+		boundingSphere.center = boundingBox.center();
+		float maxDistanceSquared = 0.f;
+		for (const auto& vertex : vertices) {
+			glm::vec3 offset = vertex.position - boundingSphere.center;
+			maxDistanceSquared = glm::max(maxDistanceSquared, glm::dot(offset, offset));
+		}
+		boundingSphere.radius = glm::sqrt(maxDistanceSquared);
 	}
 
 }
\ No newline at end of file
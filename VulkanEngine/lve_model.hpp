@@ -2,6 +2,7 @@
 
 #include "lve_device.hpp"
 #include "lve_buffer.hpp"
+#include "lve_bounds.hpp"
 
 // libs
 #define GLM_FORCE_RADIANS
@@ -24,6 +25,9 @@ namespace lve {
 
 			static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
 			static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+			// tightly packed positions only, the stream bound by bindPositions()
+			static std::vector<VkVertexInputBindingDescription> getPositionBindingDescriptions();
+			static std::vector<VkVertexInputAttributeDescription> getPositionAttributeDescriptions();
 
 			bool operator==(const Vertex& other) const {
 				return position == other.position && color == other.color && normal == other.normal && uv == other.uv;
@@ -33,8 +37,11 @@ namespace lve {
 		struct Builder {
 			std::vector<Vertex> vertices{};
 			std::vector<uint32_t> indices{};
+			BoundingBox boundingBox{};
+			BoundingSphere boundingSphere{};
 
 			void loadModel(const std::string& filepath);
+			void computeBounds();
 		};
 
 		LveModel(LveDevice &device, const LveModel::Builder &builder);
@@ -47,19 +54,38 @@ namespace lve {
 			LveDevice& device, const std::string& filepath);
 
 		void bind(VkCommandBuffer commandBuffer);
-		void draw(VkCommandBuffer commandBuffer);
+		// binds the position only vertex buffer and the index buffer, for depth only passes
+		void bindPositions(VkCommandBuffer commandBuffer);
+		void draw(VkCommandBuffer commandBuffer, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
+
+		// unique per model, used to group draws in render queue sort keys
+		uint32_t getId() const { return id; }
+		uint32_t getVertexCount() const { return vertexCount; }
+		// 0 when the model is drawn without an index buffer
+		uint32_t getIndexCount() const { return hasIndexBuffer ? indexCount : 0; }
+
+		const BoundingBox& getBoundingBox() const { return boundingBox; }
+		const BoundingSphere& getBoundingSphere() const { return boundingSphere; }
+		// CPU copy of the triangles, used when the model is rasterized as an occluder
+		const std::shared_ptr<const OccluderMesh>& getOccluderMesh() const { return occluderMesh; }
 
 	private:
 		void createVertexBuffers(const std::vector<Vertex>& vertices);
 		void createIndexBuffers(const std::vector<uint32_t>& indices);
 
 		LveDevice& lveDevice;
+		uint32_t id;
 
 		std::unique_ptr<LveBuffer> vertexBuffer;
+		std::unique_ptr<LveBuffer> positionBuffer;
 		uint32_t vertexCount;
 
 		bool hasIndexBuffer = false;
 		std::unique_ptr<LveBuffer> indexBuffer;
 		uint32_t indexCount;
+
+		BoundingBox boundingBox;
+		BoundingSphere boundingSphere;
+		std::shared_ptr<const OccluderMesh> occluderMesh;
 	};
 }
\ No newline at end of file
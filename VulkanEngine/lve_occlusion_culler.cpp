@@ -0,0 +1,312 @@
+/**
+ * @file lve_occlusion_culler.cpp
+ * @brief Implementation of the LveOcclusionCuller class, a CPU depth rasterizer used for occlusion culling.
+ *
+ * This file contains occluder setup and near plane clipping, the banded multi-threaded rasterizer and the
+ * depth pyramid build and box test. The rasterizer evaluates four pixels at a time with SSE when the target
+ * supports it and falls back to scalar code otherwise.
+ */
+
+#include "lve_occlusion_culler.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define LVE_OCCLUSION_SSE 1
+#include <xmmintrin.h>
+#endif
+
+namespace lve {
+
+	namespace {
+		// clip space w below this is treated as touching the camera plane
+		constexpr float MIN_CLIP_W = 1e-5f;
+
+		// Edge function a->b written as a * x + b * y + c, positive on the inside of a counter clockwise triangle
+		struct EdgeEquation {
+			float a;
+			float b;
+			float c;
+
+			EdgeEquation(const glm::vec3& v0, const glm::vec3& v1)
+				: a{ v0.y - v1.y }, b{ v1.x - v0.x }, c{ v0.x * v1.y - v0.y * v1.x } {}
+
+			float evaluate(float x, float y) const { return a * x + b * y + c; }
+		};
+	}
+
+	/**
+	 * @brief Allocates the depth buffer and pyramid.
+	 *
+	 * @param jobSystem Job system the rasterization bands are spread over.
+	 * @param width Depth buffer width in pixels, rounded up to a multiple of four.
+	 * @param height Depth buffer height in pixels.
+	 */
+	LveOcclusionCuller::LveOcclusionCuller(LveJobSystem& jobSystem, uint32_t width, uint32_t height)
+		: jobSystem{ jobSystem }, width{ std::max(4u, (width + 3u) & ~3u) }, height{ std::max(1u, height) } {
+		PyramidLevel level{ this->width, this->height };
+		while (true) {
+			levels.push_back(level);
+			depthPyramid.emplace_back(static_cast<size_t>(level.width) * level.height, 1.f);
+			if (level.width == 1 && level.height == 1) break;
+			level.width = (level.width + 1) / 2;
+			level.height = (level.height + 1) / 2;
+		}
+	}
+
+	/**
+	 * @brief Starts a new frame of occluders.
+	 *
+	 * @param viewProjection The camera's projection * view matrix for this frame.
+	 */
+	void LveOcclusionCuller::beginFrame(const glm::mat4& viewProjection) {
+		this->viewProjection = viewProjection;
+		triangles.clear();
+	}
+
+	/**
+	 * @brief Adds an occluder mesh to the current frame.
+	 *
+	 * Triangles are transformed to clip space and clipped against the near plane. Meshes without indices
+	 * are treated as triangle lists over their positions.
+	 *
+	 * @param mesh The occluder in object space.
+	 * @param modelMatrix The object's model matrix.
+	 */
+	void LveOcclusionCuller::addOccluder(const OccluderMesh& mesh, const glm::mat4& modelMatrix) {
+		const glm::mat4 modelViewProjection = viewProjection * modelMatrix;
+		auto toClip = [&](uint32_t index) {
+			return modelViewProjection * glm::vec4(mesh.positions[index], 1.f);
+		};
+
+		if (mesh.indices.empty()) {
+			for (uint32_t i = 0; i + 2 < mesh.positions.size(); i += 3) {
+				addClippedTriangle(toClip(i), toClip(i + 1), toClip(i + 2));
+			}
+		} else {
+			for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+				addClippedTriangle(toClip(mesh.indices[i]), toClip(mesh.indices[i + 1]), toClip(mesh.indices[i + 2]));
+			}
+		}
+	}
+
+	/**
+	 * @brief Clips a clip space triangle against the near plane and stores the result in screen space.
+	 *
+	 * With Vulkan's depth range the near plane is z = 0, every vertex in front of it also has a positive w.
+	 * Far plane and screen edges need no clipping, the rasterizer clamps to the buffer and depth 1 is never
+	 * closer than the cleared value. Triangles are stored with counter clockwise winding so occluders cover
+	 * from both sides.
+	 */
+	void LveOcclusionCuller::addClippedTriangle(const glm::vec4& c0, const glm::vec4& c1, const glm::vec4& c2) {
+		if (c0.z < 0.f && c1.z < 0.f && c2.z < 0.f) return;
+
+		glm::vec4 polygon[4];
+		int vertexCount = 0;
+		const glm::vec4 input[3] = { c0, c1, c2 };
+		for (int i = 0; i < 3; i++) {
+			const glm::vec4& current = input[i];
+			const glm::vec4& next = input[(i + 1) % 3];
+			if (current.z >= 0.f) {
+				polygon[vertexCount++] = current;
+			}
+			if ((current.z >= 0.f) != (next.z >= 0.f)) {
+				float t = current.z / (current.z - next.z);
+				polygon[vertexCount++] = current + (next - current) * t;
+			}
+		}
+
+		auto toScreen = [this](const glm::vec4& clip) {
+			float invW = 1.f / std::max(clip.w, MIN_CLIP_W);
+			return glm::vec3{
+				(clip.x * invW * .5f + .5f) * width,
+				(clip.y * invW * .5f + .5f) * height,
+				clip.z * invW };
+		};
+
+		const glm::vec3 v0 = toScreen(polygon[0]);
+		for (int i = 1; i + 1 < vertexCount; i++) {
+			glm::vec3 v1 = toScreen(polygon[i]);
+			glm::vec3 v2 = toScreen(polygon[i + 1]);
+			float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+			if (area == 0.f) continue;
+			if (area < 0.f) std::swap(v1, v2);
+			triangles.push_back(ScreenTriangle{ v0, v1, v2 });
+		}
+	}
+
+	/**
+	 * @brief Rasterizes all occluders of the frame and rebuilds the depth pyramid.
+	 *
+	 * The buffer is split into one band of rows per available thread. Bands never share pixels, so no
+	 * synchronization is needed and the resulting depth is the same for any band count.
+	 */
+	void LveOcclusionCuller::rasterizeOccluders() {
+		std::fill(depthPyramid[0].begin(), depthPyramid[0].end(), 1.f);
+
+		if (!triangles.empty()) {
+			const uint32_t bandCount = std::min(height, jobSystem.getWorkerCount() + 1);
+			const uint32_t bandHeight = (height + bandCount - 1) / bandCount;
+			jobSystem.parallelFor(bandCount, [this, bandHeight](uint32_t band) {
+				const uint32_t firstRow = band * bandHeight;
+				rasterizeBand(firstRow, std::min(height, firstRow + bandHeight));
+			});
+		}
+
+		buildDepthPyramid();
+	}
+
+	/**
+	 * @brief Rasterizes every triangle into the rows [firstRow, endRow) keeping the nearest depth.
+	 *
+	 * Pixels are sampled at their centers. Rows are walked in groups of four pixels aligned to the buffer,
+	 * pixels of a group outside the triangle's bounds are rejected by the edge functions.
+	 */
+	void LveOcclusionCuller::rasterizeBand(uint32_t firstRow, uint32_t endRow) {
+		std::vector<float>& depth = depthPyramid[0];
+
+		for (const auto& tri : triangles) {
+			const float minX = std::min(tri.v0.x, std::min(tri.v1.x, tri.v2.x));
+			const float maxX = std::max(tri.v0.x, std::max(tri.v1.x, tri.v2.x));
+			const float minY = std::min(tri.v0.y, std::min(tri.v1.y, tri.v2.y));
+			const float maxY = std::max(tri.v0.y, std::max(tri.v1.y, tri.v2.y));
+			if (maxX < 0.f || maxY < 0.f || minX >= static_cast<float>(width) || minY >= static_cast<float>(height)) {
+				continue;
+			}
+
+			const uint32_t x0 = static_cast<uint32_t>(std::max(0.f, std::floor(minX))) & ~3u;
+			const uint32_t x1 = static_cast<uint32_t>(std::min(static_cast<float>(width), std::ceil(maxX) + 1.f));
+			const uint32_t y0 = std::max(firstRow, static_cast<uint32_t>(std::max(0.f, std::floor(minY))));
+			const uint32_t y1 = static_cast<uint32_t>(std::min(static_cast<float>(endRow), std::ceil(maxY) + 1.f));
+			if (y0 >= y1) continue;
+
+			const EdgeEquation e0{ tri.v1, tri.v2 };
+			const EdgeEquation e1{ tri.v2, tri.v0 };
+			const EdgeEquation e2{ tri.v0, tri.v1 };
+			const float area = e0.evaluate(tri.v0.x, tri.v0.y);
+
+			// depth is affine in screen space, interpolate it as a plane z = zA * x + zB * y + zC
+			const float zA = (tri.v0.z * e0.a + tri.v1.z * e1.a + tri.v2.z * e2.a) / area;
+			const float zB = (tri.v0.z * e0.b + tri.v1.z * e1.b + tri.v2.z * e2.b) / area;
+			const float zC = (tri.v0.z * e0.c + tri.v1.z * e1.c + tri.v2.z * e2.c) / area;
+
+			for (uint32_t y = y0; y < y1; y++) {
+				const float py = static_cast<float>(y) + .5f;
+				float* row = depth.data() + static_cast<size_t>(y) * width;
+				// row constants are shared by both paths so they produce bit identical depth
+				const float rowE0 = e0.b * py + e0.c;
+				const float rowE1 = e1.b * py + e1.c;
+				const float rowE2 = e2.b * py + e2.c;
+				const float rowZ = zB * py + zC;
+				uint32_t x = x0;
+#ifdef LVE_OCCLUSION_SSE
+				const __m128 zero = _mm_setzero_ps();
+				const __m128 stepX = _mm_set_ps(3.5f, 2.5f, 1.5f, .5f);
+				for (; x < x1; x += 4) {
+					const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), stepX);
+					const __m128 w0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(e0.a), px), _mm_set1_ps(rowE0));
+					const __m128 w1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(e1.a), px), _mm_set1_ps(rowE1));
+					const __m128 w2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(e2.a), px), _mm_set1_ps(rowE2));
+					const __m128 inside = _mm_and_ps(
+						_mm_and_ps(_mm_cmpge_ps(w0, zero), _mm_cmpge_ps(w1, zero)), _mm_cmpge_ps(w2, zero));
+					if (_mm_movemask_ps(inside) == 0) continue;
+
+					const __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(zA), px), _mm_set1_ps(rowZ));
+					const __m128 previous = _mm_loadu_ps(row + x);
+					const __m128 nearest = _mm_min_ps(previous, z);
+					_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, previous)));
+				}
+#else
+				for (; x < x1; x++) {
+					const float px = static_cast<float>(x) + .5f;
+					if (e0.a * px + rowE0 < 0.f || e1.a * px + rowE1 < 0.f || e2.a * px + rowE2 < 0.f) continue;
+					row[x] = std::min(row[x], zA * px + rowZ);
+				}
+#endif
+			}
+		}
+	}
+
+	/**
+	 * @brief Builds every pyramid level from the one below by taking the max depth of each 2x2 block.
+	 *
+	 * Odd sized levels clamp to the last row or column so edge texels still cover all of their pixels.
+	 */
+	void LveOcclusionCuller::buildDepthPyramid() {
+		for (size_t i = 1; i < levels.size(); i++) {
+			const PyramidLevel& source = levels[i - 1];
+			const PyramidLevel& target = levels[i];
+			const std::vector<float>& sourceDepth = depthPyramid[i - 1];
+			std::vector<float>& targetDepth = depthPyramid[i];
+
+			for (uint32_t y = 0; y < target.height; y++) {
+				const uint32_t sy0 = y * 2;
+				const uint32_t sy1 = std::min(sy0 + 1, source.height - 1);
+				for (uint32_t x = 0; x < target.width; x++) {
+					const uint32_t sx0 = x * 2;
+					const uint32_t sx1 = std::min(sx0 + 1, source.width - 1);
+					targetDepth[static_cast<size_t>(y) * target.width + x] = std::max(
+						std::max(sourceDepth[sy0 * source.width + sx0], sourceDepth[sy0 * source.width + sx1]),
+						std::max(sourceDepth[sy1 * source.width + sx0], sourceDepth[sy1 * source.width + sx1]));
+				}
+			}
+		}
+	}
+
+	/**
+	 * @brief Tests a world space box against the occluders rasterized this frame.
+	 *
+	 * The box's corners are projected to find its screen rectangle and nearest depth. The pyramid level
+	 * where that rectangle spans at most 2x2 texels is compared against the nearest depth, the box is
+	 * occluded only if it lies behind the furthest occluder depth of every covered texel. Boxes crossing
+	 * the near plane or leaving the screen are always reported as visible.
+	 *
+	 * @param worldBox The box to test.
+	 * @return True if any part of the box may be visible.
+	 */
+	bool LveOcclusionCuller::isVisible(const BoundingBox& worldBox) const {
+		if (!worldBox.isValid()) return true;
+
+		glm::vec3 ndcMin{ std::numeric_limits<float>::max() };
+		glm::vec3 ndcMax{ -std::numeric_limits<float>::max() };
+		for (int i = 0; i < 8; i++) {
+			const glm::vec3 corner{
+				(i & 1) ? worldBox.max.x : worldBox.min.x,
+				(i & 2) ? worldBox.max.y : worldBox.min.y,
+				(i & 4) ? worldBox.max.z : worldBox.min.z };
+			const glm::vec4 clip = viewProjection * glm::vec4(corner, 1.f);
+			if (clip.w <= MIN_CLIP_W) return true;
+			const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+			ndcMin = glm::min(ndcMin, ndc);
+			ndcMax = glm::max(ndcMax, ndc);
+		}
+
+		if (ndcMin.z <= 0.f) return true;
+		if (ndcMin.x < -1.f || ndcMax.x > 1.f || ndcMin.y < -1.f || ndcMax.y > 1.f) return true;
+
+		const float maxX = static_cast<float>(width - 1);
+		const float maxY = static_cast<float>(height - 1);
+		const uint32_t x0 = static_cast<uint32_t>(std::min(maxX, (ndcMin.x * .5f + .5f) * width));
+		const uint32_t x1 = static_cast<uint32_t>(std::min(maxX, (ndcMax.x * .5f + .5f) * width));
+		const uint32_t y0 = static_cast<uint32_t>(std::min(maxY, (ndcMin.y * .5f + .5f) * height));
+		const uint32_t y1 = static_cast<uint32_t>(std::min(maxY, (ndcMax.y * .5f + .5f) * height));
+
+		uint32_t level = 0;
+		while (level + 1 < levels.size() && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1)) {
+			level++;
+		}
+
+		const PyramidLevel& size = levels[level];
+		const std::vector<float>& levelDepth = depthPyramid[level];
+		float occluderDepth = 0.f;
+		for (uint32_t y = y0 >> level; y <= (y1 >> level); y++) {
+			for (uint32_t x = x0 >> level; x <= (x1 >> level); x++) {
+				occluderDepth = std::max(occluderDepth, levelDepth[static_cast<size_t>(y) * size.width + x]);
+			}
+		}
+		return ndcMin.z <= occluderDepth;
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "lve_bounds.hpp"
+#include "lve_job_system.hpp"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+	/**
+	 * Software occlusion culling against a low resolution depth buffer rasterized on the CPU.
+	 *
+	 * Each frame the designated occluders are rasterized into the depth buffer in horizontal bands, one
+	 * band per job, and a max depth pyramid is built on top of it. Boxes are then projected to screen and
+	 * compared against the pyramid level where they cover at most 2x2 texels. Results only depend on the
+	 * submitted geometry, so they are identical regardless of how many workers the job system has.
+	 */
+	class LveOcclusionCuller {
+	public:
+		// width is rounded up to a multiple of four so rows can be processed four pixels at a time
+		LveOcclusionCuller(LveJobSystem& jobSystem, uint32_t width = 256, uint32_t height = 128);
+
+		LveOcclusionCuller(const LveOcclusionCuller&) = delete;
+		LveOcclusionCuller& operator=(const LveOcclusionCuller&) = delete;
+
+		// Clears the occluders of the previous frame
+		void beginFrame(const glm::mat4& viewProjection);
+		// Transforms and clips the mesh triangles, nothing is rasterized until rasterizeOccluders()
+		void addOccluder(const OccluderMesh& mesh, const glm::mat4& modelMatrix);
+		// Rasterizes all added occluders and builds the depth pyramid
+		void rasterizeOccluders();
+
+		// False only if the whole world space box is behind rasterized occluders
+		bool isVisible(const BoundingBox& worldBox) const;
+
+		uint32_t getWidth() const { return width; }
+		uint32_t getHeight() const { return height; }
+		uint32_t getOccluderTriangleCount() const { return static_cast<uint32_t>(triangles.size()); }
+		// depth in [0, 1] per pixel, row major with the first row at the top of the screen
+		const std::vector<float>& getDepthBuffer() const { return depthPyramid[0]; }
+
+	private:
+		// x and y in pixels, z the depth in [0, 1]
+		struct ScreenTriangle {
+			glm::vec3 v0;
+			glm::vec3 v1;
+			glm::vec3 v2;
+		};
+
+		struct PyramidLevel {
+			uint32_t width;
+			uint32_t height;
+		};
+
+		void addClippedTriangle(const glm::vec4& c0, const glm::vec4& c1, const glm::vec4& c2);
+		void rasterizeBand(uint32_t firstRow, uint32_t endRow);
+		void buildDepthPyramid();
+
+		LveJobSystem& jobSystem;
+		uint32_t width;
+		uint32_t height;
+
+		glm::mat4 viewProjection{ 1.f };
+		std::vector<ScreenTriangle> triangles;
+		// level 0 is the full resolution depth buffer, every further level stores the max of 2x2 texels
+		std::vector<std::vector<float>> depthPyramid;
+		std::vector<PyramidLevel> levels;
+	};
+}
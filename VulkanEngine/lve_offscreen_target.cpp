@@ -0,0 +1,163 @@
+/**
+ * @file lve_offscreen_target.cpp
+ * @brief Implementation of the LveOffscreenTarget class, the swap chain replacement of headless rendering.
+ *
+ * This file contains the creation of the per frame color images, the shared depth buffer and their render pass,
+ * and the fence based submission of frames that are never presented.
+ */
+
+#include "lve_offscreen_target.hpp"
+
+// std
+#include <array>
+#include <limits>
+#include <stdexcept>
+
+namespace lve {
+
+	/**
+	 * @brief Creates the render pass, the images and the frame fences.
+	 *
+	 * @param device The device the images are created on, usually a headless one.
+	 * @param extent Size of the rendered images.
+	 * @param framesInFlight Number of frames the renderer keeps in flight, each gets its own color image.
+	 */
+	LveOffscreenTarget::LveOffscreenTarget(LveDevice& device, VkExtent2D extent, uint32_t framesInFlight)
+		: lveDevice{ device }, extent{ extent }, framesInFlight{ framesInFlight } {
+		depthFormat = lveDevice.findSupportedFormat(
+			{ VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+		// the color image is left ready to be copied out after the pass
+		renderPass = createColorDepthRenderPass(
+			lveDevice, COLOR_FORMAT, depthFormat, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+		depth = createTransientDepthImage(lveDevice, depthFormat, extent);
+		createFrames();
+	}
+
+	LveOffscreenTarget::~LveOffscreenTarget() {
+		for (auto& frame : frames) {
+			vkDestroyFence(lveDevice.device(), frame.inFlightFence, nullptr);
+			vkDestroyFramebuffer(lveDevice.device(), frame.framebuffer, nullptr);
+			destroyAttachmentImage(lveDevice, frame.color);
+		}
+		destroyAttachmentImage(lveDevice, depth);
+		vkDestroyRenderPass(lveDevice.device(), renderPass, nullptr);
+	}
+
+	void LveOffscreenTarget::waitForFrame(int frameIndex) {
+		auto waitStart = std::chrono::high_resolution_clock::now();
+		vkWaitForFences(
+			lveDevice.device(),
+			1,
+			&frames[frameIndex].inFlightFence,
+			VK_TRUE,
+			std::numeric_limits<uint64_t>::max());
+		fenceWaitTime = std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - waitStart).count();
+	}
+
+	/**
+	 * @brief Submits the frame's command buffer, signaling the frame's fence when it completes.
+	 *
+	 * Nothing is presented, so unlike the swap chain no semaphores are involved: the render pass dependencies
+	 * order the frames on the graphics queue and the fence tells the CPU when the frame's images may be reused.
+	 */
+	void LveOffscreenTarget::submitCommandBuffers(const VkCommandBuffer* buffers, int frameIndex) {
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = buffers;
+
+		vkResetFences(lveDevice.device(), 1, &frames[frameIndex].inFlightFence);
+		if (vkQueueSubmit(lveDevice.graphicsQueue(), 1, &submitInfo, frames[frameIndex].inFlightFence) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to submit offscreen command buffer!");
+		}
+		frames[frameIndex].lastSerial = submittedCount++;
+		lastSubmitTime = std::chrono::high_resolution_clock::now();
+	}
+
+	/**
+	 * @brief Checks without blocking whether a submission has completed.
+	 *
+	 * @param serial The submission's serial, counted from 0 in submission order.
+	 *
+	 * Frames use their slots round robin, so the serial determines the frame whose fence it signaled. If that
+	 * frame has been submitted again since, the earlier submission was waited for before the fence was reset.
+	 */
+	bool LveOffscreenTarget::isSubmissionComplete(uint64_t serial) {
+		if (serial >= submittedCount) return false;
+		const FrameImages& frame = frames[serial % framesInFlight];
+		if (frame.lastSerial != serial) return true;
+		return vkGetFenceStatus(lveDevice.device(), frame.inFlightFence) == VK_SUCCESS;
+	}
+
+	/**
+	 * @brief Blocks until a submission has completed.
+	 *
+	 * @param serial The serial of a submission that has been made.
+	 *
+	 * Fences are only reset when their frame is submitted again, so this may be called while a frame is being
+	 * recorded without waiting on its unsubmitted work.
+	 */
+	void LveOffscreenTarget::waitForSubmission(uint64_t serial) {
+		if (serial >= submittedCount) {
+			throw std::runtime_error("Cannot wait for a frame that has not been submitted!");
+		}
+		const FrameImages& frame = frames[serial % framesInFlight];
+		if (frame.lastSerial != serial) return;
+		vkWaitForFences(
+			lveDevice.device(),
+			1,
+			&frame.inFlightFence,
+			VK_TRUE,
+			std::numeric_limits<uint64_t>::max());
+	}
+
+	void LveOffscreenTarget::waitForAllFrames() {
+		std::vector<VkFence> fences;
+		fences.reserve(frames.size());
+		for (auto& frame : frames) {
+			fences.push_back(frame.inFlightFence);
+		}
+		vkWaitForFences(
+			lveDevice.device(),
+			static_cast<uint32_t>(fences.size()),
+			fences.data(),
+			VK_TRUE,
+			std::numeric_limits<uint64_t>::max());
+	}
+
+	void LveOffscreenTarget::createFrames() {
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+		frames.resize(framesInFlight);
+		for (auto& frame : frames) {
+			frame.color = createAttachmentImage(
+				lveDevice,
+				COLOR_FORMAT,
+				extent,
+				VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+				VK_IMAGE_ASPECT_COLOR_BIT);
+
+			std::array<VkImageView, 2> attachments = { frame.color.view, depth.view };
+			VkFramebufferCreateInfo framebufferInfo{};
+			framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+			framebufferInfo.renderPass = renderPass;
+			framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+			framebufferInfo.pAttachments = attachments.data();
+			framebufferInfo.width = extent.width;
+			framebufferInfo.height = extent.height;
+			framebufferInfo.layers = 1;
+			if (vkCreateFramebuffer(lveDevice.device(), &framebufferInfo, nullptr, &frame.framebuffer) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to create offscreen framebuffer!");
+			}
+
+			if (vkCreateFence(lveDevice.device(), &fenceInfo, nullptr, &frame.inFlightFence) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to create offscreen frame fence!");
+			}
+		}
+	}
+}
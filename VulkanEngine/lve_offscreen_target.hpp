@@ -0,0 +1,83 @@
+#pragma once
+
+#include "lve_attachments.hpp"
+#include "lve_device.hpp"
+
+// std
+#include <chrono>
+#include <vector>
+
+namespace lve {
+
+	/**
+	 * Offscreen color and depth images standing in for the swap chain when rendering without a display.
+	 *
+	 * Every frame in flight owns a color image and framebuffer, and all of them share one depth buffer like the
+	 * swap chain images do. Frames never wait on an image being presented, only on their own fence, so the image
+	 * index is the frame index. The render pass leaves the color image in the transfer source layout, ready to
+	 * be copied out after the pass, and uses the same attachment setup as the swap chain's, so the render
+	 * systems are created for it unchanged.
+	 */
+	class LveOffscreenTarget {
+	public:
+		// 8 bit sRGB like the swap chain, in the byte order image files expect
+		static constexpr VkFormat COLOR_FORMAT = VK_FORMAT_R8G8B8A8_SRGB;
+
+		LveOffscreenTarget(LveDevice& device, VkExtent2D extent, uint32_t framesInFlight);
+		~LveOffscreenTarget();
+
+		LveOffscreenTarget(const LveOffscreenTarget&) = delete;
+		LveOffscreenTarget& operator=(const LveOffscreenTarget&) = delete;
+
+		VkRenderPass getRenderPass() const { return renderPass; }
+		VkFramebuffer getFrameBuffer(int frameIndex) const { return frames[frameIndex].framebuffer; }
+		VkImage getImage(int frameIndex) const { return frames[frameIndex].color.image; }
+		VkFormat getColorFormat() const { return COLOR_FORMAT; }
+		VkFormat getDepthFormat() const { return depthFormat; }
+		VkExtent2D getExtent() const { return extent; }
+		float extentAspectRatio() const {
+			return static_cast<float>(extent.width) / static_cast<float>(extent.height);
+		}
+		uint32_t getFramesInFlight() const { return framesInFlight; }
+
+		// Blocks until the frame's previous submission has completed
+		void waitForFrame(int frameIndex);
+		void submitCommandBuffers(const VkCommandBuffer* buffers, int frameIndex);
+		// Blocks until every submitted frame has completed
+		void waitForAllFrames();
+		// number of frames submitted so far, the serial the next submission gets
+		uint64_t getSubmittedCount() const { return submittedCount; }
+		// Non blocking check whether the submission with the given serial has completed
+		bool isSubmissionComplete(uint64_t serial);
+		// Blocks until the submission with the given serial has completed
+		void waitForSubmission(uint64_t serial);
+
+		// seconds the CPU blocked on the frame fence for the latest frame
+		float getFenceWaitTime() const { return fenceWaitTime; }
+		// when the latest frame's command buffers were handed to the queue
+		std::chrono::high_resolution_clock::time_point getLastSubmitTime() const { return lastSubmitTime; }
+
+	private:
+		struct FrameImages {
+			LveAttachmentImage color;
+			VkFramebuffer framebuffer = VK_NULL_HANDLE;
+			VkFence inFlightFence = VK_NULL_HANDLE;
+			uint64_t lastSerial = 0; // serial of the latest submission signaling inFlightFence
+		};
+
+		void createFrames();
+
+		LveDevice& lveDevice;
+		VkExtent2D extent;
+		uint32_t framesInFlight;
+		VkFormat depthFormat;
+
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+		std::vector<FrameImages> frames;
+		LveAttachmentImage depth;
+
+		uint64_t submittedCount = 0;
+		float fenceWaitTime = 0.f;
+		std::chrono::high_resolution_clock::time_point lastSubmitTime{};
+	};
+}
@@ -1,7 +1,10 @@
 #include "lve_pipeline.hpp"
 #include "lve_model.hpp"
+#include "lve_utils.hpp"
 
 //std
+#include <atomic>
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <stdexcept>
@@ -14,7 +17,7 @@ namespace lve {
 	 *
 	 * @param device The Vulkan device to use.
 	 * @param vertFilePath The file path to the vertex shader.
-	 * @param fragFilePath The file path to the fragment shader.
+	 * @param fragFilePath The file path to the fragment shader, empty for depth only pipelines without one.
 	 * @param configInfo The configuration information for the pipeline.
 	 */
 	LvePipeline::LvePipeline(
@@ -25,13 +28,33 @@ namespace lve {
 		createGraphicsPipeline(vertFilePath, fragFilePath, configInfo);
 	}
 
+	/**
+	 * @brief Constructs a new compute LvePipeline object.
+	 *
+	 * @param device The Vulkan device to use.
+	 * @param compFilePath The file path to the compute shader.
+	 * @param pipelineLayout The layout of the resources the compute shader uses.
+	 */
+	LvePipeline::LvePipeline(
+		LveDevice& device,
+		const std::string& compFilePath,
+		VkPipelineLayout pipelineLayout) : lveDevice{ device }, bindPoint{ VK_PIPELINE_BIND_POINT_COMPUTE } {
+		createComputePipeline(compFilePath, pipelineLayout);
+	}
+
+	uint32_t LvePipeline::nextId() {
+		static std::atomic<uint32_t> counter{ 0 };
+		return counter++;
+	}
+
 	/**
 	 * @brief Destructor for LvePipeline.
 	 */
 	LvePipeline::~LvePipeline() {
 		vkDestroyShaderModule(lveDevice.device(), vertShaderModule, nullptr);
 		vkDestroyShaderModule(lveDevice.device(), fragShaderModule, nullptr);
-		vkDestroyPipeline(lveDevice.device(), graphicsPipeline, nullptr);
+		vkDestroyShaderModule(lveDevice.device(), compShaderModule, nullptr);
+		vkDestroyPipeline(lveDevice.device(), pipeline, nullptr);
 	}
 
 	/**
@@ -69,17 +92,32 @@ namespace lve {
 		const std::string& fragFilePath,
 		const PipelineConfigInfo& configInfo) {
 
-		std::cout << "Creating Graphics Pipeline..." << std::endl;
+		{
+			// pipelines are compiled on worker threads while the render loop reports its statistics
+			std::lock_guard<std::mutex> lock{ getLogMutex() };
+			std::cout << "Creating Graphics Pipeline..." << std::endl;
+		}
 
 		assert(configInfo.pipelineLayout != VK_NULL_HANDLE &&
 			"Cannot create grahpics pipeline:: no pipelineLayout provided in configInfo");
 		assert(configInfo.renderPass != VK_NULL_HANDLE &&
 			"Cannot create grahpics pipeline:: no renderPass provided in configInfo");
 		auto vertCode = readFile(vertFilePath);
-		auto fragCode = readFile(fragFilePath);
-
 		createShaderModule(vertCode, &vertShaderModule);
-		createShaderModule(fragCode, &fragShaderModule);
+		// depth only pipelines have no fragment stage
+		const bool hasFragmentStage = !fragFilePath.empty();
+		if (hasFragmentStage) {
+			auto fragCode = readFile(fragFilePath);
+			createShaderModule(fragCode, &fragShaderModule);
+		}
+
+		VkSpecializationInfo specializationInfo{};
+		specializationInfo.mapEntryCount = static_cast<uint32_t>(configInfo.specializationEntries.size());
+		specializationInfo.pMapEntries = configInfo.specializationEntries.data();
+		specializationInfo.dataSize = configInfo.specializationData.size();
+		specializationInfo.pData = configInfo.specializationData.data();
+		const VkSpecializationInfo* stageSpecialization =
+			configInfo.specializationEntries.empty() ? nullptr : &specializationInfo;
 
 		VkPipelineShaderStageCreateInfo shaderStages[2];
 		shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -88,7 +126,7 @@ namespace lve {
 		shaderStages[0].pName = "main";
 		shaderStages[0].flags = 0;
 		shaderStages[0].pNext = nullptr;
-		shaderStages[0].pSpecializationInfo = nullptr;
+		shaderStages[0].pSpecializationInfo = stageSpecialization;
 
 		shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 		shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
@@ -96,7 +134,7 @@ namespace lve {
 		shaderStages[1].pName = "main";
 		shaderStages[1].flags = 0;
 		shaderStages[1].pNext = nullptr;
-		shaderStages[1].pSpecializationInfo = nullptr;
+		shaderStages[1].pSpecializationInfo = stageSpecialization;
 
 		auto& bindingDescriptions = configInfo.bindingDescriptions;
 		auto& attributeDescriptions = configInfo.attributeDescriptions;
@@ -113,7 +151,7 @@ namespace lve {
 
 		VkGraphicsPipelineCreateInfo pipelineInfo{};
 		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-		pipelineInfo.stageCount = 2;
+		pipelineInfo.stageCount = hasFragmentStage ? 2 : 1;
 		pipelineInfo.pStages = shaderStages;
 		pipelineInfo.pVertexInputState = &vertexInputInfo;
 		pipelineInfo.pInputAssemblyState = &configInfo.inputAssemblyInfo;
@@ -131,17 +169,52 @@ namespace lve {
 		pipelineInfo.basePipelineIndex = -1;
 		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
+		auto createStart = std::chrono::high_resolution_clock::now();
 		if (vkCreateGraphicsPipelines(
 			lveDevice.device(),
-			VK_NULL_HANDLE,
+			lveDevice.getPipelineCache(),
 			1,
 			&pipelineInfo,
 			nullptr,
-			&graphicsPipeline) != VK_SUCCESS) {
+			&pipeline) != VK_SUCCESS) {
 			throw std::runtime_error("Failed to create graphics pipeline");
 		}
+		float createMs = std::chrono::duration<float, std::milli>(
+			std::chrono::high_resolution_clock::now() - createStart).count();
+
+		std::lock_guard<std::mutex> lock{ getLogMutex() };
+		std::cout << "Graphics Pipeline created successfully in " << createMs << " ms ("
+			<< (lveDevice.isPipelineCacheWarm() ? "warm" : "cold") << " pipeline cache)" << std::endl;
+	}
+
+	/**
+	 * @brief Creates the compute pipeline.
+	 *
+	 * @param compFilePath The file path to the compute shader.
+	 * @param pipelineLayout The layout of the resources the compute shader uses.
+	 */
+	void LvePipeline::createComputePipeline(const std::string& compFilePath, VkPipelineLayout pipelineLayout) {
+		assert(pipelineLayout != VK_NULL_HANDLE && "Cannot create compute pipeline:: no pipelineLayout provided");
+		auto compCode = readFile(compFilePath);
+		createShaderModule(compCode, &compShaderModule);
+
+		VkPipelineShaderStageCreateInfo shaderStage{};
+		shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		shaderStage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		shaderStage.module = compShaderModule;
+		shaderStage.pName = "main";
+
+		VkComputePipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage = shaderStage;
+		pipelineInfo.layout = pipelineLayout;
+		pipelineInfo.basePipelineIndex = -1;
+		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-		std::cout << "Graphics Pipeline created successfully" << std::endl;
+		if (vkCreateComputePipelines(lveDevice.device(), lveDevice.getPipelineCache(), 1, &pipelineInfo, nullptr, &pipeline) !=
+			VK_SUCCESS) {
+			throw std::runtime_error("Failed to create compute pipeline");
+		}
 	}
 
 	/**
@@ -167,7 +240,7 @@ namespace lve {
 	 * @param commandBuffer The command buffer to bind to.
 	 */
 	void LvePipeline::bind(VkCommandBuffer commandBuffer) {
-		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+		vkCmdBindPipeline(commandBuffer, bindPoint, pipeline);
 	}
 
 	/**
@@ -254,4 +327,22 @@ namespace lve {
 		configInfo.bindingDescriptions = LveModel::Vertex::getBindingDescriptions();
 		configInfo.attributeDescriptions = LveModel::Vertex::getAttributeDescriptions();
 	}
+
+	/**
+	 * @brief Enables standard alpha blending on a pipeline configuration.
+	 *
+	 * @param configInfo The configuration to modify, usually populated by defaultPipelineConfigInfo() first.
+	 */
+	void LvePipeline::enableAlphaBlending(PipelineConfigInfo& configInfo) {
+		configInfo.colorBlendAttachment.blendEnable = VK_TRUE;
+		configInfo.colorBlendAttachment.colorWriteMask =
+			VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT |
+			VK_COLOR_COMPONENT_A_BIT;
+		configInfo.colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+		configInfo.colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+		configInfo.colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+		configInfo.colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+		configInfo.colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+		configInfo.colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+	}
 }
\ No newline at end of file
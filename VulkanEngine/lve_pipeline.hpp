@@ -3,7 +3,10 @@
 #include "lve_device.hpp"
 
 // std
+#include <cstdint>
+#include <cstring>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 namespace lve {
@@ -25,6 +28,27 @@ namespace lve {
 		VkPipelineLayout pipelineLayout = nullptr;
 		VkRenderPass renderPass = nullptr;
 		uint32_t subpass = 0;
+
+		// specialization constants handed to every shader stage, stages ignore ids they do not declare
+		std::vector<VkSpecializationMapEntry> specializationEntries{};
+		std::vector<uint8_t> specializationData{};
+
+		// bool is stored as the VkBool32 that shader bool constants expect
+		template <typename T>
+		void setSpecializationConstant(uint32_t constantId, const T& value) {
+			if constexpr (std::is_same_v<T, bool>) {
+				setSpecializationConstant(constantId, static_cast<VkBool32>(value ? VK_TRUE : VK_FALSE));
+			} else {
+				static_assert(std::is_trivially_copyable_v<T>, "Specialization constants are copied bytewise.");
+				VkSpecializationMapEntry entry{};
+				entry.constantID = constantId;
+				entry.offset = static_cast<uint32_t>(specializationData.size());
+				entry.size = sizeof(T);
+				specializationEntries.push_back(entry);
+				specializationData.resize(specializationData.size() + sizeof(T));
+				std::memcpy(specializationData.data() + entry.offset, &value, sizeof(T));
+			}
+		}
 	};
 
 
@@ -36,6 +60,12 @@ namespace lve {
 			const std::string& fragFilePath,
 			const PipelineConfigInfo& configInfo
 		);
+		// compute pipeline
+		LvePipeline(
+			LveDevice& device,
+			const std::string& compFilePath,
+			VkPipelineLayout pipelineLayout
+		);
 		~LvePipeline();
 
 		LvePipeline(const LvePipeline&) = delete;
@@ -43,10 +73,16 @@ namespace lve {
 
 		void bind(VkCommandBuffer commandBuffer);
 
+		// unique per pipeline, used to group draws in render queue sort keys
+		uint32_t getId() const { return id; }
+
 		static void defaultPipelineConfigInfo(PipelineConfigInfo& configInfo);
+		// Blends the color attachment with the fragment's alpha, for transparent geometry drawn back to front
+		static void enableAlphaBlending(PipelineConfigInfo& configInfo);
 
 	private:
 		static std::vector<char> readFile(const std::string& filePath);
+		static uint32_t nextId();
 
 		void createGraphicsPipeline(
 			const std::string& vertFilePath,
@@ -54,11 +90,16 @@ namespace lve {
 			const PipelineConfigInfo& configInfo
 		);
 
+		void createComputePipeline(const std::string& compFilePath, VkPipelineLayout pipelineLayout);
+
 		void createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule);
 
 		LveDevice& lveDevice;
-		VkPipeline graphicsPipeline;
-		VkShaderModule vertShaderModule;
-		VkShaderModule fragShaderModule;
+		VkPipeline pipeline;
+		uint32_t id = nextId();
+		VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		VkShaderModule vertShaderModule = VK_NULL_HANDLE;
+		VkShaderModule fragShaderModule = VK_NULL_HANDLE;
+		VkShaderModule compShaderModule = VK_NULL_HANDLE;
 	};
 }
\ No newline at end of file
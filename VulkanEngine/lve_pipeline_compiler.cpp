@@ -0,0 +1,109 @@
+/**
+ * @file lve_pipeline_compiler.cpp
+ * @brief Implementation of the LvePipelineCompiler class, pipeline creation on worker threads.
+ *
+ * This file contains the jobs that build pipeline configurations and create pipelines on the job system, and the
+ * non blocking access to their results through LveAsyncPipeline.
+ */
+
+#include "lve_pipeline_compiler.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+
+namespace lve {
+
+	/**
+	 * @brief Returns the compiled pipeline, or null while it is still being compiled.
+	 *
+	 * Rethrows the exception of a failed compilation.
+	 */
+	LvePipeline* LveAsyncPipeline::get() {
+		if (pipeline != nullptr) return pipeline.get();
+		if (!isReady()) return nullptr;
+		pipeline = future.get();
+		return pipeline.get();
+	}
+
+	bool LveAsyncPipeline::isReady() const {
+		return future.valid() && future.wait_for(std::chrono::seconds{ 0 }) == std::future_status::ready;
+	}
+
+	void LveAsyncPipeline::wait() const {
+		if (future.valid()) {
+			future.wait();
+		}
+	}
+
+	LvePipelineCompiler::LvePipelineCompiler(LveDevice& device, LveJobSystem& jobSystem)
+		: lveDevice{ device }, jobSystem{ jobSystem } {}
+
+	LvePipelineCompiler::~LvePipelineCompiler() {
+		waitIdle();
+	}
+
+	/**
+	 * @brief Queues a graphics pipeline for compilation.
+	 *
+	 * @param vertFilePath The compiled vertex shader.
+	 * @param fragFilePath The compiled fragment shader, empty for a depth only pipeline.
+	 * @param configure Adjusts the default configuration, it runs on a worker thread.
+	 * @return The pending pipeline.
+	 */
+	LveAsyncPipeline LvePipelineCompiler::compileGraphics(
+		const std::string& vertFilePath, const std::string& fragFilePath, ConfigureFunction configure) {
+		LveDevice& device = lveDevice;
+		return track(jobSystem.submit([&device, vertFilePath, fragFilePath, configure]() {
+			// configurations point into themselves, so each is built where it is used instead of being copied
+			PipelineConfigInfo configInfo{};
+			LvePipeline::defaultPipelineConfigInfo(configInfo);
+			configure(configInfo);
+			return std::make_shared<LvePipeline>(device, vertFilePath, fragFilePath, configInfo);
+		}).share());
+	}
+
+	/**
+	 * @brief Queues a compute pipeline for compilation.
+	 *
+	 * @param compFilePath The compiled compute shader.
+	 * @param pipelineLayout The layout the pipeline is created with.
+	 * @return The pending pipeline.
+	 */
+	LveAsyncPipeline LvePipelineCompiler::compileCompute(const std::string& compFilePath, VkPipelineLayout pipelineLayout) {
+		LveDevice& device = lveDevice;
+		return track(jobSystem.submit([&device, compFilePath, pipelineLayout]() {
+			return std::make_shared<LvePipeline>(device, compFilePath, pipelineLayout);
+		}).share());
+	}
+
+	void LvePipelineCompiler::waitIdle() {
+		std::vector<LveAsyncPipeline::Future> waiting;
+		{
+			std::lock_guard<std::mutex> lock{ pendingMutex };
+			waiting.swap(pending);
+		}
+		for (auto& future : waiting) {
+			future.wait();
+		}
+	}
+
+	uint32_t LvePipelineCompiler::getPendingCount() {
+		std::lock_guard<std::mutex> lock{ pendingMutex };
+		return static_cast<uint32_t>(std::count_if(pending.begin(), pending.end(), [](const auto& future) {
+			return future.wait_for(std::chrono::seconds{ 0 }) != std::future_status::ready;
+		}));
+	}
+
+	LveAsyncPipeline LvePipelineCompiler::track(LveAsyncPipeline::Future future) {
+		std::lock_guard<std::mutex> lock{ pendingMutex };
+		// forget finished compilations so the list only grows with outstanding work
+		pending.erase(
+			std::remove_if(pending.begin(), pending.end(), [](const auto& pendingFuture) {
+				return pendingFuture.wait_for(std::chrono::seconds{ 0 }) == std::future_status::ready;
+			}),
+			pending.end());
+		pending.push_back(future);
+		return LveAsyncPipeline{ std::move(future) };
+	}
+}
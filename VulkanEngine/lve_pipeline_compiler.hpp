@@ -0,0 +1,78 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_job_system.hpp"
+#include "lve_pipeline.hpp"
+
+// std
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+	/**
+	 * A pipeline that is being compiled on the job system.
+	 *
+	 * get() never blocks, it returns null until the pipeline is ready and rethrows the error of a failed
+	 * compilation. The result is cached on first success, so get() must only be called from one thread at a time;
+	 * render systems resolve their pipelines once per frame before recording in parallel.
+	 */
+	class LveAsyncPipeline {
+	public:
+		using Future = std::shared_future<std::shared_ptr<LvePipeline>>;
+
+		LveAsyncPipeline() = default;
+		explicit LveAsyncPipeline(Future future) : future{ std::move(future) } {}
+
+		LvePipeline* get();
+		bool isReady() const;
+		// blocks until the compilation finished, successful or not
+		void wait() const;
+
+	private:
+		Future future;
+		std::shared_ptr<LvePipeline> pipeline;
+	};
+
+	/**
+	 * Compiles pipelines on the job system's worker threads.
+	 *
+	 * All pipelines share the device's pipeline cache, which drivers synchronize internally, so any number can
+	 * be compiled at once. Callers get an LveAsyncPipeline back immediately and keep rendering without the
+	 * pipeline until it is ready. Everything referenced by a configure function, such as the pipeline layout and
+	 * render pass, has to stay alive until the pipeline is ready; the destructor waits for all pending work.
+	 */
+	class LvePipelineCompiler {
+	public:
+		// applied on the worker after defaultPipelineConfigInfo()
+		using ConfigureFunction = std::function<void(PipelineConfigInfo& configInfo)>;
+
+		LvePipelineCompiler(LveDevice& device, LveJobSystem& jobSystem);
+		~LvePipelineCompiler();
+
+		LvePipelineCompiler(const LvePipelineCompiler&) = delete;
+		LvePipelineCompiler& operator=(const LvePipelineCompiler&) = delete;
+
+		// an empty fragFilePath creates a depth only pipeline
+		LveAsyncPipeline compileGraphics(
+			const std::string& vertFilePath, const std::string& fragFilePath, ConfigureFunction configure);
+		LveAsyncPipeline compileCompute(const std::string& compFilePath, VkPipelineLayout pipelineLayout);
+
+		// Blocks until every pipeline submitted so far has been compiled
+		void waitIdle();
+		uint32_t getPendingCount();
+
+	private:
+		LveAsyncPipeline track(LveAsyncPipeline::Future future);
+
+		LveDevice& lveDevice;
+		LveJobSystem& jobSystem;
+
+		std::mutex pendingMutex;
+		std::vector<LveAsyncPipeline::Future> pending;
+	};
+}
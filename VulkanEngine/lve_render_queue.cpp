@@ -0,0 +1,163 @@
+/**
+ * @file lve_render_queue.cpp
+ * @brief Implementation of the LveRenderQueue sort keys and radix sort, and of LveBindState.
+ *
+ * The radix sort processes one byte per pass from least to most significant. Each pass builds a histogram per
+ * chunk of keys, turns the histograms into scatter offsets ordered by digit and then by chunk, and scatters every
+ * chunk independently. Because chunks keep their relative order the sort is stable, and the result does not
+ * depend on how many workers took part.
+ */
+
+#include "lve_render_queue.hpp"
+
+// std
+#include <algorithm>
+#include <cstring>
+
+namespace lve {
+
+	namespace {
+		constexpr uint32_t RADIX_BITS = 8;
+		constexpr uint32_t RADIX_SIZE = 1u << RADIX_BITS;
+		constexpr uint32_t RADIX_PASSES = 64 / RADIX_BITS;
+
+		// below this many keys the job overhead outweighs the sort itself
+		constexpr uint32_t PARALLEL_SORT_THRESHOLD = 8192;
+
+		constexpr uint32_t MODEL_ID_MASK = 0xffffffu;
+	}
+
+	/**
+	 * @brief Creates an empty render queue.
+	 *
+	 * @param jobSystem Job system large sorts are spread over.
+	 */
+	LveRenderQueue::LveRenderQueue(LveJobSystem& jobSystem) : jobSystem{ jobSystem } {}
+
+	/**
+	 * @brief Builds a sort key from a draw's pipeline, model and view depth.
+	 *
+	 * @param pipelineId The pipeline's id, only the low 8 bits are used.
+	 * @param modelId The model's id, only the low 24 bits are used.
+	 * @param viewDepth Distance of the draw in front of the camera.
+	 * @param order Whether nearer draws sort first or last within a pipeline and model.
+	 * @return The 64 bit key.
+	 *
+	 * The bit pattern of a non negative float grows with its value, so the depth needs no range or scale to be
+	 * quantized and keeps its full precision.
+	 */
+	uint64_t LveRenderQueue::makeKey(uint32_t pipelineId, uint32_t modelId, float viewDepth, DepthOrder order) {
+		// also maps NaN to 0
+		float depth = viewDepth > 0.f ? viewDepth : 0.f;
+		uint32_t depthBits;
+		std::memcpy(&depthBits, &depth, sizeof(depthBits));
+		if (order == DepthOrder::BackToFront) {
+			depthBits = ~depthBits;
+		}
+		return (static_cast<uint64_t>(pipelineId & 0xffu) << 56)
+			| (static_cast<uint64_t>(modelId & MODEL_ID_MASK) << 32)
+			| depthBits;
+	}
+
+	void LveRenderQueue::clear() {
+		keys.clear();
+		payloads.clear();
+	}
+
+	void LveRenderQueue::push(uint64_t key, uint32_t payload) {
+		keys.push_back(key);
+		payloads.push_back(payload);
+	}
+
+	/**
+	 * @brief Sorts the queued draws by key, keeping the submission order of equal keys.
+	 *
+	 * Bytes that are the same in every key do not affect the order and their passes are skipped, so a queue with
+	 * a single pipeline and few models usually only needs the four depth passes.
+	 */
+	void LveRenderQueue::sort() {
+		const uint32_t count = size();
+		if (count < 2) return;
+
+		uint64_t varyingBits = 0;
+		for (uint64_t key : keys) {
+			varyingBits |= key ^ keys[0];
+		}
+		if (varyingBits == 0) return;
+
+		uint32_t chunkCount = count < PARALLEL_SORT_THRESHOLD ? 1 : jobSystem.getWorkerCount() + 1;
+		const uint32_t chunkSize = (count + chunkCount - 1) / chunkCount;
+		chunkCount = (count + chunkSize - 1) / chunkSize;
+
+		sortedKeys.resize(count);
+		sortedPayloads.resize(count);
+		histograms.resize(static_cast<size_t>(chunkCount) * RADIX_SIZE);
+
+		auto forEachChunk = [&](const std::function<void(uint32_t begin, uint32_t end, uint32_t* histogram)>& task) {
+			auto runChunk = [&](uint32_t chunk) {
+				const uint32_t begin = chunk * chunkSize;
+				task(begin, std::min(count, begin + chunkSize), &histograms[static_cast<size_t>(chunk) * RADIX_SIZE]);
+			};
+			if (chunkCount == 1) {
+				runChunk(0);
+			} else {
+				jobSystem.parallelFor(chunkCount, runChunk);
+			}
+		};
+
+		for (uint32_t pass = 0; pass < RADIX_PASSES; pass++) {
+			const uint32_t shift = pass * RADIX_BITS;
+			if (((varyingBits >> shift) & (RADIX_SIZE - 1)) == 0) continue;
+
+			forEachChunk([&](uint32_t begin, uint32_t end, uint32_t* histogram) {
+				std::fill(histogram, histogram + RADIX_SIZE, 0u);
+				for (uint32_t i = begin; i < end; i++) {
+					histogram[(keys[i] >> shift) & (RADIX_SIZE - 1)]++;
+				}
+			});
+
+			// every chunk scatters a digit right after the same digit of the chunks before it
+			uint32_t offset = 0;
+			for (uint32_t digit = 0; digit < RADIX_SIZE; digit++) {
+				for (uint32_t chunk = 0; chunk < chunkCount; chunk++) {
+					uint32_t& entry = histograms[static_cast<size_t>(chunk) * RADIX_SIZE + digit];
+					const uint32_t digitCount = entry;
+					entry = offset;
+					offset += digitCount;
+				}
+			}
+
+			forEachChunk([&](uint32_t begin, uint32_t end, uint32_t* histogram) {
+				for (uint32_t i = begin; i < end; i++) {
+					const uint32_t destination = histogram[(keys[i] >> shift) & (RADIX_SIZE - 1)]++;
+					sortedKeys[destination] = keys[i];
+					sortedPayloads[destination] = payloads[i];
+				}
+			});
+
+			keys.swap(sortedKeys);
+			payloads.swap(sortedPayloads);
+		}
+	}
+
+	bool LveBindState::bindPipeline(LvePipeline& pipeline) {
+		if (boundPipeline == &pipeline) return false;
+		pipeline.bind(commandBuffer);
+		boundPipeline = &pipeline;
+		bindCount++;
+		return true;
+	}
+
+	bool LveBindState::bindModel(LveModel& model, bool positionsOnly) {
+		if (boundModel == &model && boundPositionsOnly == positionsOnly) return false;
+		if (positionsOnly) {
+			model.bindPositions(commandBuffer);
+		} else {
+			model.bind(commandBuffer);
+		}
+		boundModel = &model;
+		boundPositionsOnly = positionsOnly;
+		bindCount++;
+		return true;
+	}
+}
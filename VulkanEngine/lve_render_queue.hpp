@@ -0,0 +1,77 @@
+#pragma once
+
+#include "lve_job_system.hpp"
+#include "lve_model.hpp"
+#include "lve_pipeline.hpp"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+	/**
+	 * Per frame list of draws ordered by a 64 bit sort key.
+	 *
+	 * Keys are laid out as pipeline [63:56] | model [55:32] | view depth [31:0], so sorting them groups draws by
+	 * pipeline, then by model, then orders each group by depth. Every key carries a payload the submitting system
+	 * uses to find its draw again. sort() is a stable LSD radix sort over the bytes that actually differ between
+	 * keys, with histograms and scatters split across the job system for large queues.
+	 */
+	class LveRenderQueue {
+	public:
+		enum class DepthOrder { FrontToBack, BackToFront };
+
+		explicit LveRenderQueue(LveJobSystem& jobSystem);
+
+		LveRenderQueue(const LveRenderQueue&) = delete;
+		LveRenderQueue& operator=(const LveRenderQueue&) = delete;
+
+		// viewDepth is the distance along the camera's forward axis, anything behind the camera sorts as 0
+		static uint64_t makeKey(
+			uint32_t pipelineId, uint32_t modelId, float viewDepth, DepthOrder order = DepthOrder::FrontToBack);
+
+		void clear();
+		void push(uint64_t key, uint32_t payload);
+		void sort();
+
+		uint32_t size() const { return static_cast<uint32_t>(keys.size()); }
+		uint64_t getKey(uint32_t i) const { return keys[i]; }
+		uint32_t getPayload(uint32_t i) const { return payloads[i]; }
+
+	private:
+		LveJobSystem& jobSystem;
+
+		std::vector<uint64_t> keys;
+		std::vector<uint32_t> payloads;
+
+		// sort scratch, kept between frames to avoid per frame allocations
+		std::vector<uint64_t> sortedKeys;
+		std::vector<uint32_t> sortedPayloads;
+		std::vector<uint32_t> histograms;
+	};
+
+	/**
+	 * Remembers what is bound to a command buffer so repeated binds of the same pipeline or model are skipped.
+	 *
+	 * Vertex and index buffer bindings survive pipeline changes, so a model stays bound across pipeline binds.
+	 */
+	class LveBindState {
+	public:
+		explicit LveBindState(VkCommandBuffer commandBuffer) : commandBuffer{ commandBuffer } {}
+
+		// both return true if a bind command was recorded
+		bool bindPipeline(LvePipeline& pipeline);
+		// positionsOnly binds the model's position only stream for depth only pipelines
+		bool bindModel(LveModel& model, bool positionsOnly = false);
+
+		uint32_t getBindCount() const { return bindCount; }
+
+	private:
+		VkCommandBuffer commandBuffer;
+		LvePipeline* boundPipeline = nullptr;
+		LveModel* boundModel = nullptr;
+		bool boundPositionsOnly = false;
+		uint32_t bindCount = 0;
+	};
+}
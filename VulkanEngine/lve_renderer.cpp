@@ -1,9 +1,11 @@
 #include "lve_renderer.hpp"
 
 // std
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <stdexcept>
+#include <string>
 
 namespace lve {
 
@@ -13,9 +15,20 @@ namespace lve {
 	 * The `LveRenderer` class is responsible for setting up and managing Vulkan resources related to rendering,
 	 * such as the swap chain and command buffers. It handles the initialization, recreation, and cleanup of
 	 * these resources, as well as managing the lifecycle of rendering commands for each frame.
+	 *
+	 * @param window The window presented to.
+	 * @param device The device rendering is done on.
+	 * @param framesInFlight Number of frames the CPU may record ahead of the GPU, from 1 to
+	 *        `LveSwapChain::MAX_FRAMES_IN_FLIGHT`.
+	 * @throws std::runtime_error If framesInFlight is out of range.
 	 */
-	LveRenderer::LveRenderer(LveWindow& window, LveDevice& device) : lveWindow{ window }, lveDevice{ device } {
-		recreateSwapChain();
+	LveRenderer::LveRenderer(LveWindow& window, LveDevice& device, uint32_t framesInFlight)
+		: lveWindow{ window }, lveDevice{ device }, framesInFlight{ framesInFlight } {
+		if (framesInFlight < 1 || framesInFlight > LveSwapChain::MAX_FRAMES_IN_FLIGHT) {
+			throw std::runtime_error("Frames in flight must be between 1 and "
+				+ std::to_string(LveSwapChain::MAX_FRAMES_IN_FLIGHT) + "!");
+		}
+		recreateSwapChain(true);
 		createCommandBuffers();
 	}
 
@@ -29,28 +42,74 @@ namespace lve {
 	/**
 	 * @brief Recreates the swap chain and associated resources.
 	 *
+	 * @param waitWhileMinimized Whether to wait for events until a minimized window is restored, otherwise the
+	 *        recreation is put off until the next beginFrame.
+	 * @return False if the recreation was put off.
+	 *
 	 * This method is called when the window size changes or if the swap chain is invalidated. It handles
 	 * the recreation of the swap chain and verifies if the swap chain image formats have changed.
+	 *
+	 * The device is not waited for. The new swap chain takes over the render pass and frame synchronization,
+	 * and the old one is retired: frames already submitted keep using its images, framebuffers and depth
+	 * buffer, so it is only destroyed once every frame in flight has waited for its fence again.
 	 */
-	void LveRenderer::recreateSwapChain() {
+	bool LveRenderer::recreateSwapChain(bool waitWhileMinimized) {
 		auto extent = lveWindow.getExtent();
-		while (extent.width = 0 || extent.height == 0) {
-			extent = lveWindow.getExtent();
+		while (extent.width == 0 || extent.height == 0) {
+			if (!waitWhileMinimized) {
+				swapChainOutdated = true;
+				return false;
+			}
 			glfwWaitEvents();
+			extent = lveWindow.getExtent();
 		}
-
-		vkDeviceWaitIdle(lveDevice.device());
+		swapChainOutdated = false;
 
 		if (lveSwapChain == nullptr) {
-			lveSwapChain = std::make_unique<LveSwapChain>(lveDevice, extent);
+			lveSwapChain = std::make_unique<LveSwapChain>(lveDevice, extent, framesInFlight, preferredPresentMode);
 		} else {
 			std::shared_ptr<LveSwapChain> oldSwapChain = std::move(lveSwapChain);
-			lveSwapChain = std::make_unique<LveSwapChain>(lveDevice, extent, oldSwapChain);
+			lveSwapChain = std::make_unique<LveSwapChain>(
+				lveDevice, extent, framesInFlight, preferredPresentMode, oldSwapChain);
 
 			if (!oldSwapChain->compareSwapFormats(*lveSwapChain.get())) {
 				throw std::runtime_error("Swap chain image(or dept) format has changed.");
 			}
+			retiredSwapChains.push_back({ std::move(oldSwapChain), framesInFlight });
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Destroys retired swap chains no submitted frame uses anymore.
+	 *
+	 * Called once per started frame, after the frame's fence wait. Frames cycle through the fences in order, so
+	 * once as many fences as there are frames in flight have been waited for, every frame submitted before the
+	 * swap chain was retired has completed.
+	 */
+	void LveRenderer::releaseRetiredSwapChains() {
+		for (auto& retired : retiredSwapChains) {
+			retired.framesUntilRelease--;
 		}
+		retiredSwapChains.erase(
+			std::remove_if(
+				retiredSwapChains.begin(),
+				retiredSwapChains.end(),
+				[](const RetiredSwapChain& retired) { return retired.framesUntilRelease == 0; }),
+			retiredSwapChains.end());
+	}
+
+	/**
+	 * @brief Selects the present mode used from the next frame on.
+	 *
+	 * @param presentMode The preferred mode. FIFO waits for vertical blank, MAILBOX replaces queued images
+	 *        without tearing and IMMEDIATE presents at once, possibly tearing.
+	 *
+	 * The swap chain is recreated at the start of the next beginFrame, so this may be called during a frame.
+	 */
+	void LveRenderer::setPresentMode(VkPresentModeKHR presentMode) {
+		preferredPresentMode = presentMode;
+		presentModeChanged = true;
 	}
 
 	/**
@@ -60,7 +119,7 @@ namespace lve {
 	 * with the command pool.
 	 */
 	void LveRenderer::createCommandBuffers() {
-		commandBuffers.resize(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+		commandBuffers.resize(framesInFlight);
 
 		VkCommandBufferAllocateInfo allocInfo{};
 		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -90,19 +149,29 @@ namespace lve {
 	/**
 	 * @brief Begins a new frame by acquiring an image from the swap chain.
 	 *
-	 * @return VkCommandBuffer The command buffer to record commands for the current frame.
+	 * @param waitWhileMinimized Whether a swap chain recreation during this frame may wait for a minimized
+	 *        window to be restored. Pass false where blocking in the event loop is not allowed.
+	 * @return VkCommandBuffer The command buffer to record commands for the current frame, or nullptr if the
+	 *         swap chain had to be recreated first.
 	 *
 	 * This method acquires the next available image from the swap chain and begins recording commands into
 	 * the associated command buffer. It handles the case where the swap chain is out of date and needs to
 	 * be recreated.
 	 */
-	VkCommandBuffer LveRenderer::beginFrame() {
+	VkCommandBuffer LveRenderer::beginFrame(bool waitWhileMinimized) {
 		assert(!isFrameStarted && "Can't call beginFrame while already in progress.");
 
+		if (presentModeChanged || swapChainOutdated) {
+			presentModeChanged = false;
+			if (!recreateSwapChain(waitWhileMinimized)) {
+				return nullptr;
+			}
+		}
+
 		auto result = lveSwapChain->acquireNextImage(&currentImageIndex);
 
 		if (result == VK_ERROR_OUT_OF_DATE_KHR) {
-			recreateSwapChain();
+			recreateSwapChain(waitWhileMinimized);
 			return nullptr;
 		}
 
@@ -110,7 +179,10 @@ namespace lve {
 			throw std::runtime_error("Failed to acquire swap chain image!");
 		}
 
+		// only counted for frames that go on, a failed acquisition waits for the same fence again next time
+		releaseRetiredSwapChains();
 		isFrameStarted = true;
+		frameWaitsWhileMinimized = waitWhileMinimized;
 
 		auto commandBuffer = getCurrentCommandBuffer();
 
@@ -139,26 +211,30 @@ namespace lve {
 		}
 
 		auto result = lveSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
+		fenceWaitTime = lveSwapChain->getFenceWaitTime();
+		lastSubmitTime = lveSwapChain->getLastSubmitTime();
 		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || lveWindow.wasWindowResized()) {
 			lveWindow.resetWindowResizedFlag();
-			recreateSwapChain();
+			recreateSwapChain(frameWaitsWhileMinimized);
 		} else if (result != VK_SUCCESS) {
 			throw std::runtime_error("Failed to present swap chain image!");
 		}
 
 		isFrameStarted = false;
-		currentFrameIndex = (currentFrameIndex + 1) % LveSwapChain::MAX_FRAMES_IN_FLIGHT;
+		currentFrameIndex = (currentFrameIndex + 1) % static_cast<int>(framesInFlight);
 	}
 
 	/**
 	 * @brief Begins a render pass for the current frame.
 	 *
 	 * @param commandBuffer The command buffer to begin the render pass on.
+	 * @param contents Whether the pass is recorded inline or executed from secondary command buffers.
 	 *
 	 * This method sets up the render pass, including clearing values and viewport settings. It must be called
-	 * before recording any rendering commands into the command buffer.
+	 * before recording any rendering commands into the command buffer. With secondary contents the primary may only
+	 * execute commands, so the viewport and scissor are left to the secondaries.
 	 */
-	void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer) {
+	void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents) {
 		assert(isFrameStarted && "Can't call beginSwapChainRenderPass if frame is not in progress.");
 		assert(commandBuffer == getCurrentCommandBuffer() && "Can't begin render pass on command buffer from a different frame.");
 
@@ -177,7 +253,10 @@ namespace lve {
 		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 		renderPassInfo.pClearValues = clearValues.data();
 
-		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+		if (contents != VK_SUBPASS_CONTENTS_INLINE) {
+			return;
+		}
 
 		VkViewport viewport{};
 		viewport.x = 0.0f;
@@ -6,6 +6,7 @@
 
 // std
 #include <cassert>
+#include <chrono>
 #include <memory>
 #include <vector>
 
@@ -13,43 +14,94 @@ namespace lve {
 
 	class LveRenderer {
 	public:
-		LveRenderer(LveWindow &window, LveDevice &device);
+		LveRenderer(
+			LveWindow &window,
+			LveDevice &device,
+			uint32_t framesInFlight = LveSwapChain::DEFAULT_FRAMES_IN_FLIGHT);
 		~LveRenderer();
 
 		LveRenderer(const LveRenderer&) = delete;
 		LveRenderer& operator=(const LveRenderer&) = delete;
 
 		VkRenderPass getSwapChainRenderPass() const { return lveSwapChain->getRenderPass(); }
+		VkExtent2D getSwapChainExtent() const { return lveSwapChain->getSwapChainExtent(); }
+		VkFormat getSwapChainImageFormat() const { return lveSwapChain->getSwapChainImageFormat(); }
+		VkFormat getSwapChainDepthFormat() const { return lveSwapChain->getSwapChainDepthFormat(); }
+		// true if offscreen images can be blitted onto the swap chain images
+		bool supportsSwapChainBlit() const { return lveSwapChain->supportsTransferDst(); }
 		float getAspectRatio() const { return lveSwapChain->extentAspectRatio(); }
 		bool isFrameInProgress() const { return isFrameStarted; }
+		// per frame resources like uniform buffers and descriptor sets have to be created this many times
+		uint32_t getFramesInFlight() const { return framesInFlight; }
+		// seconds beginFrame and endFrame of the latest frame blocked on an earlier frame's fences
+		float getFenceWaitTime() const { return fenceWaitTime; }
+		// when endFrame handed the latest frame to the graphics queue
+		std::chrono::high_resolution_clock::time_point getLastSubmitTime() const { return lastSubmitTime; }
+
+		// Recreates the swap chain with the given mode before the next frame, FIFO is used if it is unsupported
+		void setPresentMode(VkPresentModeKHR presentMode);
+		VkPresentModeKHR getPresentMode() const { return lveSwapChain->getPresentMode(); }
 
 		VkCommandBuffer getCurrentCommandBuffer() const { 
 			assert(isFrameStarted && "Cannot get command buffer when frame is not in progress.");
 			return commandBuffers[currentFrameIndex];
 		}
 
+		VkFramebuffer getCurrentFrameBuffer() const {
+			assert(isFrameStarted && "Cannot get frame buffer when frame is not in progress.");
+			return lveSwapChain->getFrameBuffer(currentImageIndex);
+		}
+
+		// the acquired image, for frames that write it with transfers instead of the swap chain render pass
+		VkImage getCurrentSwapChainImage() const {
+			assert(isFrameStarted && "Cannot get swap chain image when frame is not in progress.");
+			return lveSwapChain->getImage(static_cast<int>(currentImageIndex));
+		}
+
 		int getFrameIndex() const {
 			assert(isFrameStarted && "Cannot get frame buffer when frame is not in progress.");
 			return currentFrameIndex;
 		}
 
-		VkCommandBuffer beginFrame();
+		// Returns nullptr if the swap chain had to be recreated. While the window is minimized this waits for events
+		// until it is restored, unless waitWhileMinimized is false, like when drawing from the window's refresh
+		// callback, which must return to the event loop to ever see the restore
+		VkCommandBuffer beginFrame(bool waitWhileMinimized = true);
 		void endFrame();
-		void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+		void beginSwapChainRenderPass(
+			VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
 		void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
 	private:
 		void createCommandBuffers();
 		void freeCommandBuffers();
-		void recreateSwapChain();
+		bool recreateSwapChain(bool waitWhileMinimized);
+		void releaseRetiredSwapChains();
+
+		struct RetiredSwapChain {
+			std::shared_ptr<LveSwapChain> swapChain;
+			// frame fences still to be waited for before no submission uses the swap chain anymore
+			uint32_t framesUntilRelease;
+		};
 
 		LveWindow& lveWindow;
 		LveDevice& lveDevice;
+		uint32_t framesInFlight;
+		VkPresentModeKHR preferredPresentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+		bool presentModeChanged = false;
+		// set when a recreation was put off while minimized, retried at the next beginFrame
+		bool swapChainOutdated = false;
 		std::unique_ptr<LveSwapChain> lveSwapChain;
+		std::vector<RetiredSwapChain> retiredSwapChains;
 		std::vector<VkCommandBuffer> commandBuffers;
 
 		uint32_t currentImageIndex;
 		int currentFrameIndex{ 0 };
 		bool isFrameStarted{ false };
+		// beginFrame's argument, for the recreation endFrame may trigger
+		bool frameWaitsWhileMinimized{ true };
+		// kept here since the swap chain may be recreated right after the submission
+		float fenceWaitTime = 0.f;
+		std::chrono::high_resolution_clock::time_point lastSubmitTime{};
 	};
 }
\ No newline at end of file
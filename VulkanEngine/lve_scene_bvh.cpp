@@ -0,0 +1,683 @@
+/**
+ * @file lve_scene_bvh.cpp
+ * @brief Implementation of the LveSceneBvh class, a dynamic AABB tree used for scene queries.
+ *
+ * This file contains incremental insertion, removal and refitting of object bounds as well as the
+ * frustum, sphere, box and ray queries used for culling and picking. Insertion picks a sibling with the
+ * surface area heuristic and the tree is rebalanced with rotations on the way back up. Whole scenes are
+ * built top down in one pass instead, splitting binned centroids where the heuristic is lowest.
+ */
+
+#include "lve_scene_bvh.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <limits>
+
+namespace lve {
+
+	namespace {
+
+		// centroid bins per axis considered by the top down build
+		constexpr int BUILD_BIN_COUNT = 16;
+
+		// Traversal stack that lives on the call stack unless the tree is unusually deep
+		class NodeStack {
+		public:
+			void push(int node) {
+				if (count < static_cast<int>(inlineNodes.size())) {
+					inlineNodes[count] = node;
+				} else {
+					overflow.push_back(node);
+				}
+				count++;
+			}
+
+			int pop() {
+				assert(count > 0 && "Cannot pop an empty node stack");
+				count--;
+				if (count < static_cast<int>(inlineNodes.size())) {
+					return inlineNodes[count];
+				}
+				int node = overflow.back();
+				overflow.pop_back();
+				return node;
+			}
+
+			bool empty() const { return count == 0; }
+
+		private:
+			std::array<int, 128> inlineNodes;
+			std::vector<int> overflow;
+			int count = 0;
+		};
+
+		BoundingBox merge(const BoundingBox& a, const BoundingBox& b) {
+			BoundingBox result = a;
+			result.expand(b);
+			return result;
+		}
+
+		bool intersectRay(
+			const BoundingBox& box, const Ray& ray, const glm::vec3& inverseDirection, float maxDistance, float& entry) {
+			float tMin = 0.f;
+			float tMax = maxDistance;
+			for (int i = 0; i < 3; i++) {
+				float t1 = (box.min[i] - ray.origin[i]) * inverseDirection[i];
+				float t2 = (box.max[i] - ray.origin[i]) * inverseDirection[i];
+				tMin = std::max(tMin, std::min(t1, t2));
+				tMax = std::min(tMax, std::max(t1, t2));
+			}
+			entry = tMin;
+			return tMin <= tMax;
+		}
+
+		bool overlapsSphere(const BoundingBox& box, const BoundingSphere& sphere) {
+			glm::vec3 closest = glm::clamp(sphere.center, box.min, box.max);
+			glm::vec3 offset = closest - sphere.center;
+			return glm::dot(offset, offset) <= sphere.radius * sphere.radius;
+		}
+	}
+
+	/**
+	 * @brief Constructs an empty tree.
+	 *
+	 * @param fatMargin Distance each leaf box is enlarged by so small movements don't trigger a reinsert.
+	 */
+	LveSceneBvh::LveSceneBvh(float fatMargin) : fatMargin{ fatMargin } {}
+
+	/**
+	 * @brief Inserts an object into the tree.
+	 *
+	 * @param objectId The id of the game object, must not already be in the tree.
+	 * @param worldBounds The world space bounds of the object.
+	 */
+	void LveSceneBvh::insert(id_t objectId, const BoundingBox& worldBounds) {
+		assert(!contains(objectId) && "Object is already in the BVH");
+
+		int leaf = allocateNode();
+		nodes[leaf].box = BoundingBox{ worldBounds.min - glm::vec3(fatMargin), worldBounds.max + glm::vec3(fatMargin) };
+		nodes[leaf].objectId = objectId;
+		nodes[leaf].height = 0;
+		insertLeaf(leaf);
+
+		leafForObject[objectId] = leaf;
+	}
+
+	/**
+	 * @brief Inserts many objects at once.
+	 *
+	 * @param objects Ids and world space bounds of the objects, none of which may already be in the tree.
+	 *
+	 * An empty tree is built top down in a single pass, which is much faster than inserting the objects one by
+	 * one and gives a tree of at least the same quality. Objects added to a tree that already has some are
+	 * inserted one by one.
+	 */
+	void LveSceneBvh::build(const std::vector<std::pair<id_t, BoundingBox>>& objects) {
+		if (root != NULL_NODE) {
+			for (const auto& [objectId, worldBounds] : objects) {
+				insert(objectId, worldBounds);
+			}
+			return;
+		}
+		if (objects.empty()) return;
+
+		nodes.reserve(nodes.size() + 2 * objects.size() - 1);
+		leafForObject.reserve(leafForObject.size() + objects.size());
+		std::vector<int> leaves(objects.size());
+		for (size_t i = 0; i < objects.size(); i++) {
+			const auto& [objectId, worldBounds] = objects[i];
+			assert(!contains(objectId) && "Object is already in the BVH");
+			int leaf = allocateNode();
+			nodes[leaf].box = BoundingBox{ worldBounds.min - glm::vec3(fatMargin), worldBounds.max + glm::vec3(fatMargin) };
+			nodes[leaf].objectId = objectId;
+			nodes[leaf].height = 0;
+			leafForObject[objectId] = leaf;
+			leaves[i] = leaf;
+		}
+
+		root = buildSubtree(leaves.data(), leaves.size());
+		nodes[root].parent = NULL_NODE;
+	}
+
+	/**
+	 * @brief Removes an object from the tree. Does nothing if the object is not in the tree.
+	 *
+	 * @param objectId The id of the game object to remove.
+	 */
+	void LveSceneBvh::remove(id_t objectId) {
+		auto it = leafForObject.find(objectId);
+		if (it == leafForObject.end()) {
+			return;
+		}
+
+		removeLeaf(it->second);
+		freeNode(it->second);
+		leafForObject.erase(it);
+	}
+
+	/**
+	 * @brief Refits an object after it moved.
+	 *
+	 * If the new bounds still fit inside the enlarged leaf box nothing changes, otherwise the leaf is
+	 * removed and reinserted with a new enlarged box.
+	 *
+	 * @param objectId The id of the game object that moved.
+	 * @param worldBounds The new world space bounds of the object.
+	 * @return True if the leaf had to be reinserted.
+	 */
+	bool LveSceneBvh::update(id_t objectId, const BoundingBox& worldBounds) {
+		auto it = leafForObject.find(objectId);
+		assert(it != leafForObject.end() && "Cannot update an object that is not in the BVH");
+		int leaf = it->second;
+
+		if (nodes[leaf].box.contains(worldBounds)) {
+			return false;
+		}
+
+		removeLeaf(leaf);
+		nodes[leaf].box = BoundingBox{ worldBounds.min - glm::vec3(fatMargin), worldBounds.max + glm::vec3(fatMargin) };
+		insertLeaf(leaf);
+		return true;
+	}
+
+	/**
+	 * @brief Refits the objects marked with markMoved().
+	 *
+	 * @param gameObjects The objects the ids refer to, their current transforms give the new bounds.
+	 * @return The number of objects that left their enlarged box and were reinserted.
+	 *
+	 * Objects marked more than once are refit once, objects that have been removed or have no model are skipped.
+	 */
+	uint32_t LveSceneBvh::refitMoved(LveGameObject::Map& gameObjects) {
+		std::sort(movedObjects.begin(), movedObjects.end());
+		movedObjects.erase(std::unique(movedObjects.begin(), movedObjects.end()), movedObjects.end());
+
+		uint32_t reinsertedCount = 0;
+		for (id_t objectId : movedObjects) {
+			auto object = gameObjects.find(objectId);
+			if (!contains(objectId) || object == gameObjects.end() || object->second.model == nullptr) continue;
+			if (update(objectId, object->second.getWorldBounds())) {
+				reinsertedCount++;
+			}
+		}
+		movedObjects.clear();
+		return reinsertedCount;
+	}
+
+	/**
+	 * @brief Removes every object from the tree.
+	 */
+	void LveSceneBvh::clear() {
+		nodes.clear();
+		leafForObject.clear();
+		movedObjects.clear();
+		root = NULL_NODE;
+		freeList = NULL_NODE;
+	}
+
+	/**
+	 * @brief Finds every object that may intersect a frustum.
+	 *
+	 * Subtrees that lie completely inside the frustum are accepted without testing their children.
+	 *
+	 * @param frustum The frustum to test against.
+	 * @param results Receives the ids of intersecting objects.
+	 */
+	void LveSceneBvh::queryFrustum(const LveFrustum& frustum, std::vector<id_t>& results) const {
+		if (root == NULL_NODE) return;
+
+		NodeStack stack{};
+		stack.push(root);
+		while (!stack.empty()) {
+			const Node& node = nodes[stack.pop()];
+			if (!frustum.intersects(node.box)) continue;
+
+			if (node.isLeaf()) {
+				results.push_back(node.objectId);
+			} else if (frustum.contains(node.box)) {
+				collectLeaves(node.child1, results);
+				collectLeaves(node.child2, results);
+			} else {
+				stack.push(node.child1);
+				stack.push(node.child2);
+			}
+		}
+	}
+
+	/**
+	 * @brief Finds every object whose box overlaps a sphere.
+	 *
+	 * @param sphere The world space sphere to test against.
+	 * @param results Receives the ids of overlapping objects.
+	 */
+	void LveSceneBvh::querySphere(const BoundingSphere& sphere, std::vector<id_t>& results) const {
+		if (root == NULL_NODE) return;
+
+		NodeStack stack{};
+		stack.push(root);
+		while (!stack.empty()) {
+			const Node& node = nodes[stack.pop()];
+			if (!overlapsSphere(node.box, sphere)) continue;
+
+			if (node.isLeaf()) {
+				results.push_back(node.objectId);
+			} else {
+				stack.push(node.child1);
+				stack.push(node.child2);
+			}
+		}
+	}
+
+	/**
+	 * @brief Finds every object whose box overlaps another box.
+	 *
+	 * @param box The world space box to test against.
+	 * @param results Receives the ids of overlapping objects.
+	 */
+	void LveSceneBvh::queryBox(const BoundingBox& box, std::vector<id_t>& results) const {
+		if (root == NULL_NODE) return;
+
+		NodeStack stack{};
+		stack.push(root);
+		while (!stack.empty()) {
+			const Node& node = nodes[stack.pop()];
+			if (!node.box.overlaps(box)) continue;
+
+			if (node.isLeaf()) {
+				results.push_back(node.objectId);
+			} else {
+				stack.push(node.child1);
+				stack.push(node.child2);
+			}
+		}
+	}
+
+	/**
+	 * @brief Casts a ray against the object boxes in the tree.
+	 *
+	 * Children are visited nearest first and subtrees further away than the best hit so far are skipped.
+	 * Hits are reported against the enlarged leaf boxes, which is precise enough for picking.
+	 *
+	 * @param ray The ray, with a normalized direction.
+	 * @param maxDistance The maximum distance along the ray to consider.
+	 * @param hit Receives the closest hit if one was found.
+	 * @return True if the ray hit an object.
+	 */
+	bool LveSceneBvh::raycast(const Ray& ray, float maxDistance, RayHit& hit) const {
+		if (root == NULL_NODE) return false;
+
+		const glm::vec3 inverseDirection = 1.f / ray.direction;
+		float closest = maxDistance;
+		bool found = false;
+
+		NodeStack stack{};
+		stack.push(root);
+		while (!stack.empty()) {
+			const Node& node = nodes[stack.pop()];
+			float entry;
+			if (!intersectRay(node.box, ray, inverseDirection, closest, entry)) continue;
+
+			if (node.isLeaf()) {
+				closest = entry;
+				hit.objectId = node.objectId;
+				hit.distance = entry;
+				found = true;
+				continue;
+			}
+
+			float entry1, entry2;
+			bool hit1 = intersectRay(nodes[node.child1].box, ray, inverseDirection, closest, entry1);
+			bool hit2 = intersectRay(nodes[node.child2].box, ray, inverseDirection, closest, entry2);
+			if (hit1 && hit2) {
+				// push the further child first so the nearer one is visited first
+				if (entry1 < entry2) {
+					stack.push(node.child2);
+					stack.push(node.child1);
+				} else {
+					stack.push(node.child1);
+					stack.push(node.child2);
+				}
+			} else if (hit1) {
+				stack.push(node.child1);
+			} else if (hit2) {
+				stack.push(node.child2);
+			}
+		}
+		return found;
+	}
+
+	int LveSceneBvh::allocateNode() {
+		if (freeList == NULL_NODE) {
+			nodes.emplace_back();
+			return static_cast<int>(nodes.size()) - 1;
+		}
+
+		int nodeIndex = freeList;
+		freeList = nodes[nodeIndex].parent;
+		nodes[nodeIndex] = Node{};
+		return nodeIndex;
+	}
+
+	void LveSceneBvh::freeNode(int nodeIndex) {
+		nodes[nodeIndex].parent = freeList;
+		nodes[nodeIndex].height = -1;
+		freeList = nodeIndex;
+	}
+
+	/**
+	 * @brief Builds the subtree over a range of unlinked leaves.
+	 *
+	 * @param leaves The leaves, reordered in place.
+	 * @param count Number of leaves, at least one.
+	 * @return Index of the subtree's root.
+	 *
+	 * The leaves are split along the longest axis of their centroids' bounds at the bin boundary with the lowest
+	 * surface area heuristic cost. When every centroid falls into one bin the split is at the median instead.
+	 */
+	int LveSceneBvh::buildSubtree(int* leaves, size_t count) {
+		if (count == 1) return leaves[0];
+
+		BoundingBox centroidBounds{};
+		for (size_t i = 0; i < count; i++) {
+			centroidBounds.expand(nodes[leaves[i]].box.center());
+		}
+		const glm::vec3 centroidExtent = centroidBounds.max - centroidBounds.min;
+		int axis = 0;
+		if (centroidExtent.y > centroidExtent[axis]) axis = 1;
+		if (centroidExtent.z > centroidExtent[axis]) axis = 2;
+
+		size_t splitCount = 0;
+		if (centroidExtent[axis] > 0.f) {
+			const float binScale = BUILD_BIN_COUNT / centroidExtent[axis];
+			auto binOf = [&](int leaf) {
+				int bin = static_cast<int>((nodes[leaf].box.center()[axis] - centroidBounds.min[axis]) * binScale);
+				return std::min(bin, BUILD_BIN_COUNT - 1);
+			};
+			std::array<BoundingBox, BUILD_BIN_COUNT> binBoxes{};
+			std::array<size_t, BUILD_BIN_COUNT> binCounts{};
+			for (size_t i = 0; i < count; i++) {
+				const int bin = binOf(leaves[i]);
+				binBoxes[bin].expand(nodes[leaves[i]].box);
+				binCounts[bin]++;
+			}
+
+			// cost of everything right of each bin boundary, then sweep from the left for the cheapest split
+			std::array<float, BUILD_BIN_COUNT> rightCosts{};
+			BoundingBox rightBox{};
+			size_t rightCount = 0;
+			for (int bin = BUILD_BIN_COUNT - 1; bin > 0; bin--) {
+				rightBox.expand(binBoxes[bin]);
+				rightCount += binCounts[bin];
+				rightCosts[bin] = rightCount > 0 ? rightBox.surfaceArea() * rightCount : 0.f;
+			}
+			BoundingBox leftBox{};
+			size_t leftCount = 0;
+			float bestCost = std::numeric_limits<float>::max();
+			int bestBin = 0;
+			for (int bin = 1; bin < BUILD_BIN_COUNT; bin++) {
+				leftBox.expand(binBoxes[bin - 1]);
+				leftCount += binCounts[bin - 1];
+				if (leftCount == 0 || leftCount == count) continue;
+				const float cost = leftBox.surfaceArea() * leftCount + rightCosts[bin];
+				if (cost < bestCost) {
+					bestCost = cost;
+					bestBin = bin;
+				}
+			}
+			if (bestBin > 0) {
+				int* middle = std::partition(leaves, leaves + count, [&](int leaf) { return binOf(leaf) < bestBin; });
+				splitCount = static_cast<size_t>(middle - leaves);
+			}
+		}
+		if (splitCount == 0 || splitCount == count) {
+			splitCount = count / 2;
+			std::nth_element(leaves, leaves + splitCount, leaves + count, [&](int a, int b) {
+				return nodes[a].box.center()[axis] < nodes[b].box.center()[axis];
+			});
+		}
+
+		const int child1 = buildSubtree(leaves, splitCount);
+		const int child2 = buildSubtree(leaves + splitCount, count - splitCount);
+		const int parent = allocateNode();
+		nodes[parent].child1 = child1;
+		nodes[parent].child2 = child2;
+		nodes[parent].box = merge(nodes[child1].box, nodes[child2].box);
+		nodes[parent].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+		nodes[child1].parent = parent;
+		nodes[child2].parent = parent;
+		return parent;
+	}
+
+	void LveSceneBvh::collectLeaves(int nodeIndex, std::vector<id_t>& results) const {
+		NodeStack stack{};
+		stack.push(nodeIndex);
+		while (!stack.empty()) {
+			const Node& node = nodes[stack.pop()];
+			if (node.isLeaf()) {
+				results.push_back(node.objectId);
+			} else {
+				stack.push(node.child1);
+				stack.push(node.child2);
+			}
+		}
+	}
+
+	/**
+	 * @brief Links a leaf into the tree next to the sibling that grows the total surface area the least.
+	 *
+	 * @param leaf Index of a leaf node that is not yet linked into the tree.
+	 */
+	void LveSceneBvh::insertLeaf(int leaf) {
+		if (root == NULL_NODE) {
+			root = leaf;
+			nodes[root].parent = NULL_NODE;
+			return;
+		}
+
+		// descend to the best sibling
+		const BoundingBox leafBox = nodes[leaf].box;
+		int index = root;
+		while (!nodes[index].isLeaf()) {
+			const Node& node = nodes[index];
+			const float area = node.box.surfaceArea();
+			const float combinedArea = merge(node.box, leafBox).surfaceArea();
+
+			// cost of creating a new parent for this node and the new leaf
+			const float cost = 2.f * combinedArea;
+			// minimum cost of pushing the leaf further down the tree
+			const float inheritanceCost = 2.f * (combinedArea - area);
+
+			auto descendCost = [&](int child) {
+				const BoundingBox& childBox = nodes[child].box;
+				float mergedArea = merge(leafBox, childBox).surfaceArea();
+				if (nodes[child].isLeaf()) {
+					return mergedArea + inheritanceCost;
+				}
+				return mergedArea - childBox.surfaceArea() + inheritanceCost;
+			};
+			const float cost1 = descendCost(node.child1);
+			const float cost2 = descendCost(node.child2);
+
+			if (cost < cost1 && cost < cost2) break;
+			index = cost1 < cost2 ? node.child1 : node.child2;
+		}
+
+		// allocate before taking references, the node vector may grow
+		const int sibling = index;
+		const int newParent = allocateNode();
+		const int oldParent = nodes[sibling].parent;
+
+		nodes[newParent].parent = oldParent;
+		nodes[newParent].box = merge(leafBox, nodes[sibling].box);
+		nodes[newParent].height = nodes[sibling].height + 1;
+		nodes[newParent].child1 = sibling;
+		nodes[newParent].child2 = leaf;
+		nodes[sibling].parent = newParent;
+		nodes[leaf].parent = newParent;
+
+		if (oldParent == NULL_NODE) {
+			root = newParent;
+		} else if (nodes[oldParent].child1 == sibling) {
+			nodes[oldParent].child1 = newParent;
+		} else {
+			nodes[oldParent].child2 = newParent;
+		}
+
+		refitAncestors(nodes[leaf].parent);
+	}
+
+	/**
+	 * @brief Unlinks a leaf from the tree, replacing its parent with its sibling. The leaf node is not freed.
+	 *
+	 * @param leaf Index of the leaf to unlink.
+	 */
+	void LveSceneBvh::removeLeaf(int leaf) {
+		if (leaf == root) {
+			root = NULL_NODE;
+			return;
+		}
+
+		const int parent = nodes[leaf].parent;
+		const int grandParent = nodes[parent].parent;
+		const int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+		if (grandParent == NULL_NODE) {
+			root = sibling;
+			nodes[sibling].parent = NULL_NODE;
+			freeNode(parent);
+			return;
+		}
+
+		if (nodes[grandParent].child1 == parent) {
+			nodes[grandParent].child1 = sibling;
+		} else {
+			nodes[grandParent].child2 = sibling;
+		}
+		nodes[sibling].parent = grandParent;
+		freeNode(parent);
+
+		refitAncestors(grandParent);
+	}
+
+	/**
+	 * @brief Walks from a node to the root, rebalancing and recomputing boxes and heights.
+	 *
+	 * @param nodeIndex The first internal node to refit.
+	 */
+	void LveSceneBvh::refitAncestors(int nodeIndex) {
+		while (nodeIndex != NULL_NODE) {
+			nodeIndex = balance(nodeIndex);
+
+			Node& node = nodes[nodeIndex];
+			const Node& child1 = nodes[node.child1];
+			const Node& child2 = nodes[node.child2];
+			node.height = 1 + std::max(child1.height, child2.height);
+			node.box = merge(child1.box, child2.box);
+
+			nodeIndex = node.parent;
+		}
+	}
+
+	/**
+	 * @brief Performs a left or right rotation if the node's subtrees differ in height by more than one.
+	 *
+	 * @param iA Index of the node to balance.
+	 * @return Index of the node that now occupies iA's position in the tree.
+	 */
+	int LveSceneBvh::balance(int iA) {
+		Node& A = nodes[iA];
+		if (A.isLeaf() || A.height < 2) {
+			return iA;
+		}
+
+		const int iB = A.child1;
+		const int iC = A.child2;
+		Node& B = nodes[iB];
+		Node& C = nodes[iC];
+
+		const int balanceFactor = C.height - B.height;
+
+		// rotate C up
+		if (balanceFactor > 1) {
+			const int iF = C.child1;
+			const int iG = C.child2;
+			Node& F = nodes[iF];
+			Node& G = nodes[iG];
+
+			C.child1 = iA;
+			C.parent = A.parent;
+			A.parent = iC;
+
+			if (C.parent == NULL_NODE) {
+				root = iC;
+			} else if (nodes[C.parent].child1 == iA) {
+				nodes[C.parent].child1 = iC;
+			} else {
+				nodes[C.parent].child2 = iC;
+			}
+
+			if (F.height > G.height) {
+				C.child2 = iF;
+				A.child2 = iG;
+				G.parent = iA;
+				A.box = merge(B.box, G.box);
+				C.box = merge(A.box, F.box);
+				A.height = 1 + std::max(B.height, G.height);
+				C.height = 1 + std::max(A.height, F.height);
+			} else {
+				C.child2 = iG;
+				A.child2 = iF;
+				F.parent = iA;
+				A.box = merge(B.box, F.box);
+				C.box = merge(A.box, G.box);
+				A.height = 1 + std::max(B.height, F.height);
+				C.height = 1 + std::max(A.height, G.height);
+			}
+			return iC;
+		}
+
+		// rotate B up
+		if (balanceFactor < -1) {
+			const int iD = B.child1;
+			const int iE = B.child2;
+			Node& D = nodes[iD];
+			Node& E = nodes[iE];
+
+			B.child1 = iA;
+			B.parent = A.parent;
+			A.parent = iB;
+
+			if (B.parent == NULL_NODE) {
+				root = iB;
+			} else if (nodes[B.parent].child1 == iA) {
+				nodes[B.parent].child1 = iB;
+			} else {
+				nodes[B.parent].child2 = iB;
+			}
+
+			if (D.height > E.height) {
+				B.child2 = iD;
+				A.child1 = iE;
+				E.parent = iA;
+				A.box = merge(C.box, E.box);
+				B.box = merge(A.box, D.box);
+				A.height = 1 + std::max(C.height, E.height);
+				B.height = 1 + std::max(A.height, D.height);
+			} else {
+				B.child2 = iE;
+				A.child1 = iD;
+				D.parent = iA;
+				A.box = merge(C.box, D.box);
+				B.box = merge(A.box, E.box);
+				A.height = 1 + std::max(C.height, D.height);
+				B.height = 1 + std::max(A.height, E.height);
+			}
+			return iB;
+		}
+
+		return iA;
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "lve_bounds.hpp"
+#include "lve_frustum.hpp"
+#include "lve_game_object.hpp"
+
+// std
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace lve {
+
+	/**
+	 * Dynamic bounding volume hierarchy over game object world bounds.
+	 *
+	 * Leaves store boxes enlarged by a margin so small movements only need a containment check instead
+	 * of a reinsert. Internal nodes are kept balanced with tree rotations, similar to Box2D's b2DynamicTree.
+	 * Objects that move must be refit with update(), or marked with markMoved() wherever their transform is
+	 * written and refit together by refitMoved() before the next query.
+	 */
+	class LveSceneBvh {
+	public:
+		using id_t = LveGameObject::id_t;
+
+		struct RayHit {
+			id_t objectId;
+			float distance; // along the ray to the entry point of the object's box
+		};
+
+		explicit LveSceneBvh(float fatMargin = 0.1f);
+
+		LveSceneBvh(const LveSceneBvh&) = delete;
+		LveSceneBvh& operator=(const LveSceneBvh&) = delete;
+
+		void insert(id_t objectId, const BoundingBox& worldBounds);
+		// Inserts many objects at once, built top down with a binned surface area heuristic when the tree is empty
+		void build(const std::vector<std::pair<id_t, BoundingBox>>& objects);
+		void remove(id_t objectId);
+		// returns true if the object left its enlarged box and had to be reinserted
+		bool update(id_t objectId, const BoundingBox& worldBounds);
+		// Remembers that the object's transform changed, objects not in the tree are ignored by the refit
+		void markMoved(id_t objectId) { movedObjects.push_back(objectId); }
+		// Refits every object marked since the last call from its current world bounds, returns how many had to
+		// be reinserted
+		uint32_t refitMoved(LveGameObject::Map& gameObjects);
+		void clear();
+
+		bool contains(id_t objectId) const { return leafForObject.count(objectId) != 0; }
+		size_t size() const { return leafForObject.size(); }
+		int getHeight() const { return root == NULL_NODE ? 0 : nodes[root].height; }
+
+		// Appends the id of every object whose enlarged box intersects the query volume
+		void queryFrustum(const LveFrustum& frustum, std::vector<id_t>& results) const;
+		void querySphere(const BoundingSphere& sphere, std::vector<id_t>& results) const;
+		void queryBox(const BoundingBox& box, std::vector<id_t>& results) const;
+
+		// Finds the closest object box hit by the ray within maxDistance
+		bool raycast(const Ray& ray, float maxDistance, RayHit& hit) const;
+
+	private:
+		static constexpr int NULL_NODE = -1;
+
+		struct Node {
+			BoundingBox box{};
+			int parent = NULL_NODE; // doubles as the next pointer while the node is on the free list
+			int child1 = NULL_NODE;
+			int child2 = NULL_NODE;
+			int height = -1; // leaves are 0, free nodes -1
+			id_t objectId = 0;
+
+			bool isLeaf() const { return child1 == NULL_NODE; }
+		};
+
+		int allocateNode();
+		void freeNode(int nodeIndex);
+		void insertLeaf(int leaf);
+		int buildSubtree(int* leaves, size_t count);
+		void removeLeaf(int leaf);
+		int balance(int nodeIndex);
+		void refitAncestors(int nodeIndex);
+		void collectLeaves(int nodeIndex, std::vector<id_t>& results) const;
+
+		std::vector<Node> nodes;
+		int root = NULL_NODE;
+		int freeList = NULL_NODE;
+		float fatMargin;
+		std::unordered_map<id_t, int> leafForObject;
+		std::vector<id_t> movedObjects;
+	};
+}
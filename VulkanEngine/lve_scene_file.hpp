@@ -0,0 +1,106 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_game_object.hpp"
+#include "lve_scene_bvh.hpp"
+
+// std
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace lve {
+
+	// Binary scene layout, all values little endian:
+	// SceneFileHeader | SceneModelRecord[modelCount] | SceneEntityRecord[entityCount] | string table
+	// Records are fixed size plain data so a mapped file can be read in place without parsing.
+	constexpr char SCENE_FILE_MAGIC[4] = { 'L', 'V', 'E', 'S' };
+	constexpr uint32_t SCENE_FILE_VERSION = 1;
+
+	struct SceneFileHeader {
+		char magic[4];
+		uint32_t version;
+		uint32_t modelCount;
+		uint32_t entityCount;
+		uint64_t modelOffset;
+		uint64_t entityOffset;
+		uint64_t stringOffset;
+		uint64_t stringSize;
+	};
+
+	struct SceneModelRecord {
+		uint32_t pathOffset; // into the string table
+		uint32_t pathLength;
+	};
+
+	enum SceneEntityFlags : uint32_t {
+		SCENE_ENTITY_POINT_LIGHT = 1u << 0,
+		SCENE_ENTITY_OCCLUDER = 1u << 1,
+	};
+
+	struct SceneEntityRecord {
+		float translation[3];
+		float rotation[3];
+		float scale[3];
+		float color[3];
+		int32_t modelIndex; // -1 for entities without a model
+		uint32_t flags;     // SceneEntityFlags
+		float lightIntensity;
+		float lightRadius;
+	};
+
+	static_assert(sizeof(SceneFileHeader) == 48, "scene header layout must not change");
+	static_assert(sizeof(SceneModelRecord) == 8, "scene model record layout must not change");
+	static_assert(sizeof(SceneEntityRecord) == 64, "scene entity record layout must not change");
+
+	// Milliseconds spent in each phase of LveSceneFile::createGameObjects
+	struct SceneLoadTimes {
+		float modelMs = 0.f;
+		float entityMs = 0.f;
+		float bvhMs = 0.f;
+	};
+
+	/**
+	 * Read only view of a binary scene file mapped into memory.
+	 *
+	 * The header and record ranges are validated once on open, afterwards records are handed out
+	 * directly from the mapping. The mapping stays valid for the lifetime of the object.
+	 */
+	class LveSceneFile {
+	public:
+		explicit LveSceneFile(const std::string& filepath);
+		~LveSceneFile();
+
+		LveSceneFile(const LveSceneFile&) = delete;
+		LveSceneFile& operator=(const LveSceneFile&) = delete;
+
+		uint32_t getModelCount() const { return header->modelCount; }
+		std::string_view getModelPath(uint32_t modelIndex) const;
+
+		uint32_t getEntityCount() const { return header->entityCount; }
+		const SceneEntityRecord* getEntities() const { return entities; }
+
+		// Creates a game object per entity, loading every referenced model once, then builds the BVH over the
+		// models in one pass
+		SceneLoadTimes createGameObjects(LveDevice& device, LveGameObject::Map& gameObjects, LveSceneBvh& sceneBvh) const;
+
+		// Converts the text scene description into the binary format, throws on syntax errors
+		static void convertTextToBinary(const std::string& textPath, const std::string& binaryPath);
+		// Converts only if the binary file is missing or older than the text description
+		static void convertIfOutdated(const std::string& textPath, const std::string& binaryPath);
+
+	private:
+		void unmap();
+
+		const uint8_t* data = nullptr;
+		size_t size = 0;
+		const SceneFileHeader* header = nullptr;
+		const SceneModelRecord* models = nullptr;
+		const SceneEntityRecord* entities = nullptr;
+		const char* strings = nullptr;
+
+		// platform handles of the mapping
+		void* fileHandle = nullptr;
+		void* mappingHandle = nullptr;
+	};
+}
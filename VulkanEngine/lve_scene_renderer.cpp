@@ -0,0 +1,180 @@
+/**
+ * @file lve_scene_renderer.cpp
+ * @brief Implementation of the LveSceneRenderer class, which sets up and records the scene for both applications.
+ *
+ * This file contains the creation of the global uniform buffers, descriptor sets and render systems, and the
+ * per frame update and recording of the scene into secondary command buffers.
+ */
+
+#include "lve_scene_renderer.hpp"
+
+namespace lve {
+
+	/**
+	 * @brief Creates the per frame resources and the render systems.
+	 *
+	 * @param device The device everything is created on.
+	 * @param jobSystem Compiles the pipelines and records the object draws in parallel.
+	 * @param globalPool Pool the global descriptor sets are allocated from, with a uniform buffer and three
+	 *        storage buffers per frame in flight.
+	 * @param renderPass Render pass the pipelines are created for.
+	 * @param framesInFlight Number of frames the CPU may record ahead of the GPU.
+	 * @param gameObjects The scene's objects.
+	 * @param sceneBvh The hierarchy over the objects' bounds, used for culling.
+	 * @param createGpuDrivenSystem Whether to upload the scene for GPU driven rendering, when it is supported.
+	 */
+	LveSceneRenderer::LveSceneRenderer(
+		LveDevice& device,
+		LveJobSystem& jobSystem,
+		LveDescriptorPool& globalPool,
+		VkRenderPass renderPass,
+		uint32_t framesInFlight,
+		LveGameObject::Map& gameObjects,
+		LveSceneBvh& sceneBvh,
+		bool createGpuDrivenSystem)
+		: gameObjects{ gameObjects },
+		sceneBvh{ sceneBvh },
+		lightClusters{ device, jobSystem, framesInFlight },
+		globalSetLayout{
+			LveDescriptorSetLayout::Builder(device)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+			.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+			.addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+			.addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+			.build() },
+		pipelineCompiler{ device, jobSystem },
+		simpleRenderSystem{
+			device,
+			jobSystem,
+			pipelineCompiler,
+			renderPass,
+			globalSetLayout->getDescriptorSetLayout(),
+			framesInFlight },
+		pointLightSystem{
+			device,
+			jobSystem,
+			pipelineCompiler,
+			renderPass,
+			globalSetLayout->getDescriptorSetLayout(),
+			framesInFlight },
+		commandRecorder{ device, jobSystem, framesInFlight },
+		gpuProfiler{ device, framesInFlight } {
+		uboBuffers.resize(framesInFlight);
+		for (int i = 0; i < uboBuffers.size(); i++) {
+			uboBuffers[i] = std::make_unique<LveBuffer>(
+				device,
+				sizeof(GlobalUbo),
+				1,
+				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+			uboBuffers[i]->map();
+		}
+
+		globalDescriptorSets.resize(framesInFlight);
+		for (int i = 0; i < globalDescriptorSets.size(); i++) {
+			auto bufferInfo = uboBuffers[i]->descriptorInfo();
+			auto lightInfo = lightClusters.getLightBufferInfo(i);
+			auto clusterInfo = lightClusters.getClusterBufferInfo(i);
+			auto lightIndexInfo = lightClusters.getLightIndexBufferInfo(i);
+			LveDescriptorWriter(*globalSetLayout, globalPool)
+				.writeBuffer(0, &bufferInfo)
+				.writeBuffer(1, &lightInfo)
+				.writeBuffer(2, &clusterInfo)
+				.writeBuffer(3, &lightIndexInfo)
+				.build(globalDescriptorSets[i]);
+		}
+
+		if (createGpuDrivenSystem && GpuDrivenRenderSystem::isSupported(device)) {
+			gpuDrivenRenderSystem = std::make_unique<GpuDrivenRenderSystem>(
+				device,
+				pipelineCompiler,
+				renderPass,
+				globalSetLayout->getDescriptorSetLayout(),
+				framesInFlight);
+			gpuDrivenRenderSystem->uploadScene(gameObjects);
+		}
+	}
+
+	LveSceneRenderer::~LveSceneRenderer() {}
+
+	/**
+	 * @brief Collects the profiler's results of the frame slot and begins the frame's GPU timing.
+	 *
+	 * @param commandBuffer The frame's primary command buffer, outside of any render pass.
+	 * @param frameIndex The frame in flight being recorded.
+	 * @param frameTime Seconds the scene advances by this frame.
+	 * @param camera The camera the frame is rendered from, its projection already set.
+	 * @return The frame info passed to the render systems.
+	 */
+	FrameInfo LveSceneRenderer::beginFrame(
+		VkCommandBuffer commandBuffer, int frameIndex, float frameTime, LveCamera& camera) {
+		gpuProfiler.beginFrame(commandBuffer, frameIndex);
+		frameZone = gpuProfiler.beginZone(commandBuffer, "frame");
+		return FrameInfo{
+			frameIndex,
+			frameTime,
+			commandBuffer,
+			camera,
+			globalDescriptorSets[frameIndex],
+			gameObjects,
+			&sceneBvh,
+			&commandRecorder,
+			&gpuProfiler
+		};
+	}
+
+	void LveSceneRenderer::update(FrameInfo& frameInfo) {
+		GlobalUbo ubo{};
+		ubo.projection = frameInfo.camera.getProjection();
+		ubo.view = frameInfo.camera.getView();
+		ubo.inverseView = frameInfo.camera.getInverseView();
+		pointLightSystem.update(frameInfo);
+		// culling trusts the tree, so objects moved this frame are refit before anything queries it
+		sceneBvh.refitMoved(gameObjects);
+		lightClusters.update(frameInfo, ubo);
+		uboBuffers[frameInfo.frameIndex]->writeToBuffer(&ubo);
+		uboBuffers[frameInfo.frameIndex]->flush();
+	}
+
+	/**
+	 * @brief Culls the scene and records its draws into secondaries for a render pass instance.
+	 *
+	 * @param frameInfo The frame info returned by beginFrame.
+	 * @param renderPass The render pass the secondaries are executed in.
+	 * @param framebuffer The framebuffer of the render pass instance.
+	 * @param extent The area rendered to, the secondaries' viewport and scissor.
+	 *
+	 * GPU driven culling records its compute pass into the primary command buffer, so this must be called before
+	 * the caller begins the render pass.
+	 */
+	void LveSceneRenderer::record(
+		FrameInfo& frameInfo, VkRenderPass renderPass, VkFramebuffer framebuffer, VkExtent2D extent) {
+		if (gpuDrivenRendering) {
+			gpuDrivenRenderSystem->cull(frameInfo);
+		}
+		commandRecorder.beginFrame(frameInfo.frameIndex, renderPass, framebuffer, extent);
+		if (gpuDrivenRendering) {
+			commandRecorder.record([&](VkCommandBuffer secondary) {
+				FrameInfo secondaryInfo = frameInfo;
+				secondaryInfo.commandBuffer = secondary;
+				gpuDrivenRenderSystem->render(secondaryInfo);
+			});
+		} else {
+			simpleRenderSystem.renderGameObjects(frameInfo);
+		}
+		commandRecorder.record([&](VkCommandBuffer secondary) {
+			FrameInfo secondaryInfo = frameInfo;
+			secondaryInfo.commandBuffer = secondary;
+			pointLightSystem.render(secondaryInfo);
+		});
+	}
+
+	void LveSceneRenderer::executeSecondaries(VkCommandBuffer commandBuffer) {
+		commandRecorder.executeSecondaries(commandBuffer);
+	}
+
+	void LveSceneRenderer::endFrame(VkCommandBuffer commandBuffer) {
+		gpuProfiler.endZone(commandBuffer, frameZone);
+		frameZone = LveGpuProfiler::ZoneHandle{};
+	}
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "gpu_driven_render_system.hpp"
+#include "lve_buffer.hpp"
+#include "lve_camera.hpp"
+#include "lve_command_recorder.hpp"
+#include "lve_descriptors.hpp"
+#include "lve_device.hpp"
+#include "lve_frame_info.hpp"
+#include "lve_game_object.hpp"
+#include "lve_gpu_profiler.hpp"
+#include "lve_job_system.hpp"
+#include "lve_light_clusters.hpp"
+#include "lve_pipeline_compiler.hpp"
+#include "lve_scene_bvh.hpp"
+#include "point_light_system.hpp"
+#include "simple_render_system.hpp"
+
+// std
+#include <memory>
+#include <vector>
+
+namespace lve {
+
+	/**
+	 * The scene's per frame resources and render systems, shared by the windowed and the headless application.
+	 *
+	 * Owns the global uniform buffers, the light clusters and the global descriptor sets at bindings 0 to 3, the
+	 * pipeline compiler, the render systems, the secondary command recorder and the GPU profiler. A frame is
+	 * recorded in four steps: beginFrame() starts its GPU timing, update() writes the uniforms and light clusters,
+	 * record() culls and records the scene into secondaries for the caller's render pass, and executeSecondaries()
+	 * runs them inside it. endFrame() closes the frame's timing after whatever else the caller records, like an
+	 * upscale blit or a readback copy.
+	 *
+	 * The render pass the systems are created for may differ from the one recorded into, as long as the two are
+	 * compatible, like the swap chain's and an offscreen scene target's.
+	 */
+	class LveSceneRenderer {
+	public:
+		// gameObjects and sceneBvh must outlive the renderer, createGpuDrivenSystem uploads the scene for GPU
+		// driven rendering when the device supports it
+		LveSceneRenderer(
+			LveDevice& device,
+			LveJobSystem& jobSystem,
+			LveDescriptorPool& globalPool,
+			VkRenderPass renderPass,
+			uint32_t framesInFlight,
+			LveGameObject::Map& gameObjects,
+			LveSceneBvh& sceneBvh,
+			bool createGpuDrivenSystem);
+		~LveSceneRenderer();
+
+		LveSceneRenderer(const LveSceneRenderer&) = delete;
+		LveSceneRenderer& operator=(const LveSceneRenderer&) = delete;
+
+		// Starts the frame's GPU timing and returns its frame info, call after the renderer's beginFrame
+		FrameInfo beginFrame(VkCommandBuffer commandBuffer, int frameIndex, float frameTime, LveCamera& camera);
+		// Writes the global uniforms, moves the point lights, refits moved objects and bins the lights into clusters
+		void update(FrameInfo& frameInfo);
+		// Culls and records the scene into secondaries for the given render pass instance
+		void record(FrameInfo& frameInfo, VkRenderPass renderPass, VkFramebuffer framebuffer, VkExtent2D extent);
+		// Executes the recorded secondaries, inside a render pass begun with secondary command buffer contents
+		void executeSecondaries(VkCommandBuffer commandBuffer);
+		// Ends the frame's GPU timing
+		void endFrame(VkCommandBuffer commandBuffer);
+
+		bool supportsGpuDrivenRendering() const { return gpuDrivenRenderSystem != nullptr; }
+		// ignored when GPU driven rendering is not supported
+		void setGpuDrivenRendering(bool enabled) { gpuDrivenRendering = enabled && supportsGpuDrivenRendering(); }
+		bool isGpuDrivenRendering() const { return gpuDrivenRendering; }
+
+		SimpleRenderSystem& getSimpleRenderSystem() { return simpleRenderSystem; }
+		GpuDrivenRenderSystem* getGpuDrivenRenderSystem() { return gpuDrivenRenderSystem.get(); }
+		LvePipelineCompiler& getPipelineCompiler() { return pipelineCompiler; }
+		LveGpuProfiler& getGpuProfiler() { return gpuProfiler; }
+		// light and cluster entry counts of the latest update, including the ones dropped for lack of space
+		const LveLightClusters& getLightClusters() const { return lightClusters; }
+
+	private:
+		LveGameObject::Map& gameObjects;
+		LveSceneBvh& sceneBvh;
+
+		std::vector<std::unique_ptr<LveBuffer>> uboBuffers;
+		// point lights binned into view frustum clusters, read by the fragment shader at bindings 1 to 3
+		LveLightClusters lightClusters;
+		std::unique_ptr<LveDescriptorSetLayout> globalSetLayout;
+		std::vector<VkDescriptorSet> globalDescriptorSets;
+
+		// order of declaration matters, the systems compile their pipelines on the job system and skip drawing
+		// until they are ready
+		LvePipelineCompiler pipelineCompiler;
+		SimpleRenderSystem simpleRenderSystem;
+		PointLightSystem pointLightSystem;
+		std::unique_ptr<GpuDrivenRenderSystem> gpuDrivenRenderSystem;
+		bool gpuDrivenRendering = false;
+
+		// the render pass is recorded into secondaries, object draws split across the job system
+		LveCommandRecorder commandRecorder;
+		// GPU time of each render system and pass
+		LveGpuProfiler gpuProfiler;
+		LveGpuProfiler::ZoneHandle frameZone{};
+	};
+}
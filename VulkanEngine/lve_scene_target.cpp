@@ -0,0 +1,316 @@
+/**
+ * @file lve_scene_target.cpp
+ * @brief Implementation of the LveSceneTarget class, the dynamically scaled offscreen scene target.
+ *
+ * This file contains the creation of the offscreen images and their render pass, the frame time controller
+ * choosing the render scale and the upscaling blit onto the swap chain image.
+ */
+
+#include "lve_scene_target.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+
+namespace lve {
+
+	namespace {
+		// weight of the newest frame in the smoothed frame time
+		constexpr float FRAME_TIME_SMOOTHING = 0.1f;
+		// frames the smoothed time needs to settle on a new scale before it is judged again
+		constexpr uint32_t MIN_FRAMES_BETWEEN_CHANGES = 30;
+		// the scale drops above OVER_BUDGET times the budget and rises below UNDER_BUDGET times the budget,
+		// the gap keeps it from oscillating around the budget
+		constexpr float OVER_BUDGET = 1.05f;
+		constexpr float UNDER_BUDGET = 0.8f;
+		// scales are multiples of this, so tiny frame time changes do not change the resolution
+		constexpr float SCALE_STEP = 0.05f;
+	}
+
+	/**
+	 * @brief Checks that the swap chain's color format can be rendered to, blitted from and blitted to.
+	 *
+	 * @param device The device the target would be created on.
+	 * @param colorFormat The swap chain image format.
+	 */
+	bool LveSceneTarget::isSupported(LveDevice& device, VkFormat colorFormat) {
+		try {
+			device.findSupportedFormat(
+				{ colorFormat },
+				VK_IMAGE_TILING_OPTIMAL,
+				VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT);
+		} catch (const std::runtime_error&) {
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Creates the render pass, one color image per frame in flight and a shared depth image.
+	 *
+	 * @param device The device the images are created on.
+	 * @param colorFormat The swap chain image format.
+	 * @param depthFormat The swap chain depth format.
+	 * @param windowExtent The swap chain extent the scene is upscaled to.
+	 * @param framesInFlight Number of frames the renderer keeps in flight, each gets its own color image.
+	 * @param settings Scale bounds and frame time budget of the controller.
+	 */
+	LveSceneTarget::LveSceneTarget(
+		LveDevice& device,
+		VkFormat colorFormat,
+		VkFormat depthFormat,
+		VkExtent2D windowExtent,
+		uint32_t framesInFlight,
+		const Settings& settings)
+		: lveDevice{ device },
+		colorFormat{ colorFormat },
+		depthFormat{ depthFormat },
+		windowExtent{ windowExtent },
+		framesInFlight{ framesInFlight },
+		settings{ settings },
+		scale{ settings.maxScale } {
+		// the color image is left ready for the upscaling blit
+		renderPass = createColorDepthRenderPass(
+			lveDevice, colorFormat, depthFormat, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+		createFrames();
+	}
+
+	LveSceneTarget::~LveSceneTarget() {
+		for (auto& retired : retiredFrames) {
+			destroyFrames(retired.frames, retired.depth);
+		}
+		destroyFrames(frames, depth);
+		vkDestroyRenderPass(lveDevice.device(), renderPass, nullptr);
+	}
+
+	/**
+	 * @brief Reallocates the images for a new window extent without waiting for the device.
+	 *
+	 * Frames already submitted may still render into or blit from the old images, so they are kept until every
+	 * frame in flight has begun the render pass again, which happens after that frame's fence wait.
+	 */
+	void LveSceneTarget::resize(VkExtent2D newWindowExtent) {
+		retiredFrames.push_back({ std::move(frames), depth, framesInFlight });
+		frames.clear();
+		depth = {};
+		windowExtent = newWindowExtent;
+		createFrames();
+	}
+
+	/**
+	 * @brief Replaces the controller settings.
+	 *
+	 * The images are reallocated when the maximum scale changes.
+	 */
+	void LveSceneTarget::setSettings(const Settings& newSettings) {
+		bool reallocate = newSettings.maxScale != settings.maxScale;
+		settings = newSettings;
+		scale = std::clamp(scale, settings.minScale, settings.maxScale);
+		if (reallocate) {
+			resize(windowExtent);
+		}
+	}
+
+	/**
+	 * @brief Adjusts the render scale towards the frame time budget.
+	 *
+	 * @param frameTime Time in seconds the latest frame's rendering took, excluding waits on presentation, fences
+	 *        and frame pacing, which would otherwise lower the resolution of a frame limited but idle GPU.
+	 */
+	void LveSceneTarget::updateScale(float frameTime) {
+		// smoothed so single slow frames, like the first use of a pipeline, do not change the resolution
+		smoothedFrameTime = smoothedFrameTime <= 0.f
+			? frameTime
+			: smoothedFrameTime + FRAME_TIME_SMOOTHING * (frameTime - smoothedFrameTime);
+		if (++framesSinceScaleChange < MIN_FRAMES_BETWEEN_CHANGES) return;
+
+		const float budget = settings.targetFrameTime;
+		float newScale = scale;
+		if (smoothedFrameTime > budget * OVER_BUDGET) {
+			// pixel cost grows with the area, so the edge scale that fits the budget follows the square root
+			newScale = std::floor(scale * std::sqrt(budget / smoothedFrameTime) / SCALE_STEP) * SCALE_STEP;
+		} else if (smoothedFrameTime < budget * UNDER_BUDGET) {
+			newScale = scale + SCALE_STEP;
+		}
+		newScale = std::clamp(newScale, settings.minScale, settings.maxScale);
+
+		if (newScale != scale) {
+			scale = newScale;
+			framesSinceScaleChange = 0;
+		}
+	}
+
+	VkExtent2D LveSceneTarget::getRenderExtent() const {
+		VkExtent2D extent{
+			static_cast<uint32_t>(static_cast<float>(windowExtent.width) * scale),
+			static_cast<uint32_t>(static_cast<float>(windowExtent.height) * scale) };
+		extent.width = std::clamp(extent.width, 1u, imageExtent.width);
+		extent.height = std::clamp(extent.height, 1u, imageExtent.height);
+		return extent;
+	}
+
+	/**
+	 * @brief Begins the scene render pass on the frame's images, restricted to the current render extent.
+	 *
+	 * @param commandBuffer The frame's primary command buffer.
+	 * @param frameIndex The frame in flight whose images are rendered to.
+	 * @param contents Inline commands, or secondaries that set the viewport and scissor themselves.
+	 */
+	void LveSceneTarget::beginRenderPass(VkCommandBuffer commandBuffer, int frameIndex, VkSubpassContents contents) {
+		for (auto& retired : retiredFrames) {
+			retired.framesUntilRelease--;
+		}
+		for (auto it = retiredFrames.begin(); it != retiredFrames.end();) {
+			if (it->framesUntilRelease == 0) {
+				destroyFrames(it->frames, it->depth);
+				it = retiredFrames.erase(it);
+			} else {
+				++it;
+			}
+		}
+
+		const VkExtent2D renderExtent = getRenderExtent();
+
+		VkRenderPassBeginInfo renderPassInfo{};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		renderPassInfo.renderPass = renderPass;
+		renderPassInfo.framebuffer = frames[frameIndex].framebuffer;
+		renderPassInfo.renderArea.offset = { 0, 0 };
+		renderPassInfo.renderArea.extent = renderExtent;
+
+		std::array<VkClearValue, 2> clearValues{};
+		clearValues[0].color = { 0.01f, 0.01f, 0.01f, 1.0f };
+		clearValues[1].depthStencil = { 1.0f, 0 };
+		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+		renderPassInfo.pClearValues = clearValues.data();
+
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+		if (contents != VK_SUBPASS_CONTENTS_INLINE) {
+			return;
+		}
+
+		VkViewport viewport{};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = static_cast<float>(renderExtent.width);
+		viewport.height = static_cast<float>(renderExtent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		VkRect2D scissor{ {0, 0}, renderExtent };
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+	}
+
+	void LveSceneTarget::endRenderPass(VkCommandBuffer commandBuffer) {
+		vkCmdEndRenderPass(commandBuffer);
+	}
+
+	/**
+	 * @brief Upscales the frame's rendered area onto a swap chain image.
+	 *
+	 * @param commandBuffer The frame's primary command buffer, after endRenderPass.
+	 * @param frameIndex The frame in flight whose color image is read.
+	 * @param swapChainImage The acquired swap chain image, created with transfer destination usage.
+	 * @param swapChainExtent The extent of the swap chain image.
+	 *
+	 * The first barrier waits at the color attachment output stage, the stage the submission waits on the image
+	 * acquisition semaphore at, so the blit never writes an image the presentation engine still reads.
+	 */
+	void LveSceneTarget::blitToSwapChain(
+		VkCommandBuffer commandBuffer, int frameIndex, VkImage swapChainImage, VkExtent2D swapChainExtent) {
+		VkImageMemoryBarrier toTransfer{};
+		toTransfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		toTransfer.srcAccessMask = 0;
+		toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		toTransfer.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		toTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		toTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		toTransfer.image = swapChainImage;
+		toTransfer.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0,
+			0, nullptr,
+			0, nullptr,
+			1, &toTransfer);
+
+		const VkExtent2D renderExtent = getRenderExtent();
+		VkImageBlit blit{};
+		blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		blit.srcOffsets[1] = { static_cast<int32_t>(renderExtent.width), static_cast<int32_t>(renderExtent.height), 1 };
+		blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		blit.dstOffsets[1] = { static_cast<int32_t>(swapChainExtent.width), static_cast<int32_t>(swapChainExtent.height), 1 };
+		vkCmdBlitImage(
+			commandBuffer,
+			frames[frameIndex].color.image,
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			swapChainImage,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			1,
+			&blit,
+			VK_FILTER_LINEAR);
+
+		VkImageMemoryBarrier toPresent = toTransfer;
+		toPresent.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		toPresent.dstAccessMask = 0;
+		toPresent.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		toPresent.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			0,
+			0, nullptr,
+			0, nullptr,
+			1, &toPresent);
+	}
+
+	/**
+	 * @brief Creates the per frame color images and framebuffers around one shared depth buffer.
+	 */
+	void LveSceneTarget::createFrames() {
+		imageExtent = {
+			std::max(1u, static_cast<uint32_t>(std::ceil(static_cast<float>(windowExtent.width) * settings.maxScale))),
+			std::max(1u, static_cast<uint32_t>(std::ceil(static_cast<float>(windowExtent.height) * settings.maxScale))) };
+
+		depth = createTransientDepthImage(lveDevice, depthFormat, imageExtent);
+
+		frames.resize(framesInFlight);
+		for (auto& frame : frames) {
+			frame.color = createAttachmentImage(
+				lveDevice,
+				colorFormat,
+				imageExtent,
+				VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+				VK_IMAGE_ASPECT_COLOR_BIT);
+
+			std::array<VkImageView, 2> attachments = { frame.color.view, depth.view };
+			VkFramebufferCreateInfo framebufferInfo{};
+			framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+			framebufferInfo.renderPass = renderPass;
+			framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+			framebufferInfo.pAttachments = attachments.data();
+			framebufferInfo.width = imageExtent.width;
+			framebufferInfo.height = imageExtent.height;
+			framebufferInfo.layers = 1;
+			if (vkCreateFramebuffer(lveDevice.device(), &framebufferInfo, nullptr, &frame.framebuffer) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to create scene framebuffer!");
+			}
+		}
+	}
+
+	void LveSceneTarget::destroyFrames(std::vector<FrameImages>& frameImages, LveAttachmentImage& depthImage) {
+		for (auto& frame : frameImages) {
+			vkDestroyFramebuffer(lveDevice.device(), frame.framebuffer, nullptr);
+			destroyAttachmentImage(lveDevice, frame.color);
+		}
+		frameImages.clear();
+		destroyAttachmentImage(lveDevice, depthImage);
+	}
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "lve_attachments.hpp"
+#include "lve_device.hpp"
+
+// std
+#include <vector>
+
+namespace lve {
+
+	/**
+	 * Offscreen color and depth target the scene is rendered into at a dynamically scaled resolution.
+	 *
+	 * Images are allocated once at the window extent times the maximum scale, and each frame renders into the
+	 * top left part matching the current scale, so changing the resolution never reallocates. The rendered area
+	 * is then blitted with linear filtering onto the whole swap chain image, which is left ready to present.
+	 *
+	 * The render pass uses the swap chain's color and depth formats, which makes it compatible with the swap chain
+	 * render pass: pipelines created for one can be used in the other.
+	 *
+	 * The scale follows a frame time controller. When the smoothed frame time exceeds the budget the scale drops
+	 * to the value expected to fit it, pixel cost being proportional to the area. Once frames are comfortably
+	 * under budget it climbs back in small steps. The controller is fed the time the frame's work took, like its
+	 * GPU time, not the time between frames: that includes waits on presentation and frame pacing, which a lower
+	 * resolution cannot shorten.
+	 */
+	class LveSceneTarget {
+	public:
+		struct Settings {
+			float minScale = 0.5f;
+			float maxScale = 1.f;
+			float targetFrameTime = 1.f / 60.f;
+		};
+
+		// True if images of the swap chain's color format can be rendered to and blitted
+		static bool isSupported(LveDevice& device, VkFormat colorFormat);
+
+		LveSceneTarget(
+			LveDevice& device,
+			VkFormat colorFormat,
+			VkFormat depthFormat,
+			VkExtent2D windowExtent,
+			uint32_t framesInFlight,
+			const Settings& settings = Settings{});
+		~LveSceneTarget();
+
+		LveSceneTarget(const LveSceneTarget&) = delete;
+		LveSceneTarget& operator=(const LveSceneTarget&) = delete;
+
+		// Reallocates the images for a new swap chain extent, the old ones are released once no frame uses them
+		void resize(VkExtent2D windowExtent);
+		VkExtent2D getWindowExtent() const { return windowExtent; }
+
+		// Feeds the controller with the latest frame's work time, the scale changes between frames only
+		void updateScale(float frameTime);
+		void setSettings(const Settings& newSettings);
+		const Settings& getSettings() const { return settings; }
+		float getScale() const { return scale; }
+		// the part of the images rendered at the current scale
+		VkExtent2D getRenderExtent() const;
+
+		VkRenderPass getRenderPass() const { return renderPass; }
+		VkFramebuffer getFramebuffer(int frameIndex) const { return frames[frameIndex].framebuffer; }
+
+		void beginRenderPass(
+			VkCommandBuffer commandBuffer, int frameIndex, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+		void endRenderPass(VkCommandBuffer commandBuffer);
+
+		// Upscales the rendered area onto the swap chain image and transitions that to the present layout
+		void blitToSwapChain(
+			VkCommandBuffer commandBuffer, int frameIndex, VkImage swapChainImage, VkExtent2D swapChainExtent);
+
+	private:
+		struct FrameImages {
+			LveAttachmentImage color;
+			VkFramebuffer framebuffer = VK_NULL_HANDLE;
+		};
+
+		void createFrames();
+		void destroyFrames(std::vector<FrameImages>& frameImages, LveAttachmentImage& depthImage);
+
+		LveDevice& lveDevice;
+		VkFormat colorFormat;
+		VkFormat depthFormat;
+		VkExtent2D windowExtent;
+		uint32_t framesInFlight;
+		// extent of the allocated images, windowExtent at the maximum scale
+		VkExtent2D imageExtent{};
+
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+		std::vector<FrameImages> frames;
+		// one depth buffer shared by every frame in flight
+		LveAttachmentImage depth;
+
+		struct RetiredFrames {
+			std::vector<FrameImages> frames;
+			LveAttachmentImage depth;
+			// render passes still to be begun, each after its frame's fence wait, before the images are unused
+			uint32_t framesUntilRelease;
+		};
+		std::vector<RetiredFrames> retiredFrames;
+
+		Settings settings;
+		float scale = 1.f;
+		float smoothedFrameTime = 0.f;
+		uint32_t framesSinceScaleChange = 0;
+	};
+}
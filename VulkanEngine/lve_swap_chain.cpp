@@ -1,7 +1,11 @@
 #include "lve_swap_chain.hpp"
 
+#include "lve_attachments.hpp"
+
 // std
+#include <algorithm>
 #include <array>
+#include <chrono>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
@@ -11,26 +15,56 @@
 
 namespace lve {
 
-    LveSwapChain::LveSwapChain(LveDevice& deviceRef, VkExtent2D extent)
-        : device{ deviceRef }, windowExtent{ extent } {
+    LveSwapChain::LveSwapChain(
+        LveDevice& deviceRef, VkExtent2D extent, uint32_t framesInFlight, VkPresentModeKHR preferredPresentMode)
+        : device{ deviceRef },
+        windowExtent{ extent },
+        framesInFlight{ framesInFlight },
+        preferredPresentMode{ preferredPresentMode } {
         init();
     }
 
-    LveSwapChain::LveSwapChain(LveDevice& deviceRef, VkExtent2D extent, std::shared_ptr<LveSwapChain> previous)
-        : device{ deviceRef }, windowExtent{ extent }, oldSwapChain{previous} {
+    LveSwapChain::LveSwapChain(
+        LveDevice& deviceRef,
+        VkExtent2D extent,
+        uint32_t framesInFlight,
+        VkPresentModeKHR preferredPresentMode,
+        std::shared_ptr<LveSwapChain> previous)
+        : device{ deviceRef },
+        windowExtent{ extent },
+        framesInFlight{ framesInFlight },
+        preferredPresentMode{ preferredPresentMode },
+        oldSwapChain{previous} {
         init();
 
-        // clean up old swap chain sinze it's no longer needed
+        // the caller keeps the old swap chain alive until frames still in flight no longer use its images
         oldSwapChain = nullptr;
     }
 
+    /**
+     * Creates the swap chain and its attachments.
+     *
+     * When replacing a previous swap chain, everything that does not depend on the images carries over: the
+     * render pass if the formats are unchanged, which also keeps pipelines created against it valid, the depth
+     * buffer if the extent is unchanged, and the frame fences and semaphores together with the current frame.
+     */
     void LveSwapChain::init() {
         createSwapChain();
         createImageViews();
-        createRenderPass();
+        swapChainDepthFormat = findDepthFormat();
+        if (oldSwapChain != nullptr && oldSwapChain->compareSwapFormats(*this)) {
+            renderPass = oldSwapChain->renderPass;
+            oldSwapChain->renderPass = VK_NULL_HANDLE;
+        } else {
+            createRenderPass();
+        }
         createDepthResources();
         createFramebuffers();
-        createSyncObjects();
+        if (oldSwapChain != nullptr) {
+            adoptSyncObjects(*oldSwapChain);
+        } else {
+            createSyncObjects();
+        }
     }
 
     LveSwapChain::~LveSwapChain() {
@@ -44,11 +78,10 @@ namespace lve {
             swapChain = nullptr;
         }
 
-        for (int i = 0; i < depthImages.size(); i++) {
-            vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
-            vkDestroyImage(device.device(), depthImages[i], nullptr);
-            vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
-        }
+        // null if a newer swap chain took it over
+        vkDestroyImageView(device.device(), depthImageView, nullptr);
+        vkDestroyImage(device.device(), depthImage, nullptr);
+        vkFreeMemory(device.device(), depthImageMemory, nullptr);
 
         for (auto framebuffer : swapChainFramebuffers) {
             vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
@@ -57,7 +90,8 @@ namespace lve {
         vkDestroyRenderPass(device.device(), renderPass, nullptr);
 
         // cleanup synchronization objects
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        // empty if a newer swap chain took them over
+        for (size_t i = 0; i < inFlightFences.size(); i++) {
             vkDestroySemaphore(device.device(), renderFinishedSemaphores[i], nullptr);
             vkDestroySemaphore(device.device(), imageAvailableSemaphores[i], nullptr);
             vkDestroyFence(device.device(), inFlightFences[i], nullptr);
@@ -65,12 +99,14 @@ namespace lve {
     }
 
     VkResult LveSwapChain::acquireNextImage(uint32_t* imageIndex) {
+        auto waitStart = std::chrono::high_resolution_clock::now();
         vkWaitForFences(
             device.device(),
             1,
             &inFlightFences[currentFrame],
             VK_TRUE,
             std::numeric_limits<uint64_t>::max());
+        fenceWaitTime = std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - waitStart).count();
 
         VkResult result = vkAcquireNextImageKHR(
             device.device(),
@@ -86,7 +122,11 @@ namespace lve {
     VkResult LveSwapChain::submitCommandBuffers(
         const VkCommandBuffer* buffers, uint32_t* imageIndex) {
         if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE) {
+            // with more frames in flight than images, an image can still be in use by an older frame
+            auto waitStart = std::chrono::high_resolution_clock::now();
             vkWaitForFences(device.device(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
+            fenceWaitTime +=
+                std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - waitStart).count();
         }
         imagesInFlight[*imageIndex] = inFlightFences[currentFrame];
 
@@ -111,6 +151,7 @@ namespace lve {
             VK_SUCCESS) {
             throw std::runtime_error("failed to submit draw command buffer!");
         }
+        lastSubmitTime = std::chrono::high_resolution_clock::now();
 
         VkPresentInfoKHR presentInfo = {};
         presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -126,7 +167,7 @@ namespace lve {
 
         auto result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
 
-        currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+        currentFrame = (currentFrame + 1) % framesInFlight;
 
         return result;
     }
@@ -135,10 +176,11 @@ namespace lve {
         SwapChainSupportDetails swapChainSupport = device.getSwapChainSupport();
 
         VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
-        VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+        presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
         VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
 
-        uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
+        // one image per frame in flight keeps frames from waiting on each other's images
+        uint32_t imageCount = std::max(swapChainSupport.capabilities.minImageCount + 1, framesInFlight);
         if (swapChainSupport.capabilities.maxImageCount > 0 &&
             imageCount > swapChainSupport.capabilities.maxImageCount) {
             imageCount = swapChainSupport.capabilities.maxImageCount;
@@ -154,6 +196,12 @@ namespace lve {
         createInfo.imageExtent = extent;
         createInfo.imageArrayLayers = 1;
         createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        // lets offscreen targets be blitted onto the images, supported by nearly every implementation
+        transferDstSupported =
+            (swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT) != 0;
+        if (transferDstSupported) {
+            createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        }
 
         QueueFamilyIndices indices = device.findPhysicalQueueFamilies();
         uint32_t queueFamilyIndices[] = { indices.graphicsFamily, indices.presentFamily };
@@ -215,67 +263,14 @@ namespace lve {
     }
 
     void LveSwapChain::createRenderPass() {
-        VkAttachmentDescription depthAttachment{};
-        depthAttachment.format = findDepthFormat();
-        depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-        depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-        depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-        depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-        depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-        VkAttachmentReference depthAttachmentRef{};
-        depthAttachmentRef.attachment = 1;
-        depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-        VkAttachmentDescription colorAttachment = {};
-        colorAttachment.format = getSwapChainImageFormat();
-        colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-        colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-        colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-        colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-        colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-        VkAttachmentReference colorAttachmentRef = {};
-        colorAttachmentRef.attachment = 0;
-        colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-        VkSubpassDescription subpass = {};
-        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-        subpass.colorAttachmentCount = 1;
-        subpass.pColorAttachments = &colorAttachmentRef;
-        subpass.pDepthStencilAttachment = &depthAttachmentRef;
-
-        VkSubpassDependency dependency = {};
-        dependency.dstSubpass = 0;
-        dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-        dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-        dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-        dependency.srcAccessMask = 0;
-        dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-
-        std::array<VkAttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
-        VkRenderPassCreateInfo renderPassInfo = {};
-        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-        renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-        renderPassInfo.pAttachments = attachments.data();
-        renderPassInfo.subpassCount = 1;
-        renderPassInfo.pSubpasses = &subpass;
-        renderPassInfo.dependencyCount = 1;
-        renderPassInfo.pDependencies = &dependency;
-
-        if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create render pass!");
-        }
+        renderPass = createColorDepthRenderPass(
+            device, getSwapChainImageFormat(), swapChainDepthFormat, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
     }
 
     void LveSwapChain::createFramebuffers() {
         swapChainFramebuffers.resize(imageCount());
         for (size_t i = 0; i < imageCount(); i++) {
-            std::array<VkImageView, 2> attachments = { swapChainImageViews[i], depthImageViews[i] };
+            std::array<VkImageView, 2> attachments = { swapChainImageViews[i], depthImageView };
 
             VkExtent2D swapChainExtent = getSwapChainExtent();
             VkFramebufferCreateInfo framebufferInfo = {};
@@ -297,59 +292,54 @@ namespace lve {
         }
     }
 
+    /**
+     * Creates the depth buffer shared by all swap chain images, see lve_attachments.cpp. The old swap chain's is
+     * taken over when its format and extent match.
+     */
     void LveSwapChain::createDepthResources() {
-        VkFormat depthFormat = findDepthFormat();
-        swapChainDepthFormat = depthFormat;
+        VkFormat depthFormat = swapChainDepthFormat;
         VkExtent2D swapChainExtent = getSwapChainExtent();
 
-        depthImages.resize(imageCount());
-        depthImageMemorys.resize(imageCount());
-        depthImageViews.resize(imageCount());
-
-        for (int i = 0; i < depthImages.size(); i++) {
-            VkImageCreateInfo imageInfo{};
-            imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-            imageInfo.imageType = VK_IMAGE_TYPE_2D;
-            imageInfo.extent.width = swapChainExtent.width;
-            imageInfo.extent.height = swapChainExtent.height;
-            imageInfo.extent.depth = 1;
-            imageInfo.mipLevels = 1;
-            imageInfo.arrayLayers = 1;
-            imageInfo.format = depthFormat;
-            imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-            imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-            imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
-            imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-            imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-            imageInfo.flags = 0;
-
-            device.createImageWithInfo(
-                imageInfo,
-                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                depthImages[i],
-                depthImageMemorys[i]);
+        if (oldSwapChain != nullptr &&
+            oldSwapChain->depthImage != VK_NULL_HANDLE &&
+            oldSwapChain->swapChainDepthFormat == depthFormat &&
+            oldSwapChain->swapChainExtent.width == swapChainExtent.width &&
+            oldSwapChain->swapChainExtent.height == swapChainExtent.height) {
+            depthImage = oldSwapChain->depthImage;
+            depthImageMemory = oldSwapChain->depthImageMemory;
+            depthImageView = oldSwapChain->depthImageView;
+            oldSwapChain->depthImage = VK_NULL_HANDLE;
+            oldSwapChain->depthImageMemory = VK_NULL_HANDLE;
+            oldSwapChain->depthImageView = VK_NULL_HANDLE;
+            return;
+        }
 
-            VkImageViewCreateInfo viewInfo{};
-            viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-            viewInfo.image = depthImages[i];
-            viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-            viewInfo.format = depthFormat;
-            viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-            viewInfo.subresourceRange.baseMipLevel = 0;
-            viewInfo.subresourceRange.levelCount = 1;
-            viewInfo.subresourceRange.baseArrayLayer = 0;
-            viewInfo.subresourceRange.layerCount = 1;
+        LveAttachmentImage depth = createTransientDepthImage(device, depthFormat, swapChainExtent);
+        depthImage = depth.image;
+        depthImageMemory = depth.memory;
+        depthImageView = depth.view;
+    }
 
-            if (vkCreateImageView(device.device(), &viewInfo, nullptr, &depthImageViews[i]) != VK_SUCCESS) {
-                throw std::runtime_error("failed to create texture image view!");
-            }
+    void LveSwapChain::adoptSyncObjects(LveSwapChain& previous) {
+        if (previous.framesInFlight != framesInFlight) {
+            throw std::runtime_error("swap chain recreated with a different number of frames in flight!");
         }
+
+        imageAvailableSemaphores = std::move(previous.imageAvailableSemaphores);
+        renderFinishedSemaphores = std::move(previous.renderFinishedSemaphores);
+        inFlightFences = std::move(previous.inFlightFences);
+        previous.imageAvailableSemaphores.clear();
+        previous.renderFinishedSemaphores.clear();
+        previous.inFlightFences.clear();
+        // the renderer's frame index keeps counting, so the fences must stay in step with it
+        currentFrame = previous.currentFrame;
+        imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
     }
 
     void LveSwapChain::createSyncObjects() {
-        imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-        renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-        inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+        imageAvailableSemaphores.resize(framesInFlight);
+        renderFinishedSemaphores.resize(framesInFlight);
+        inFlightFences.resize(framesInFlight);
         imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
 
         VkSemaphoreCreateInfo semaphoreInfo = {};
@@ -359,7 +349,7 @@ namespace lve {
         fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
         fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        for (size_t i = 0; i < framesInFlight; i++) {
             if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) !=
                 VK_SUCCESS ||
                 vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) !=
@@ -385,23 +375,33 @@ namespace lve {
     VkPresentModeKHR LveSwapChain::chooseSwapPresentMode(
         const std::vector<VkPresentModeKHR>& availablePresentModes) {
         for (const auto& availablePresentMode : availablePresentModes) {
-            if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
-                std::cout << "Present mode: Mailbox" << std::endl;
+            if (availablePresentMode == preferredPresentMode) {
+                std::cout << "Present mode: " << getPresentModeName(availablePresentMode) << std::endl;
                 return availablePresentMode;
             }
         }
 
-        //for (const auto &availablePresentMode : availablePresentModes) {
-        //  if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR) {
-        //    std::cout << "Present mode: Immediate" << std::endl;
-        //    return availablePresentMode;
-        //  }
-        //}
-
-        std::cout << "Present mode: V-Sync" << std::endl;
+        // FIFO is the only mode every surface supports
+        std::cout << "Present mode: " << getPresentModeName(preferredPresentMode) << " is not supported, using "
+            << getPresentModeName(VK_PRESENT_MODE_FIFO_KHR) << std::endl;
         return VK_PRESENT_MODE_FIFO_KHR;
     }
 
+    const char* LveSwapChain::getPresentModeName(VkPresentModeKHR presentMode) {
+        switch (presentMode) {
+        case VK_PRESENT_MODE_IMMEDIATE_KHR:
+            return "Immediate";
+        case VK_PRESENT_MODE_MAILBOX_KHR:
+            return "Mailbox";
+        case VK_PRESENT_MODE_FIFO_KHR:
+            return "V-Sync";
+        case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+            return "Relaxed V-Sync";
+        default:
+            return "Unknown";
+        }
+    }
+
     VkExtent2D LveSwapChain::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities) {
         if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
             return capabilities.currentExtent;
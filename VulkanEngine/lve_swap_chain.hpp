@@ -6,6 +6,7 @@
 #include <vulkan/vulkan.h>
 
 // std lib headers
+#include <chrono>
 #include <memory>
 #include <string>
 #include <vector>
@@ -14,10 +15,21 @@ namespace lve {
 
     class LveSwapChain {
     public:
-        static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
-
-        LveSwapChain(LveDevice& deviceRef, VkExtent2D windowExtent);
-        LveSwapChain(LveDevice& deviceRef, VkExtent2D windowExtent, std::shared_ptr<LveSwapChain> previous);
+        // frames in flight trade latency for throughput: one serializes CPU and GPU, more let the CPU run ahead
+        static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 4;
+        static constexpr uint32_t DEFAULT_FRAMES_IN_FLIGHT = 2;
+
+        LveSwapChain(
+            LveDevice& deviceRef,
+            VkExtent2D windowExtent,
+            uint32_t framesInFlight,
+            VkPresentModeKHR preferredPresentMode);
+        LveSwapChain(
+            LveDevice& deviceRef,
+            VkExtent2D windowExtent,
+            uint32_t framesInFlight,
+            VkPresentModeKHR preferredPresentMode,
+            std::shared_ptr<LveSwapChain> previous);
         ~LveSwapChain();
 
         LveSwapChain(const LveSwapChain&) = delete;
@@ -26,8 +38,12 @@ namespace lve {
         VkFramebuffer getFrameBuffer(int index) { return swapChainFramebuffers[index]; }
         VkRenderPass getRenderPass() { return renderPass; }
         VkImageView getImageView(int index) { return swapChainImageViews[index]; }
+        VkImage getImage(int index) { return swapChainImages[index]; }
         size_t imageCount() { return swapChainImages.size(); }
         VkFormat getSwapChainImageFormat() { return swapChainImageFormat; }
+        VkFormat getSwapChainDepthFormat() { return swapChainDepthFormat; }
+        // true if the images can be the destination of transfers and blits
+        bool supportsTransferDst() { return transferDstSupported; }
         VkExtent2D getSwapChainExtent() { return swapChainExtent; }
         uint32_t width() { return swapChainExtent.width; }
         uint32_t height() { return swapChainExtent.height; }
@@ -37,9 +53,19 @@ namespace lve {
         }
         VkFormat findDepthFormat();
 
+        uint32_t getFramesInFlight() const { return framesInFlight; }
+        // the preferred mode if the surface supports it, FIFO otherwise
+        VkPresentModeKHR getPresentMode() const { return presentMode; }
+        static const char* getPresentModeName(VkPresentModeKHR presentMode);
+
         VkResult acquireNextImage(uint32_t* imageIndex);
         VkResult submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex);
 
+        // seconds the CPU blocked on frame and image fences for the latest frame, from acquire to submit
+        float getFenceWaitTime() const { return fenceWaitTime; }
+        // when the latest frame's command buffers were handed to the queue
+        std::chrono::high_resolution_clock::time_point getLastSubmitTime() const { return lastSubmitTime; }
+
         bool compareSwapFormats(const LveSwapChain& swapChain) const {
             return swapChain.swapChainDepthFormat == swapChainDepthFormat &&
                 swapChain.swapChainImageFormat == swapChainImageFormat;
@@ -53,6 +79,7 @@ namespace lve {
         void createRenderPass();
         void createFramebuffers();
         void createSyncObjects();
+        void adoptSyncObjects(LveSwapChain& previous);
 
         // Helper functions
         VkSurfaceFormatKHR chooseSwapSurfaceFormat(
@@ -64,18 +91,23 @@ namespace lve {
         VkFormat swapChainImageFormat;
         VkFormat swapChainDepthFormat;
         VkExtent2D swapChainExtent;
+        bool transferDstSupported = false;
 
         std::vector<VkFramebuffer> swapChainFramebuffers;
         VkRenderPass renderPass;
 
-        std::vector<VkImage> depthImages;
-        std::vector<VkDeviceMemory> depthImageMemorys;
-        std::vector<VkImageView> depthImageViews;
+        // one depth buffer shared by every image and frame
+        VkImage depthImage = VK_NULL_HANDLE;
+        VkDeviceMemory depthImageMemory = VK_NULL_HANDLE;
+        VkImageView depthImageView = VK_NULL_HANDLE;
         std::vector<VkImage> swapChainImages;
         std::vector<VkImageView> swapChainImageViews;
 
         LveDevice& device;
         VkExtent2D windowExtent;
+        uint32_t framesInFlight;
+        VkPresentModeKHR preferredPresentMode;
+        VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
 
         VkSwapchainKHR swapChain;
         std::shared_ptr<LveSwapChain> oldSwapChain;
@@ -85,6 +117,8 @@ namespace lve {
         std::vector<VkFence> inFlightFences;
         std::vector<VkFence> imagesInFlight;
         size_t currentFrame = 0;
+        float fenceWaitTime = 0.f;
+        std::chrono::high_resolution_clock::time_point lastSubmitTime{};
     };
 
 }  // namespace lve
@@ -0,0 +1,160 @@
+/**
+ * @file lve_transform_buffer.cpp
+ * @brief Implementation of the LveTransformBuffer class, persistent object transforms with partial uploads.
+ *
+ * This file contains slot allocation, change detection against the CPU copy of the transforms and the per frame
+ * upload, which merges changed slots into ranges and flushes them rounded to the device's non coherent atom size.
+ */
+
+#include "lve_transform_buffer.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace lve {
+
+	namespace {
+		// changed slots closer than this are uploaded as one range, copying a few unchanged slots is cheaper
+		// than another flush
+		constexpr uint32_t MERGE_GAP_SLOTS = 4;
+	}
+
+	/**
+	 * @brief Creates and maps one transform buffer per frame in flight.
+	 *
+	 * @param device The device the buffers are created on.
+	 * @param frameCount Number of frames in flight, at most 8.
+	 * @param initialCapacity Slots each buffer holds before it has to grow.
+	 */
+	LveTransformBuffer::LveTransformBuffer(LveDevice& device, uint32_t frameCount, uint32_t initialCapacity)
+		: lveDevice{ device } {
+		assert(frameCount > 0 && frameCount <= 8 && "Frame dirty masks are 8 bits wide.");
+
+		transforms.reserve(initialCapacity);
+		dirtySlots.resize(frameCount);
+		for (uint32_t i = 0; i < frameCount; i++) {
+			frameBuffers.push_back(createFrameBuffer(std::max(initialCapacity, 1u)));
+		}
+	}
+
+	/**
+	 * @brief Returns a free slot, reusing released ones first.
+	 *
+	 * New slots are marked changed in every frame so their buffer contents are defined once written.
+	 */
+	uint32_t LveTransformBuffer::allocateSlot() {
+		if (!freeSlots.empty()) {
+			uint32_t slot = freeSlots.back();
+			freeSlots.pop_back();
+			return slot;
+		}
+
+		uint32_t slot = static_cast<uint32_t>(transforms.size());
+		transforms.push_back(AffineTransform::fromMat4(glm::mat4{ 1.f }));
+		dirtyFrameMasks.push_back(0);
+		for (uint32_t frame = 0; frame < dirtySlots.size(); frame++) {
+			dirtyFrameMasks[slot] |= 1u << frame;
+			dirtySlots[frame].push_back(slot);
+		}
+		return slot;
+	}
+
+	void LveTransformBuffer::releaseSlot(uint32_t slot) {
+		assert(slot < transforms.size() && "Releasing a slot that was never allocated.");
+		freeSlots.push_back(slot);
+	}
+
+	/**
+	 * @brief Writes a slot's transform, remembering it for upload only if it changed.
+	 *
+	 * @param slot A slot returned by allocateSlot().
+	 * @param modelMatrix The object's affine model matrix, its last row is ignored.
+	 * @return True if the transform changed.
+	 */
+	bool LveTransformBuffer::update(uint32_t slot, const glm::mat4& modelMatrix) {
+		AffineTransform transform = AffineTransform::fromMat4(modelMatrix);
+		if (std::memcmp(&transform, &transforms[slot], sizeof(AffineTransform)) == 0) {
+			return false;
+		}
+
+		transforms[slot] = transform;
+		for (uint32_t frame = 0; frame < dirtySlots.size(); frame++) {
+			if ((dirtyFrameMasks[slot] & (1u << frame)) == 0) {
+				dirtyFrameMasks[slot] |= 1u << frame;
+				dirtySlots[frame].push_back(slot);
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Brings a frame's buffer up to date with the CPU copy of the transforms.
+	 *
+	 * @param frameIndex The frame in flight whose buffer is written, no longer in use by the GPU.
+	 * @return True if the buffer was recreated, descriptors referencing it have to be rewritten.
+	 *
+	 * A buffer too small for all slots is recreated at twice its size and filled completely. Otherwise the changed
+	 * slots are sorted, merged into ranges and only those ranges are copied and flushed.
+	 */
+	bool LveTransformBuffer::upload(int frameIndex) {
+		auto& buffer = frameBuffers[frameIndex];
+		auto& dirty = dirtySlots[frameIndex];
+		const uint8_t frameBit = static_cast<uint8_t>(1u << frameIndex);
+		for (uint32_t slot : dirty) {
+			dirtyFrameMasks[slot] &= ~frameBit;
+		}
+
+		const uint32_t slotCount = getSlotCount();
+		if (slotCount > buffer->getInstanceCount()) {
+			buffer = createFrameBuffer(std::max(slotCount, buffer->getInstanceCount() * 2));
+			std::memcpy(buffer->getMappedMemory(), transforms.data(), slotCount * sizeof(AffineTransform));
+			buffer->flush();
+			uploadedBytes = slotCount * sizeof(AffineTransform);
+			dirty.clear();
+			return true;
+		}
+
+		uploadedBytes = 0;
+		if (dirty.empty()) {
+			return false;
+		}
+
+		std::sort(dirty.begin(), dirty.end());
+		const VkDeviceSize atomSize = std::max<VkDeviceSize>(lveDevice.properties.limits.nonCoherentAtomSize, 1);
+		const VkDeviceSize dataSize = slotCount * sizeof(AffineTransform);
+		auto* mapped = static_cast<char*>(buffer->getMappedMemory());
+		const auto* source = reinterpret_cast<const char*>(transforms.data());
+
+		size_t i = 0;
+		while (i < dirty.size()) {
+			uint32_t firstSlot = dirty[i];
+			uint32_t endSlot = firstSlot + 1;
+			for (i++; i < dirty.size() && dirty[i] <= endSlot + MERGE_GAP_SLOTS; i++) {
+				endSlot = dirty[i] + 1;
+			}
+
+			// flushed ranges must start and end on atom boundaries, copy the same widened range so it stays valid
+			VkDeviceSize offset = firstSlot * sizeof(AffineTransform) / atomSize * atomSize;
+			VkDeviceSize end = (endSlot * sizeof(AffineTransform) + atomSize - 1) / atomSize * atomSize;
+			VkDeviceSize copyEnd = std::min(end, dataSize);
+			std::memcpy(mapped + offset, source + offset, copyEnd - offset);
+			buffer->flush(end >= buffer->getBufferSize() ? VK_WHOLE_SIZE : end - offset, offset);
+			uploadedBytes += copyEnd - offset;
+		}
+		dirty.clear();
+		return false;
+	}
+
+	std::unique_ptr<LveBuffer> LveTransformBuffer::createFrameBuffer(uint32_t capacity) {
+		auto buffer = std::make_unique<LveBuffer>(
+			lveDevice,
+			sizeof(AffineTransform),
+			capacity,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+		buffer->map();
+		return buffer;
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "lve_buffer.hpp"
+#include "lve_device.hpp"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace lve {
+
+	// Affine model matrix without its constant last row, read as a mat3x4 in shaders (std430, 48 bytes).
+	// Positions are transformed with vec4(position, 1) * transform, normals use the cofactors of its 3x3 part.
+	struct AffineTransform {
+		glm::vec4 rows[3];
+
+		static AffineTransform fromMat4(const glm::mat4& matrix) {
+			AffineTransform transform;
+			for (int row = 0; row < 3; row++) {
+				transform.rows[row] = glm::vec4(matrix[0][row], matrix[1][row], matrix[2][row], matrix[3][row]);
+			}
+			return transform;
+		}
+	};
+
+	static_assert(sizeof(AffineTransform) == 48, "AffineTransform must match mat3x4 in std430");
+
+	/**
+	 * Persistent storage buffer of object transforms, addressed by slots that stay valid across frames.
+	 *
+	 * A CPU copy of every slot is kept so updates that do not change a transform are dropped. Each frame in flight
+	 * has its own persistently mapped buffer, and every changed slot is remembered per frame until that frame's
+	 * next upload, which copies and flushes only the changed ranges. Nothing is copied for static objects.
+	 */
+	class LveTransformBuffer {
+	public:
+		LveTransformBuffer(LveDevice& device, uint32_t frameCount, uint32_t initialCapacity = 1024);
+
+		LveTransformBuffer(const LveTransformBuffer&) = delete;
+		LveTransformBuffer& operator=(const LveTransformBuffer&) = delete;
+
+		uint32_t allocateSlot();
+		void releaseSlot(uint32_t slot);
+
+		// Returns true if the transform differs from the slot's current value
+		bool update(uint32_t slot, const glm::mat4& modelMatrix);
+
+		// Copies the slots changed since the frame's last upload, returns true if its buffer was recreated to grow
+		bool upload(int frameIndex);
+
+		LveBuffer& getBuffer(int frameIndex) { return *frameBuffers[frameIndex]; }
+		uint32_t getSlotCount() const { return static_cast<uint32_t>(transforms.size()); }
+		// bytes copied by the most recent upload
+		VkDeviceSize getUploadedBytes() const { return uploadedBytes; }
+
+	private:
+		std::unique_ptr<LveBuffer> createFrameBuffer(uint32_t capacity);
+
+		LveDevice& lveDevice;
+
+		std::vector<AffineTransform> transforms;
+		std::vector<uint32_t> freeSlots;
+
+		std::vector<std::unique_ptr<LveBuffer>> frameBuffers;
+		// bit f is set while slot is listed in dirtySlots[f]
+		std::vector<uint8_t> dirtyFrameMasks;
+		std::vector<std::vector<uint32_t>> dirtySlots;
+		VkDeviceSize uploadedBytes = 0;
+	};
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <functional>
+#include <mutex>
 
 namespace lve {
 
@@ -11,4 +12,11 @@ namespace lve {
 		(hashCombine(seed, rest), ...);
 	};
 
+	// Guards console output written from worker threads as well as the render loop. Hold it for a whole line or
+	// block, so lines written by different threads do not interleave.
+	inline std::mutex& getLogMutex() {
+		static std::mutex logMutex;
+		return logMutex;
+	}
+
 }
\ No newline at end of file
@@ -30,7 +30,7 @@ namespace lve {
 	 * @brief Initializes GLFW and creates a window.
 	 *
 	 * Sets GLFW window hints, creates a window with the specified width, height, and name, and sets up
-	 * the framebuffer size callback to handle window resizing.
+	 * the framebuffer size and refresh callbacks to handle window resizing.
 	 */
 	void LveWindow::initWindow() {
 		glfwInit();
@@ -40,6 +40,7 @@ namespace lve {
 		window = glfwCreateWindow(width, height, windowName.c_str(), nullptr, nullptr);
 		glfwSetWindowUserPointer(window, this);
 		glfwSetFramebufferSizeCallback(window, framebufferResizeCallback);
+		glfwSetWindowRefreshCallback(window, windowRefreshCallback);
 	}
 
 	/**
@@ -75,4 +76,19 @@ namespace lve {
 		lveWindow->height = height;
 	}
 
+	/**
+	 * @brief GLFW callback for window contents that need redrawing.
+	 *
+	 * @param window The GLFW window that triggered the callback.
+	 *
+	 * While a window border is dragged, some platforms only return from event polling once the drag ends and
+	 * report the intermediate sizes through callbacks. Drawing from here keeps the contents live during the drag.
+	 */
+	void LveWindow::windowRefreshCallback(GLFWwindow* window) {
+		auto lveWindow = reinterpret_cast<LveWindow*>(glfwGetWindowUserPointer(window));
+		if (lveWindow->refreshCallback) {
+			lveWindow->refreshCallback();
+		}
+	}
+
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
+#include <functional>
 #include <string>
 
 namespace lve {
@@ -24,14 +25,20 @@ namespace lve {
 
 		void createWindowSurface(VkInstance instance, VkSurfaceKHR *surface);
 
+		// Called when the window contents need redrawing, including from inside event polling while the user
+		// drags the window border on platforms that block there. Must not poll events itself.
+		void setRefreshCallback(std::function<void()> callback) { refreshCallback = std::move(callback); }
+
 	private:
 		static void framebufferResizeCallback(GLFWwindow* window, int width, int height);
+		static void windowRefreshCallback(GLFWwindow* window);
 
 		void initWindow();
 
 		int width;
 		int height;
 		bool framebufferResized = false;
+		std::function<void()> refreshCallback;
 
 		std::string windowName;
 		GLFWwindow* window;
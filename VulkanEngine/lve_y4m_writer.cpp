@@ -0,0 +1,245 @@
+/**
+ * @file lve_y4m_writer.cpp
+ * @brief Implementation of the LveY4mWriter class, which streams frames as raw YUV4MPEG2 video.
+ *
+ * This file contains the RGBA to 4:2:0 YUV conversion, which processes eight luma and four chroma samples at a
+ * time with SSE2 when the target supports it, and the in order writing of frames to a file, pipe or stdout.
+ */
+
+#include "lve_y4m_writer.hpp"
+
+// std
+#include <algorithm>
+#include <csignal>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LVE_Y4M_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace lve {
+
+	namespace {
+		// BT.601 limited range in 8 bit fixed point. Luma adds 16 and rounds, chroma is computed from the sum of
+		// a 2x2 block, so it is scaled by 4 more, and adds 128 and rounds. Both biases keep every intermediate
+		// non negative, so the shifts behave the same in the scalar and the SSE2 code.
+		constexpr int Y_BIAS = (16 << 8) + 128;
+		constexpr int C_BIAS = (128 << 10) + 512;
+
+		inline uint8_t lumaOf(const uint8_t* pixel) {
+			return static_cast<uint8_t>((66 * pixel[0] + 129 * pixel[1] + 25 * pixel[2] + Y_BIAS) >> 8);
+		}
+
+		inline void chromaOf(
+			const uint8_t* p00, const uint8_t* p01, const uint8_t* p10, const uint8_t* p11, uint8_t& u, uint8_t& v) {
+			const int r = p00[0] + p01[0] + p10[0] + p11[0];
+			const int g = p00[1] + p01[1] + p10[1] + p11[1];
+			const int b = p00[2] + p01[2] + p10[2] + p11[2];
+			u = static_cast<uint8_t>((-38 * r - 74 * g + 112 * b + C_BIAS) >> 10);
+			v = static_cast<uint8_t>((112 * r - 94 * g - 18 * b + C_BIAS) >> 10);
+		}
+
+#ifdef LVE_Y4M_SSE2
+		// Sums the two 32 bit halves of each 64 bit lane and packs the two sums into the low 64 bits
+		inline __m128i sumPairs(__m128i products) {
+			products = _mm_add_epi32(products, _mm_srli_epi64(products, 32));
+			return _mm_shuffle_epi32(products, _MM_SHUFFLE(3, 3, 2, 0));
+		}
+
+		// Luma of four RGBA pixels as 32 bit lanes
+		inline __m128i luma4(__m128i pixels, __m128i coefficients) {
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i low = sumPairs(_mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero), coefficients));
+			const __m128i high = sumPairs(_mm_madd_epi16(_mm_unpackhi_epi8(pixels, zero), coefficients));
+			return _mm_srli_epi32(_mm_add_epi32(_mm_unpacklo_epi64(low, high), _mm_set1_epi32(Y_BIAS)), 8);
+		}
+
+		// Channel sums of the two 2x2 blocks covered by four pixels of two rows, as 16 bit RGBA per block
+		inline __m128i blockSums(__m128i top, __m128i bottom) {
+			const __m128i zero = _mm_setzero_si128();
+			__m128i left = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+			__m128i right = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+			left = _mm_add_epi16(left, _mm_srli_si128(left, 8));
+			right = _mm_add_epi16(right, _mm_srli_si128(right, 8));
+			return _mm_unpacklo_epi64(left, right);
+		}
+
+		// One chroma channel of four blocks, stored as bytes
+		inline void storeChroma4(__m128i blocks01, __m128i blocks23, __m128i coefficients, uint8_t* target) {
+			const __m128i low = sumPairs(_mm_madd_epi16(blocks01, coefficients));
+			const __m128i high = sumPairs(_mm_madd_epi16(blocks23, coefficients));
+			__m128i chroma = _mm_srli_epi32(
+				_mm_add_epi32(_mm_unpacklo_epi64(low, high), _mm_set1_epi32(C_BIAS)), 10);
+			chroma = _mm_packs_epi32(chroma, chroma);
+			const int bytes = _mm_cvtsi128_si32(_mm_packus_epi16(chroma, chroma));
+			std::memcpy(target, &bytes, 4);
+		}
+#endif
+	}
+
+	/**
+	 * @brief Converts RGBA pixels to I420, planar YUV with quarter resolution chroma.
+	 *
+	 * Chroma is computed from the average color of each 2x2 block, which places it at the block center as the
+	 * `C420jpeg` Y4M layout expects. Alpha is ignored.
+	 */
+	void convertRgbaToI420(
+		const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* yPlane, uint8_t* uPlane, uint8_t* vPlane) {
+		const size_t stride = static_cast<size_t>(width) * 4;
+
+		for (uint32_t y = 0; y < height; y++) {
+			const uint8_t* row = rgba + y * stride;
+			uint8_t* yRow = yPlane + static_cast<size_t>(y) * width;
+			uint32_t x = 0;
+#ifdef LVE_Y4M_SSE2
+			const __m128i coefficients = _mm_setr_epi16(66, 129, 25, 0, 66, 129, 25, 0);
+			for (; x + 8 <= width; x += 8) {
+				const __m128i first = luma4(
+					_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x * 4)), coefficients);
+				const __m128i second = luma4(
+					_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x * 4 + 16)), coefficients);
+				const __m128i words = _mm_packs_epi32(first, second);
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(yRow + x), _mm_packus_epi16(words, words));
+			}
+#endif
+			for (; x < width; x++) {
+				yRow[x] = lumaOf(row + x * 4);
+			}
+		}
+
+		const uint32_t chromaWidth = (width + 1) / 2;
+		const uint32_t chromaHeight = (height + 1) / 2;
+		for (uint32_t cy = 0; cy < chromaHeight; cy++) {
+			const uint8_t* top = rgba + (cy * 2) * stride;
+			const uint8_t* bottom = rgba + std::min(cy * 2 + 1, height - 1) * stride;
+			uint8_t* uRow = uPlane + static_cast<size_t>(cy) * chromaWidth;
+			uint8_t* vRow = vPlane + static_cast<size_t>(cy) * chromaWidth;
+			uint32_t cx = 0;
+#ifdef LVE_Y4M_SSE2
+			const __m128i uCoefficients = _mm_setr_epi16(-38, -74, 112, 0, -38, -74, 112, 0);
+			const __m128i vCoefficients = _mm_setr_epi16(112, -94, -18, 0, 112, -94, -18, 0);
+			for (; cx * 2 + 8 <= width; cx += 4) {
+				const size_t offset = static_cast<size_t>(cx) * 8;
+				const __m128i blocks01 = blockSums(
+					_mm_loadu_si128(reinterpret_cast<const __m128i*>(top + offset)),
+					_mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom + offset)));
+				const __m128i blocks23 = blockSums(
+					_mm_loadu_si128(reinterpret_cast<const __m128i*>(top + offset + 16)),
+					_mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom + offset + 16)));
+				storeChroma4(blocks01, blocks23, uCoefficients, uRow + cx);
+				storeChroma4(blocks01, blocks23, vCoefficients, vRow + cx);
+			}
+#endif
+			for (; cx < chromaWidth; cx++) {
+				const size_t left = static_cast<size_t>(cx) * 8;
+				const size_t right = static_cast<size_t>(std::min(cx * 2 + 1, width - 1)) * 4;
+				chromaOf(top + left, top + right, bottom + left, bottom + right, uRow[cx], vRow[cx]);
+			}
+		}
+	}
+
+	/**
+	 * @brief Opens the output and writes the stream header.
+	 *
+	 * @param output "-" for stdout, "fd:<n>" for a file descriptor inherited from the parent process, or a path.
+	 *        Paths may name a pipe created with mkfifo, opening one blocks until a reader has opened it.
+	 * @param width Frame width in pixels.
+	 * @param height Frame height in pixels.
+	 * @param frameRate Frames per second recorded in the header, the rate the simulation advances at.
+	 * @throws std::runtime_error If the output cannot be opened or the header cannot be written.
+	 */
+	LveY4mWriter::LveY4mWriter(const std::string& output, uint32_t width, uint32_t height, uint32_t frameRate)
+		: outputName{ output }, width{ width }, height{ height } {
+		if (output == "-") {
+#ifdef _WIN32
+			_setmode(_fileno(stdout), _O_BINARY);
+#endif
+			stream = stdout;
+		} else if (output.rfind("fd:", 0) == 0) {
+#ifdef _WIN32
+			stream = _fdopen(std::stoi(output.substr(3)), "wb");
+#else
+			stream = fdopen(std::stoi(output.substr(3)), "wb");
+#endif
+			ownsStream = true;
+		} else {
+			stream = std::fopen(output.c_str(), "wb");
+			ownsStream = true;
+		}
+		if (stream == nullptr) {
+			throw std::runtime_error("failed to open video output: " + output);
+		}
+#ifndef _WIN32
+		// a reader that exits makes writes fail instead of terminating the process
+		std::signal(SIGPIPE, SIG_IGN);
+#endif
+
+		const std::string header = "YUV4MPEG2 W" + std::to_string(width) + " H" + std::to_string(height) + " F"
+			+ std::to_string(frameRate) + ":1 Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n";
+		if (std::fwrite(header.data(), 1, header.size(), stream) != header.size() || std::fflush(stream) != 0) {
+			throw std::runtime_error("failed to write video output: " + output);
+		}
+	}
+
+	LveY4mWriter::~LveY4mWriter() {
+		if (ownsStream) {
+			std::fclose(stream);
+		} else {
+			std::fflush(stream);
+		}
+	}
+
+	/**
+	 * @brief Converts a frame and writes it once every earlier frame has been written.
+	 *
+	 * @param sequence The frame's position in the stream. Every number from 0 on must be written exactly once.
+	 * @param rgba Tightly packed 8 bit RGBA pixels of the writer's size.
+	 * @throws std::runtime_error If writing this or an earlier frame failed, for example because the reader exited.
+	 *
+	 * The conversion runs before the lock is taken, so frames converted on different threads overlap. Every frame
+	 * is flushed, so the reader receives it at once rather than when a buffer fills.
+	 */
+	void LveY4mWriter::writeFrame(uint64_t sequence, const uint8_t* rgba) {
+		const size_t lumaSize = static_cast<size_t>(width) * height;
+		const size_t chromaSize = static_cast<size_t>((width + 1) / 2) * ((height + 1) / 2);
+		thread_local std::vector<uint8_t> planes;
+		planes.resize(lumaSize + 2 * chromaSize);
+		convertRgbaToI420(
+			rgba, width, height, planes.data(), planes.data() + lumaSize, planes.data() + lumaSize + chromaSize);
+
+		std::unique_lock<std::mutex> lock{ writeMutex };
+		if (sequence < nextSequence) {
+			throw std::runtime_error("video frame " + std::to_string(sequence) + " was already written");
+		}
+		writeCondition.wait(lock, [&]() { return failed || nextSequence == sequence; });
+		if (failed) {
+			throw std::runtime_error("failed to write video output: " + outputName);
+		}
+
+		static const char frameHeader[] = "FRAME\n";
+		const bool written = std::fwrite(frameHeader, 1, sizeof(frameHeader) - 1, stream) == sizeof(frameHeader) - 1
+			&& std::fwrite(planes.data(), 1, planes.size(), stream) == planes.size()
+			&& std::fflush(stream) == 0;
+		if (written) {
+			nextSequence++;
+		} else {
+			failed = true;
+		}
+		writeCondition.notify_all();
+		if (!written) {
+			throw std::runtime_error("failed to write video output: " + outputName);
+		}
+	}
+
+	uint64_t LveY4mWriter::getWrittenCount() const {
+		std::lock_guard<std::mutex> lock{ writeMutex };
+		return nextSequence;
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+// std
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+	// Converts tightly packed 8 bit RGBA pixels to planar 4:2:0 YUV with BT.601 limited range coefficients. yPlane
+	// holds width x height samples, uPlane and vPlane (width + 1) / 2 x (height + 1) / 2 each, odd edges repeat
+	// the last row or column. Uses SSE2 when the target supports it, bit identical to the scalar fallback.
+	void convertRgbaToI420(
+		const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* yPlane, uint8_t* uPlane, uint8_t* vPlane);
+
+	/**
+	 * Streams frames as uncompressed YUV4MPEG2 video, the raw format external encoders like ffmpeg read from a pipe.
+	 *
+	 * writeFrame() may be called from several threads at once: the color conversion runs in parallel, and the
+	 * frames are then written strictly in sequence order, each thread waiting for its predecessors. Writes block
+	 * while the reader is behind, so a slow consumer holds up the callers instead of frames being lost.
+	 */
+	class LveY4mWriter {
+	public:
+		// output is "-" for stdout, "fd:<n>" for an open file descriptor, or the path of a file or named pipe
+		LveY4mWriter(const std::string& output, uint32_t width, uint32_t height, uint32_t frameRate);
+		~LveY4mWriter();
+
+		LveY4mWriter(const LveY4mWriter&) = delete;
+		LveY4mWriter& operator=(const LveY4mWriter&) = delete;
+
+		// Converts and writes the frame with the given sequence number, counted from 0. Blocks until every earlier
+		// frame has been written and the output accepted this one, throws when writing fails.
+		void writeFrame(uint64_t sequence, const uint8_t* rgba);
+
+		uint64_t getWrittenCount() const;
+
+	private:
+		std::FILE* stream = nullptr;
+		bool ownsStream = false;
+		std::string outputName;
+		uint32_t width;
+		uint32_t height;
+
+		mutable std::mutex writeMutex;
+		std::condition_variable writeCondition;
+		uint64_t nextSequence = 0;
+		bool failed = false;
+	};
+}
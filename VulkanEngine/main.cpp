@@ -1,9 +1,14 @@
 #include "first_app.hpp"
+#include "headless_app.hpp"
+#include "lve_image_writer.hpp"
+#include "lve_scene_file.hpp"
 
 // std
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 /**
  * @brief Entry point for the application.
@@ -13,6 +18,23 @@
  * error stream, and returns a failure exit code. If the application completes successfully, it returns a success
  * exit code.
  *
+ * Passing `--convert-scene <text> <binary>` converts a text scene description to the binary scene format
+ * instead of starting the application. `--gpu-driven` starts with GPU culling and indirect draws enabled.
+ * `--frames-in-flight <1-4>` sets how many frames the CPU may record ahead of the GPU, 2 by default.
+ * `--present-mode <fifo|mailbox|immediate>` picks the present mode, `--frame-limit <fps>` caps the frame rate and
+ * `--jit-input` samples input after the frame's fence wait to shorten input latency. `--headless <frames>` renders
+ * that many frames offscreen on a device without a surface instead of opening a window.
+ *
+ * `--batch <scene> <camera poses> <output directory>` renders the scene headless once per camera pose and writes
+ * the images to the output directory. `--size <width> <height>` sets the size of headless images,
+ * `--image-format <png|ppm|exr>` their format, png by default, and `--readback-slots <count>` the number of
+ * staging buffers images wait in for encoding, 8 by default.
+ *
+ * `--video <scene> <camera poses> <output>` renders the same way but streams every frame as raw Y4M video to the
+ * output: `-` for stdout, `fd:<n>` for an inherited file descriptor, or the path of a file or named pipe, for
+ * example `RayTracing --video scene poses - | ffmpeg -i - out.mp4`. `--frame-rate <fps>` sets the fixed time step
+ * the scene advances by per frame, 60 by default. While streaming to stdout all messages go to stderr.
+ *
  * The main function performs the following steps:
  * 1. Creates an instance of `lve::FirstApp`.
  * 2. Calls the `run` method on the `FirstApp` instance.
@@ -24,10 +46,118 @@
  *         - `EXIT_FAILURE` (1) if an exception is thrown and caught.
  */
 
-int main() {
-	lve::FirstApp app{};
+int main(int argc, char* argv[]) {
+	if (argc > 1 && std::string{ argv[1] } == "--convert-scene") {
+		if (argc != 4) {
+			std::cerr << "usage: " << argv[0] << " --convert-scene <text scene> <binary scene>" << std::endl;
+			return EXIT_FAILURE;
+		}
+		try {
+			lve::LveSceneFile::convertTextToBinary(argv[2], argv[3]);
+		} catch (const std::exception& e) {
+			std::cerr << e.what() << std::endl;
+			return EXIT_FAILURE;
+		}
+		return EXIT_SUCCESS;
+	}
+
+	bool gpuDriven = false;
+	bool justInTimeInput = false;
+	bool headless = false;
+	uint32_t headlessFrameCount = 0;
+	std::string batchScene;
+	std::string batchPoses;
+	std::string batchOutput;
+	std::string videoOutput;
+	uint32_t frameRate = lve::HeadlessApp::DEFAULT_FRAME_RATE;
+	VkExtent2D headlessExtent{ lve::HeadlessApp::WIDTH, lve::HeadlessApp::HEIGHT };
+	std::string imageFormat = "png";
+	uint32_t readbackSlots = lve::HeadlessApp::DEFAULT_READBACK_SLOTS;
+	uint32_t framesInFlight = lve::LveSwapChain::DEFAULT_FRAMES_IN_FLIGHT;
+	float frameRateLimit = 0.f;
+	std::string presentMode;
+	for (int i = 1; i < argc; i++) {
+		std::string arg{ argv[i] };
+		if (arg == "--gpu-driven") {
+			gpuDriven = true;
+		} else if (arg == "--frames-in-flight" && i + 1 < argc) {
+			framesInFlight = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		} else if (arg == "--present-mode" && i + 1 < argc) {
+			presentMode = argv[++i];
+		} else if (arg == "--frame-limit" && i + 1 < argc) {
+			frameRateLimit = std::strtof(argv[++i], nullptr);
+		} else if (arg == "--jit-input") {
+			justInTimeInput = true;
+		} else if (arg == "--headless" && i + 1 < argc) {
+			headless = true;
+			headlessFrameCount = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		} else if (arg == "--batch" && i + 3 < argc) {
+			headless = true;
+			batchScene = argv[++i];
+			batchPoses = argv[++i];
+			batchOutput = argv[++i];
+		} else if (arg == "--video" && i + 3 < argc) {
+			headless = true;
+			batchScene = argv[++i];
+			batchPoses = argv[++i];
+			videoOutput = argv[++i];
+		} else if (arg == "--frame-rate" && i + 1 < argc) {
+			frameRate = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		} else if (arg == "--size" && i + 2 < argc) {
+			headlessExtent.width = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+			headlessExtent.height = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		} else if (arg == "--image-format" && i + 1 < argc) {
+			imageFormat = argv[++i];
+		} else if (arg == "--readback-slots" && i + 1 < argc) {
+			readbackSlots = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+	}
+
+	if (headless) {
+		// stdout carries the video, the statistics still go through std::cout
+		if (videoOutput == "-") {
+			std::cout.rdbuf(std::cerr.rdbuf());
+		}
+		try {
+			if (frameRate == 0) {
+				throw std::runtime_error("Frame rate must be at least 1");
+			}
+			if (!lve::isImageExtensionSupported("." + imageFormat)) {
+				throw std::runtime_error("Unknown image format " + imageFormat + ", expected png, ppm or exr");
+			}
+			// without a pose file the start pose of the interactive application is rendered repeatedly
+			std::vector<lve::CameraPose> poses = batchPoses.empty()
+				? std::vector<lve::CameraPose>(headlessFrameCount)
+				: lve::loadCameraPoses(batchPoses);
+			lve::HeadlessApp app{
+				batchScene.empty() ? lve::FirstApp::SCENE_TEXT_PATH : batchScene, headlessExtent, framesInFlight };
+			app.setGpuDrivenRendering(gpuDriven);
+			app.setImageExtension("." + imageFormat);
+			app.setReadbackSlots(readbackSlots);
+			app.setVideoOutput(videoOutput);
+			app.setFrameRate(frameRate);
+			app.render(poses, batchOutput);
+		} catch (const std::exception& e) {
+			std::cerr << e.what() << std::endl;
+			return EXIT_FAILURE;
+		}
+		return EXIT_SUCCESS;
+	}
 
 	try {
+		lve::FirstApp app{ framesInFlight };
+		app.setGpuDrivenRendering(gpuDriven);
+		app.setFrameRateLimit(frameRateLimit);
+		app.setJustInTimeInput(justInTimeInput);
+		if (presentMode == "fifo") {
+			app.setPresentMode(VK_PRESENT_MODE_FIFO_KHR);
+		} else if (presentMode == "mailbox") {
+			app.setPresentMode(VK_PRESENT_MODE_MAILBOX_KHR);
+		} else if (presentMode == "immediate") {
+			app.setPresentMode(VK_PRESENT_MODE_IMMEDIATE_KHR);
+		} else if (!presentMode.empty()) {
+			throw std::runtime_error("Unknown present mode " + presentMode + ", expected fifo, mailbox or immediate");
+		}
 		app.run();
 	} catch (const std::exception& e) {
 		std::cerr << e.what() << std::endl;
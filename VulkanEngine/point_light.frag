@@ -1,32 +1,26 @@
 #version 450
 
 layout (location = 0) in vec2 fragOffset;
+layout (location = 1) flat in vec4 fragColor;
 layout (location = 0) out vec4 outColor;
 
-struct PointLight {
-	vec4 position; // ignore w
-	vec4 color; // w is intensity
-};
-
 layout(set = 0, binding = 0) uniform GlobalUbo {
 	mat4 projection;
 	mat4 view;
 	mat4 invView;
 	vec4 ambientLightColor; // w is intensity
-	PointLight pointLights[10];
-	int numLights;
+	uvec4 clusterCounts; // w is the number of lights
+	vec4 clusterDepth; // x is the first slice's near depth, y the slices per unit of log depth
 } ubo;
 
-layout(push_constant) uniform Push {
-	vec4 position;
-	vec4 color;
-	float radius;
-} push;
+const float M_PI = 3.1415926538;
 
 void main() {
 	float dis = sqrt(dot(fragOffset, fragOffset));
 	if(dis >= 1.0) {
 		discard;
 	}
-	outColor = vec4(push.color.xyz, 1.0);
+	// soft edge, fully opaque in the center and fading out towards the rim
+	float alpha = 0.5 * (cos(dis * M_PI) + 1.0);
+	outColor = vec4(fragColor.xyz, alpha);
 }
@@ -11,35 +11,38 @@ const vec2 OFFSETS[6] = vec2[](
 );
 
 layout(location = 0) out vec2 fragOffset;
-
-struct PointLight {
-	vec4 position; // ignore w
-	vec4 color; // w is intensity
-};
+layout(location = 1) flat out vec4 fragColor;
 
 layout(set = 0, binding = 0) uniform GlobalUbo {
 	mat4 projection;
 	mat4 view;
 	mat4 invView;
 	vec4 ambientLightColor; // w is intensity
-	PointLight pointLights[10];
-	int numLights;
+	uvec4 clusterCounts; // w is the number of lights
+	vec4 clusterDepth; // x is the first slice's near depth, y the slices per unit of log depth
 } ubo;
 
-layout(push_constant) uniform Push {
-	vec4 position;
-	vec4 color;
-	float radius;
-} push;
+struct PointLightInstance {
+	vec4 position; // w is the billboard radius
+	vec4 color; // w is intensity
+};
+
+// sorted back to front, one entry per instance of the draw
+layout(set = 1, binding = 0) readonly buffer InstanceBuffer {
+	PointLightInstance instances[];
+};
 
 void main() {
+	PointLightInstance light = instances[gl_InstanceIndex];
 	fragOffset = OFFSETS[gl_VertexIndex];
+	fragColor = light.color;
 	vec3 cameraRightWorld = {ubo.view[0][0], ubo.view[1][0], ubo.view[2][0]};
 	vec3 cameraUpWorld = {ubo.view[0][1], ubo.view[1][1], ubo.view[2][1]};
 
-	vec3 positionWorld = push.position.xyz
-		+ push.radius * fragOffset.x * cameraRightWorld
-		+ push.radius * fragOffset.y * cameraUpWorld;
+	float radius = light.position.w;
+	vec3 positionWorld = light.position.xyz
+		+ radius * fragOffset.x * cameraRightWorld
+		+ radius * fragOffset.y * cameraUpWorld;
 
 	gl_Position = ubo.projection * ubo.view * vec4(positionWorld, 1.0);
 }
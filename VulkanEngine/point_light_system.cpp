@@ -1,5 +1,8 @@
 #include "point_light_system.hpp"
 
+#include "lve_gpu_profiler.hpp"
+#include "lve_swap_chain.hpp"
+
 // libs
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -7,6 +10,7 @@
 #include <glm/gtc/constants.hpp>
 
 // std
+#include <algorithm>
 #include <stdexcept>
 #include <array>
 #include <cassert>
@@ -19,17 +23,17 @@ namespace lve {
 	 * The `PointLightSystem` class is responsible for setting up the Vulkan pipeline and rendering point lights in a scene.
 	 * It handles the creation of pipeline layouts, pipelines, and updates the point light properties for each frame.
 	 *
-	 * The system uses Vulkan's push constants to pass point light data to the shaders and updates the uniform buffer object
-	 * (UBO) with the latest point light information every frame. It also binds the appropriate descriptor sets and issues
-	 * draw commands for each point light.
+	 * The lights are animated every frame and drawn as camera facing billboards with a single instanced draw. Their
+	 * positions, colors and radii are written back to front to a per frame storage buffer the vertex shader indexes
+	 * with `gl_InstanceIndex`, so the soft alpha blended edges composite in the right order.
 	 *
 	 * The class provides the following functionalities:
 	 * - **Constructor & Destructor**: Initializes the system by creating necessary Vulkan resources and cleans up
 	 *   resources when destroyed.
 	 * - **Pipeline Creation**: Sets up the Vulkan pipeline layout and pipeline specifically for rendering point lights.
-	 * - **Light Update**: Updates the point light positions and properties based on frame information and applies transformations.
-	 * - **Rendering**: Binds the pipeline and descriptor sets, pushes light constants to the shaders, and issues draw commands
-	 *   to render point lights.
+	 * - **Light Update**: Updates the point light positions based on frame information and applies transformations.
+	 * - **Rendering**: Sorts the lights by view depth, uploads their instance data, binds the pipeline and descriptor sets
+	 *   and issues one draw for all point lights.
 	 *
 	 * @see LveDevice
 	 * @see LvePipeline
@@ -38,23 +42,28 @@ namespace lve {
 	 * @see VkPipelineLayout
 	 * @see VkDescriptorSetLayout
 	 */
-	struct PointLightPushConstants {
-		glm::vec4 position{};
-		glm::vec4 color{};
-		float radius;
-	};
-
 	/**
 		 * @brief Constructs a `PointLightSystem` instance.
 		 *
 		 * @param device A reference to the `LveDevice` used to create Vulkan resources.
+		 * @param jobSystem The job system large light queues are sorted on.
+		 * @param pipelineCompiler Compiles the billboard pipeline in the background, lights are not drawn until it
+		 *        is ready.
 		 * @param renderPass A Vulkan `VkRenderPass` used for rendering.
 		 * @param globalSetLayout A Vulkan `VkDescriptorSetLayout` for global descriptor sets.
+		 * @param framesInFlight Number of frames the renderer keeps in flight, each gets its own instance buffer.
 		 */
-	PointLightSystem::PointLightSystem(LveDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout)
-		: lveDevice{ device } {
+	PointLightSystem::PointLightSystem(
+		LveDevice& device,
+		LveJobSystem& jobSystem,
+		LvePipelineCompiler& pipelineCompiler,
+		VkRenderPass renderPass,
+		VkDescriptorSetLayout globalSetLayout,
+		uint32_t framesInFlight)
+		: lveDevice{ device }, renderQueue{ jobSystem } {
+		createInstanceResources(framesInFlight);
 		createPipelineLayout(globalSetLayout);
-		createPipeline(renderPass);
+		createPipeline(pipelineCompiler, renderPass);
 	}
 
 	/**
@@ -63,6 +72,8 @@ namespace lve {
 		 * Cleans up Vulkan resources associated with the pipeline layout.
 		 */
 	PointLightSystem::~PointLightSystem() {
+		// a pending compilation still uses the layout
+		lvePipeline.wait();
 		vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
 	}
 
@@ -71,23 +82,19 @@ namespace lve {
 		 *
 		 * @param globalSetLayout A Vulkan `VkDescriptorSetLayout` used in the pipeline layout.
 		 *
-		 * Configures the pipeline layout with push constants for point light properties and descriptor set layouts.
+		 * Configures the pipeline layout with the global set and the light instance set.
 		 * Throws an exception if pipeline layout creation fails.
 		 */
 	void PointLightSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout) {
-		VkPushConstantRange pushConstantRange{};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-		pushConstantRange.offset = 0;
-		pushConstantRange.size = sizeof(PointLightPushConstants);
-
-		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{ globalSetLayout };
+		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{
+			globalSetLayout, instanceSetLayout->getDescriptorSetLayout() };
 
 		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
 		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
 		pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-		pipelineLayoutInfo.pushConstantRangeCount = 1;
-		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		pipelineLayoutInfo.pushConstantRangeCount = 0;
+		pipelineLayoutInfo.pPushConstantRanges = nullptr;
 		if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) !=
 			VK_SUCCESS) {
 			throw std::runtime_error("Failed to create pipeline layout!");
@@ -95,55 +102,120 @@ namespace lve {
 	}
 
 	/**
-		 * @brief Creates the Vulkan pipeline for rendering point lights.
+		 * @brief Queues the Vulkan pipeline for rendering point lights.
 		 *
+		 * @param pipelineCompiler The compiler the pipeline is created on.
 		 * @param renderPass A Vulkan `VkRenderPass` used for rendering.
 		 *
-		 * Sets up the Vulkan graphics pipeline, including shaders and pipeline configuration.
-		 * Throws an exception if pipeline creation fails.
+		 * Sets up the Vulkan graphics pipeline configuration and compiles it on the job system.
+		 * A compilation error is rethrown by the first frame that finds the failed pipeline.
 		 */
-	void PointLightSystem::createPipeline(VkRenderPass renderPass) {
+	void PointLightSystem::createPipeline(LvePipelineCompiler& pipelineCompiler, VkRenderPass renderPass) {
 		assert(pipelineLayout != nullptr && "Cannot create pipeline before pipline layout.");
 
-		PipelineConfigInfo pipelineConfig{};
-		LvePipeline::defaultPipelineConfigInfo(pipelineConfig);
-		pipelineConfig.renderPass = renderPass;
-		pipelineConfig.pipelineLayout = pipelineLayout;
-		lvePipeline = std::make_unique<LvePipeline>(
-			lveDevice,
+		VkPipelineLayout layout = pipelineLayout;
+		lvePipeline = pipelineCompiler.compileGraphics(
 			"point_light.vert.spv",
 			"point_light.frag.spv",
-			pipelineConfig);
+			[renderPass, layout](PipelineConfigInfo& pipelineConfig) {
+				// billboard corners are generated in the vertex shader, no vertex input
+				pipelineConfig.attributeDescriptions.clear();
+				pipelineConfig.bindingDescriptions.clear();
+				// blended back to front, so the billboards test against the scene but do not occlude each other
+				LvePipeline::enableAlphaBlending(pipelineConfig);
+				pipelineConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
+				pipelineConfig.renderPass = renderPass;
+				pipelineConfig.pipelineLayout = layout;
+			});
+	}
+
+	/**
+		 * @brief Creates the per frame light instance buffers and their descriptor sets.
+		 *
+		 * Each frame in flight owns its own buffer so the CPU can fill one while the GPU still reads another.
+		 */
+	void PointLightSystem::createInstanceResources(uint32_t framesInFlight) {
+		instanceSetLayout =
+			LveDescriptorSetLayout::Builder(lveDevice)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+			.build();
+		instancePool =
+			LveDescriptorPool::Builder(lveDevice)
+			.setMaxSets(framesInFlight)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, framesInFlight)
+			.build();
+
+		instanceBuffers.resize(framesInFlight);
+		instanceDescriptorSets.resize(framesInFlight);
+		for (int i = 0; i < instanceBuffers.size(); i++) {
+			instanceBuffers[i] = std::make_unique<LveBuffer>(
+				lveDevice,
+				sizeof(PointLightInstance),
+				INITIAL_LIGHT_CAPACITY,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+			instanceBuffers[i]->map();
+
+			auto instanceInfo = instanceBuffers[i]->descriptorInfo();
+			if (!LveDescriptorWriter(*instanceSetLayout, *instancePool)
+				.writeBuffer(0, &instanceInfo)
+				.build(instanceDescriptorSets[i])) {
+				throw std::runtime_error("Failed to allocate point light instance descriptor set!");
+			}
+		}
+	}
+
+	/**
+		 * @brief Makes sure a frame's instance buffer can hold the given number of lights.
+		 *
+		 * @param frameIndex The frame in flight whose buffer is written.
+		 * @param lightCount The number of lights about to be written.
+		 * @return True if the buffer was recreated and the frame's descriptor set was rewritten.
+		 *
+		 * Grows the buffer to at least twice its size, the frame's previous submission has already completed.
+		 */
+	bool PointLightSystem::reserveInstances(int frameIndex, uint32_t lightCount) {
+		auto& buffer = instanceBuffers[frameIndex];
+		if (lightCount <= buffer->getInstanceCount()) {
+			return false;
+		}
+
+		buffer = std::make_unique<LveBuffer>(
+			lveDevice,
+			sizeof(PointLightInstance),
+			std::max(lightCount, buffer->getInstanceCount() * 2),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+		buffer->map();
+
+		auto instanceInfo = buffer->descriptorInfo();
+		LveDescriptorWriter(*instanceSetLayout, *instancePool)
+			.writeBuffer(0, &instanceInfo)
+			.overwrite(instanceDescriptorSets[frameIndex]);
+		return true;
 	}
 
 	/**
 		 * @brief Updates the point light properties for the current frame.
 		 *
 		 * @param frameInfo A reference to the `FrameInfo` struct containing frame-specific data.
-		 * @param ubo A reference to the `GlobalUbo` struct containing global uniform buffer data.
 		 *
-		 * Updates the positions, colors, and other properties of point lights based on the current frame's data.
+		 * Updates the positions of point lights based on the current frame's data. The lights are uploaded for shading
+		 * by `LveLightClusters`.
 		 */
-	void PointLightSystem::update(FrameInfo& frameInfo, GlobalUbo& ubo) {
+	void PointLightSystem::update(FrameInfo& frameInfo) {
 		auto rotateLight = glm::rotate(glm::mat4(1.f), frameInfo.frameTime, { 0.f, -1.f, 0.f });
 
-		int lightIndex = 0;
 		for (auto& kv : frameInfo.gameObjects) {
 			auto& obj = kv.second;
 			if (obj.pointLight == nullptr) continue;
 
-			assert(lightIndex < MAX_LIGHTS && "Point lights exceed maximum specified.");
-
 			// update light position
 			obj.transform.translation = glm::vec3(rotateLight * glm::vec4(obj.transform.translation, 1.f));
-
-			// copy light to ubo
-			ubo.pointLights[lightIndex].position = glm::vec4(obj.transform.translation, 1.f);
-			ubo.pointLights[lightIndex].color = glm::vec4(obj.color, obj.pointLight->lightIntensity);
-
-			lightIndex += 1;
+			if (frameInfo.sceneBvh != nullptr) {
+				frameInfo.sceneBvh->markMoved(obj.getId());
+			}
 		}
-		ubo.numLights = lightIndex;
 	}
 
 	/**
@@ -151,41 +223,59 @@ namespace lve {
 		 *
 		 * @param frameInfo A reference to the `FrameInfo` struct containing frame-specific data.
 		 *
-		 * Binds the pipeline, descriptor sets, and pushes point light data to the shaders. Issues draw commands to render
-		 * the point lights.
+		 * Sorts the lights back to front through the render queue and writes their instance data in that order, then
+		 * binds the pipeline and descriptor sets and draws every billboard with one instanced draw. Later instances
+		 * are rasterized on top of earlier ones, so the blended edges of nearer lights cover farther ones.
 		 */
 	void PointLightSystem::render(FrameInfo &frameInfo) {
-		lvePipeline->bind(frameInfo.commandBuffer);
+		LvePipeline* pipeline = lvePipeline.get();
+		if (pipeline == nullptr) return;
+		LveGpuProfiler::Zone gpuZone{ frameInfo.gpuProfiler, frameInfo.commandBuffer, "point lights" };
+
+		lights.clear();
+		renderQueue.clear();
+		const glm::mat4& view = frameInfo.camera.getView();
+		const uint32_t pipelineId = pipeline->getId();
+		for (auto& kv : frameInfo.gameObjects) {
+			auto& obj = kv.second;
+			if (obj.pointLight == nullptr) continue;
+
+			float viewDepth = (view * glm::vec4(obj.transform.translation, 1.f)).z;
+			renderQueue.push(
+				LveRenderQueue::makeKey(pipelineId, 0, viewDepth, LveRenderQueue::DepthOrder::BackToFront),
+				static_cast<uint32_t>(lights.size()));
+			lights.push_back(&obj);
+		}
+		renderQueue.sort();
+
+		const uint32_t lightCount = renderQueue.size();
+		if (lightCount == 0) return;
+
+		reserveInstances(frameInfo.frameIndex, lightCount);
+		auto& instanceBuffer = *instanceBuffers[frameInfo.frameIndex];
+		auto* instances = static_cast<PointLightInstance*>(instanceBuffer.getMappedMemory());
+		for (uint32_t i = 0; i < lightCount; i++) {
+			auto& obj = *lights[renderQueue.getPayload(i)];
+			instances[i].position = glm::vec4(obj.transform.translation, obj.transform.scale.x);
+			instances[i].color = glm::vec4(obj.color, obj.pointLight->lightIntensity);
+		}
+		instanceBuffer.flush();
+
+		pipeline->bind(frameInfo.commandBuffer);
 
+		std::array<VkDescriptorSet, 2> descriptorSets{
+			frameInfo.globalDescriptorSet, instanceDescriptorSets[frameInfo.frameIndex] };
 		vkCmdBindDescriptorSets(
 			frameInfo.commandBuffer,
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
 			pipelineLayout,
 			0,
-			1,
-			&frameInfo.globalDescriptorSet,
+			static_cast<uint32_t>(descriptorSets.size()),
+			descriptorSets.data(),
 			0,
 			nullptr
 		);
 
-		for (auto& kv : frameInfo.gameObjects) {
-			auto& obj = kv.second;
-			if (obj.pointLight == nullptr) continue;
-
-			PointLightPushConstants push{};
-			push.position = glm::vec4(obj.transform.translation, 1.f);
-			push.color = glm::vec4(obj.color, obj.pointLight->lightIntensity);
-			push.radius = obj.transform.scale.x;
-
-			vkCmdPushConstants(
-				frameInfo.commandBuffer,
-				pipelineLayout,
-				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-				0,
-				sizeof(PointLightPushConstants),
-				&push
-			);
-			vkCmdDraw(frameInfo.commandBuffer, 6, 1, 0, 0);
-		}
+		vkCmdDraw(frameInfo.commandBuffer, 6, lightCount, 0, 0);
 	}
-}
\ No newline at end of file
+}
@@ -1,10 +1,15 @@
 #pragma once
 
+#include "lve_buffer.hpp"
 #include "lve_camera.hpp"
+#include "lve_descriptors.hpp"
 #include "lve_device.hpp"
 #include "lve_game_object.hpp"
 #include "lve_pipeline.hpp"
+#include "lve_pipeline_compiler.hpp"
 #include "lve_frame_info.hpp"
+#include "lve_job_system.hpp"
+#include "lve_render_queue.hpp"
 
 // std
 #include <memory>
@@ -12,24 +17,51 @@
 
 namespace lve {
 
+	// Per light data of the billboard draw, read by point_light.vert with gl_InstanceIndex (std430)
+	struct PointLightInstance {
+		glm::vec4 position{}; // w is the billboard radius
+		glm::vec4 color{}; // w is intensity
+	};
+
 	class PointLightSystem {
 	public:
-		PointLightSystem(LveDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+		static constexpr uint32_t INITIAL_LIGHT_CAPACITY = 256;
+
+		PointLightSystem(
+			LveDevice& device,
+			LveJobSystem& jobSystem,
+			LvePipelineCompiler& pipelineCompiler,
+			VkRenderPass renderPass,
+			VkDescriptorSetLayout globalSetLayout,
+			uint32_t framesInFlight);
 		~PointLightSystem();
 
 		PointLightSystem(const PointLightSystem&) = delete;
 		PointLightSystem& operator=(const PointLightSystem&) = delete;
 
-		void update(FrameInfo& frameInfo, GlobalUbo& ubo);
+		void update(FrameInfo& frameInfo);
 		void render(FrameInfo &frameInfo);
 
 	private:
 		void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
-		void createPipeline(VkRenderPass renderPass);
+		void createPipeline(LvePipelineCompiler& pipelineCompiler, VkRenderPass renderPass);
+		void createInstanceResources(uint32_t framesInFlight);
+		// Returns true if the frame's buffer was recreated
+		bool reserveInstances(int frameIndex, uint32_t lightCount);
 
 		LveDevice& lveDevice;
 
-		std::unique_ptr<LvePipeline> lvePipeline;
+		LveAsyncPipeline lvePipeline;
 		VkPipelineLayout pipelineLayout;
+
+		LveRenderQueue renderQueue;
+		// light objects of the current frame, indexed by the queue's payloads
+		std::vector<LveGameObject*> lights;
+
+		// per frame storage buffer of the sorted lights' instance data
+		std::unique_ptr<LveDescriptorSetLayout> instanceSetLayout;
+		std::unique_ptr<LveDescriptorPool> instancePool;
+		std::vector<std::unique_ptr<LveBuffer>> instanceBuffers;
+		std::vector<VkDescriptorSet> instanceDescriptorSets;
 	};
 }
\ No newline at end of file
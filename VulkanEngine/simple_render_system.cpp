@@ -1,5 +1,8 @@
 #include "simple_render_system.hpp"
 
+#include "lve_gpu_profiler.hpp"
+#include "lve_swap_chain.hpp"
+
 // libs
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -7,6 +10,8 @@
 #include <glm/gtc/constants.hpp>
 
 // std
+#include <algorithm>
+#include <cstring>
 #include <stdexcept>
 #include <array>
 #include <cassert>
@@ -20,16 +25,24 @@ namespace lve {
 	 * and push constants. It is designed to work with a Vulkan-based rendering engine and handles the creation and
 	 * management of Vulkan pipelines and pipeline layouts for rendering operations.
 	 *
-	 * The system uses Vulkan's push constants to pass model and normal matrices to the shaders, and updates the shader
-	 * with the current transformation data for each game object. It binds the necessary descriptor sets and issues
-	 * draw commands to render the objects.
+	 * Visible objects are submitted through a render queue sorted by pipeline, model and view depth. Objects sharing a
+	 * model end up next to each other and are drawn with a single instanced draw, their instances ordered front to
+	 * back so early depth testing rejects as much hidden geometry as possible.
+	 * Every object that has been visible recently owns a slot in a persistent storage buffer of compact 3x4 transforms,
+	 * and only slots whose transform changed are uploaded. Per instance the system writes just the 4 byte slot index
+	 * to a per frame storage buffer that the vertex shader indexes with `gl_InstanceIndex`, each draw's instances
+	 * starting at its `firstInstance`.
+	 *
+	 * With the depth pre-pass enabled the visible objects are first drawn by a depth only pipeline that reads just
+	 * their positions and has no fragment shader. The shading pipeline then tests for EQUAL depth without writing it,
+	 * so the lighting loop runs once per covered pixel no matter how much the objects overlap.
 	 *
 	 * The class provides the following functionalities:
 	 * - **Constructor & Destructor**: Initializes Vulkan resources required for rendering and cleans up resources
 	 *   when the system is destroyed.
 	 * - **Pipeline Creation**: Sets up the Vulkan pipeline layout and pipeline specifically for rendering simple game objects.
-	 * - **Rendering**: Binds the pipeline, descriptor sets, and push constants for each game object. Issues draw commands
-	 *   to render the objects.
+	 * - **Rendering**: Binds the pipeline and descriptor sets, uploads the instance data of the visible objects and
+	 *   issues one draw command per model.
 	 *
 	 * @see LveDevice
 	 * @see LvePipeline
@@ -38,22 +51,45 @@ namespace lve {
 	 * @see VkDescriptorSetLayout
 	 */
 
-	struct SimplePushConstantData {
-		glm::mat4 modelMatrix{ 1.f };
-		glm::mat4 normalMatrix{ 1.f };
-	};
+	// instances each per frame buffer starts with, buffers grow to fit the visible objects
+	constexpr uint32_t INITIAL_INSTANCE_CAPACITY = 1024;
+
+	// objects keep their transform slot this many frames after they were last visible
+	constexpr uint64_t TRANSFORM_SLOT_RELEASE_FRAMES = 120;
+	// how often slots of objects that left the view or were removed are looked for
+	constexpr uint64_t TRANSFORM_SLOT_SWEEP_INTERVAL = 64;
+
+	// fewer instances than this per secondary command buffer cost more in overhead than parallel recording saves
+	constexpr uint32_t MIN_INSTANCES_PER_RECORDING_TASK = 256;
 
 	/**
 		 * @brief Constructs a `SimpleRenderSystem` instance.
 		 *
 		 * @param device A reference to the `LveDevice` used to create Vulkan resources.
+		 * @param jobSystem The job system occluder rasterization and draw sorting are spread over.
+		 * @param pipelineCompiler Compiles the system's pipelines in the background, nothing is drawn until the
+		 *        shading pipeline is ready.
 		 * @param renderPass A Vulkan `VkRenderPass` used for rendering.
 		 * @param globalSetLayout A Vulkan `VkDescriptorSetLayout` for global descriptor sets.
+		 * @param framesInFlight Number of frames the renderer keeps in flight, each gets its own instance and
+		 *        transform buffers.
 		 */
-	SimpleRenderSystem::SimpleRenderSystem(LveDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout)
-		: lveDevice{ device } {
+	SimpleRenderSystem::SimpleRenderSystem(
+		LveDevice& device,
+		LveJobSystem& jobSystem,
+		LvePipelineCompiler& pipelineCompiler,
+		VkRenderPass renderPass,
+		VkDescriptorSetLayout globalSetLayout,
+		uint32_t framesInFlight)
+		: lveDevice{ device },
+		pipelineCompiler{ pipelineCompiler },
+		renderPass{ renderPass },
+		transformBuffer{ device, framesInFlight, INITIAL_INSTANCE_CAPACITY },
+		occlusionCuller{ jobSystem },
+		renderQueue{ jobSystem } {
+		createInstanceResources(framesInFlight);
 		createPipelineLayout(globalSetLayout);
-		createPipeline(renderPass);
+		createPipeline();
 	}
 
 	/**
@@ -62,31 +98,153 @@ namespace lve {
 		 * Cleans up Vulkan resources associated with the pipeline layout.
 		 */
 	SimpleRenderSystem::~SimpleRenderSystem() { 
+		// pending compilations still use the layout
+		for (auto& kv : variantPipelines) {
+			kv.second.shading.wait();
+			kv.second.prepassShading.wait();
+		}
+		depthPrepassPipeline.wait();
 		vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
 	}
 
+	/**
+		 * @brief Creates the per frame instance buffers and their descriptor sets.
+		 *
+		 * Each frame in flight owns its own buffer of object slot indices so the CPU can fill one while the GPU still
+		 * reads another. The set also references the frame's transform buffer.
+		 */
+	void SimpleRenderSystem::createInstanceResources(uint32_t framesInFlight) {
+		instanceSetLayout =
+			LveDescriptorSetLayout::Builder(lveDevice)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+			.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+			.build();
+		instancePool =
+			LveDescriptorPool::Builder(lveDevice)
+			.setMaxSets(framesInFlight)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2 * framesInFlight)
+			.build();
+
+		instanceBuffers.resize(framesInFlight);
+		instanceDescriptorSets.resize(framesInFlight);
+		for (int i = 0; i < instanceBuffers.size(); i++) {
+			instanceBuffers[i] = std::make_unique<LveBuffer>(
+				lveDevice,
+				sizeof(uint32_t),
+				INITIAL_INSTANCE_CAPACITY,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+			instanceBuffers[i]->map();
+
+			auto instanceInfo = instanceBuffers[i]->descriptorInfo();
+			auto transformInfo = transformBuffer.getBuffer(i).descriptorInfo();
+			if (!LveDescriptorWriter(*instanceSetLayout, *instancePool)
+				.writeBuffer(0, &instanceInfo)
+				.writeBuffer(1, &transformInfo)
+				.build(instanceDescriptorSets[i])) {
+				throw std::runtime_error("Failed to allocate instance descriptor set!");
+			}
+		}
+	}
+
+	/**
+		 * @brief Makes sure a frame's instance buffer can hold the given number of instances.
+		 *
+		 * @param frameIndex The frame in flight whose buffer is written.
+		 * @param instanceCount The number of instances about to be written.
+		 * @return True if the buffer was recreated and the frame's descriptor set must be rewritten.
+		 *
+		 * Grows the buffer to at least twice its size. This is safe because the renderer waited for the frame's
+		 * previous submission before handing out its command buffer.
+		 */
+	bool SimpleRenderSystem::reserveInstances(int frameIndex, uint32_t instanceCount) {
+		auto& buffer = instanceBuffers[frameIndex];
+		if (instanceCount <= buffer->getInstanceCount()) {
+			return false;
+		}
+
+		buffer = std::make_unique<LveBuffer>(
+			lveDevice,
+			sizeof(uint32_t),
+			std::max(instanceCount, buffer->getInstanceCount() * 2),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+		buffer->map();
+		return true;
+	}
+
+	/**
+		 * @brief Points a frame's descriptor set at its current instance and transform buffers.
+		 *
+		 * @param frameIndex The frame in flight whose set is rewritten.
+		 */
+	void SimpleRenderSystem::writeInstanceDescriptorSet(int frameIndex) {
+		auto instanceInfo = instanceBuffers[frameIndex]->descriptorInfo();
+		auto transformInfo = transformBuffer.getBuffer(frameIndex).descriptorInfo();
+		LveDescriptorWriter(*instanceSetLayout, *instancePool)
+			.writeBuffer(0, &instanceInfo)
+			.writeBuffer(1, &transformInfo)
+			.overwrite(instanceDescriptorSets[frameIndex]);
+	}
+
+	/**
+		 * @brief Returns the transform slot of a visible object, writing its current model matrix.
+		 *
+		 * @param obj The visible object.
+		 * @param modelMatrix The object's model matrix this frame.
+		 * @return The slot index the vertex shader reads the transform from.
+		 *
+		 * Objects get a slot the first time they are visible. Writing an unchanged matrix does not cause an upload.
+		 */
+	uint32_t SimpleRenderSystem::acquireTransformSlot(LveGameObject& obj, const glm::mat4& modelMatrix) {
+		auto inserted = objectSlots.try_emplace(obj.getId());
+		ObjectSlot& objectSlot = inserted.first->second;
+		if (inserted.second) {
+			objectSlot.slot = transformBuffer.allocateSlot();
+		}
+		objectSlot.lastVisibleFrame = frameCounter;
+		transformBuffer.update(objectSlot.slot, modelMatrix);
+		return objectSlot.slot;
+	}
+
+	/**
+		 * @brief Releases the slots of objects that have not been visible for a while.
+		 *
+		 * This also reclaims the slots of removed objects, which are never visible again. Slots are only released long
+		 * after the last frame that referenced them has finished on the GPU.
+		 */
+	void SimpleRenderSystem::releaseStaleTransformSlots() {
+		if (frameCounter % TRANSFORM_SLOT_SWEEP_INTERVAL != 0) return;
+
+		for (auto it = objectSlots.begin(); it != objectSlots.end();) {
+			if (it->second.lastVisibleFrame + TRANSFORM_SLOT_RELEASE_FRAMES < frameCounter) {
+				transformBuffer.releaseSlot(it->second.slot);
+				it = objectSlots.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
+
 	/**
 		 * @brief Creates the pipeline layout for the simple render system.
 		 *
 		 * @param globalSetLayout A Vulkan `VkDescriptorSetLayout` used in the pipeline layout.
 		 *
-		 * Configures the pipeline layout with push constants for model and normal matrices and descriptor set layouts.
+		 * Configures the pipeline layout with the global descriptor set and the per frame instance set.
 		 * Throws an exception if pipeline layout creation fails.
 		 */
 	void SimpleRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout) {
-		VkPushConstantRange pushConstantRange{};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-		pushConstantRange.offset = 0;
-		pushConstantRange.size = sizeof(SimplePushConstantData);
-
-		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{ globalSetLayout };
+		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{
+			globalSetLayout,
+			instanceSetLayout->getDescriptorSetLayout() };
 
 		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
 		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
 		pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-		pipelineLayoutInfo.pushConstantRangeCount = 1;
-		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		pipelineLayoutInfo.pushConstantRangeCount = 0;
+		pipelineLayoutInfo.pPushConstantRanges = nullptr;
 		if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) !=
 			VK_SUCCESS) {
 			throw std::runtime_error("Failed to create pipeline layout!");
@@ -94,28 +252,171 @@ namespace lve {
 	}
 
 	/**
-		 * @brief Creates the Vulkan pipeline for rendering simple game objects.
+		 * @brief Queues the Vulkan pipelines for rendering simple game objects.
 		 *
-		 * @param renderPass A Vulkan `VkRenderPass` used for rendering.
-		 *
-		 * Sets up the Vulkan graphics pipeline, including shaders and pipeline configuration. The pipeline is configured
-		 * without attribute and binding descriptions.
-		 * Throws an exception if pipeline creation fails.
+		 * The default shading variant and the depth pre-pass pipeline compile concurrently. Compilation errors are
+		 * rethrown by the first frame that finds the failed pipeline.
 		 */
-	void SimpleRenderSystem::createPipeline(VkRenderPass renderPass) {
+	void SimpleRenderSystem::createPipeline() {
 		assert(pipelineLayout != nullptr && "Cannot create pipeline before pipline layout.");
 
-		PipelineConfigInfo pipelineConfig{};
-		LvePipeline::defaultPipelineConfigInfo(pipelineConfig);
-		pipelineConfig.attributeDescriptions.clear();
-		pipelineConfig.bindingDescriptions.clear();
-		pipelineConfig.renderPass = renderPass;
-		pipelineConfig.pipelineLayout = pipelineLayout;
-		lvePipeline = std::make_unique<LvePipeline>(
-			lveDevice,
+		compileShadingVariant(shadingVariant);
+
+		VkPipelineLayout layout = pipelineLayout;
+		VkRenderPass pass = renderPass;
+		depthPrepassPipeline = pipelineCompiler.compileGraphics(
+			"depth_prepass.vert.spv",
+			"",
+			[pass, layout](PipelineConfigInfo& pipelineConfig) {
+				pipelineConfig.bindingDescriptions = LveModel::Vertex::getPositionBindingDescriptions();
+				pipelineConfig.attributeDescriptions = LveModel::Vertex::getPositionAttributeDescriptions();
+				pipelineConfig.colorBlendAttachment.colorWriteMask = 0;
+				pipelineConfig.renderPass = pass;
+				pipelineConfig.pipelineLayout = layout;
+			});
+	}
+
+	uint64_t ShadingVariant::getKey() const {
+		uint32_t exponentBits;
+		std::memcpy(&exponentBits, &specularExponent, sizeof(exponentBits));
+		return (static_cast<uint64_t>(exponentBits) << 32) | (static_cast<uint64_t>(maxClusterLights & 0x7fffffff) << 1)
+			| (specularEnabled ? 1u : 0u);
+	}
+
+	/**
+		 * @brief Selects the specialization constants objects are shaded with.
+		 *
+		 * @param variant The variant to use from now on.
+		 *
+		 * A variant that was not used before is queued for compilation and the default variant stands in until it
+		 * is ready. Compiled variants stay cached, switching back to one is immediate.
+		 */
+	void SimpleRenderSystem::setShadingVariant(const ShadingVariant& variant) {
+		shadingVariant = variant;
+		if (variantPipelines.find(variant.getKey()) == variantPipelines.end()) {
+			compileShadingVariant(variant);
+		}
+	}
+
+	/**
+		 * @brief Queues the shading pipeline of a variant and its EQUAL depth test twin for the depth pre-pass.
+		 *
+		 * @param variant The specialization constants compiled into simple_shader.frag.
+		 */
+	void SimpleRenderSystem::compileShadingVariant(const ShadingVariant& variant) {
+		VkPipelineLayout layout = pipelineLayout;
+		VkRenderPass pass = renderPass;
+		auto specialize = [variant](PipelineConfigInfo& pipelineConfig) {
+			pipelineConfig.setSpecializationConstant(0, variant.specularExponent);
+			pipelineConfig.setSpecializationConstant(1, variant.specularEnabled);
+			pipelineConfig.setSpecializationConstant(2, variant.maxClusterLights);
+		};
+
+		VariantPipelines& pipelines = variantPipelines[variant.getKey()];
+		pipelines.shading = pipelineCompiler.compileGraphics(
+			"simple_shader.vert.spv",
+			"simple_shader.frag.spv",
+			[pass, layout, specialize](PipelineConfigInfo& pipelineConfig) {
+				specialize(pipelineConfig);
+				pipelineConfig.renderPass = pass;
+				pipelineConfig.pipelineLayout = layout;
+			});
+
+		// shading after a depth pre-pass, only the fragments that won the depth test are shaded
+		pipelines.prepassShading = pipelineCompiler.compileGraphics(
 			"simple_shader.vert.spv",
 			"simple_shader.frag.spv",
-			pipelineConfig);
+			[pass, layout, specialize](PipelineConfigInfo& pipelineConfig) {
+				specialize(pipelineConfig);
+				pipelineConfig.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_EQUAL;
+				pipelineConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
+				pipelineConfig.renderPass = pass;
+				pipelineConfig.pipelineLayout = layout;
+			});
+	}
+
+	/**
+		 * @brief Culls game objects against the camera's view frustum.
+		 *
+		 * @param frameInfo A reference to the `FrameInfo` struct containing frame-specific data.
+		 *
+		 * When the frame provides a scene BVH it is traversed first so only objects whose boxes touch the frustum
+		 * are considered. Each candidate's object space bounding sphere is then transformed into world space and
+		 * tested against planes extracted from the camera's projection * view matrix. Indices into `cullCandidates`
+		 * of the objects that survive are written to `visibleIndices`.
+		 */
+	void SimpleRenderSystem::cullGameObjects(FrameInfo& frameInfo) {
+		cullCandidates.clear();
+		candidateTransforms.clear();
+		candidateSpheres.clear();
+		visibleIndices.clear();
+
+		const glm::mat4 viewProjection = frameInfo.camera.getProjection() * frameInfo.camera.getView();
+		LveFrustum frustum{ viewProjection };
+
+		auto addCandidate = [&](LveGameObject& obj) {
+			glm::mat4 modelMatrix = obj.transform.mat4();
+			cullCandidates.push_back(&obj);
+			candidateTransforms.push_back(modelMatrix);
+			candidateSpheres.push(obj.model->getBoundingSphere().transformed(modelMatrix, obj.transform.scale));
+		};
+
+		size_t renderableCount = 0;
+		if (frameInfo.sceneBvh != nullptr) {
+			bvhResults.clear();
+			frameInfo.sceneBvh->queryFrustum(frustum, bvhResults);
+			for (auto id : bvhResults) {
+				auto it = frameInfo.gameObjects.find(id);
+				if (it == frameInfo.gameObjects.end() || it->second.model == nullptr) continue;
+				addCandidate(it->second);
+			}
+			renderableCount = frameInfo.sceneBvh->size();
+		} else {
+			for (auto& kv : frameInfo.gameObjects) {
+				if (kv.second.model == nullptr) continue;
+				addCandidate(kv.second);
+			}
+			renderableCount = cullCandidates.size();
+		}
+
+		frustum.cullSpheres(candidateSpheres, visibleIndices);
+		cullingStats.culledCount = static_cast<uint32_t>(renderableCount - visibleIndices.size());
+
+		size_t frustumVisibleCount = visibleIndices.size();
+		if (occlusionCullingEnabled) {
+			cullOccludedObjects(viewProjection);
+		}
+		cullingStats.visibleCount = static_cast<uint32_t>(visibleIndices.size());
+		cullingStats.occludedCount = static_cast<uint32_t>(frustumVisibleCount - visibleIndices.size());
+	}
+
+	/**
+		 * @brief Removes frustum visible objects that are hidden behind occluders.
+		 *
+		 * @param viewProjection The camera's projection * view matrix.
+		 *
+		 * Visible objects with an `OccluderComponent` are rasterized into the CPU depth buffer, then every other
+		 * visible object's world space box is tested against its depth pyramid. Occluders themselves are always kept.
+		 */
+	void SimpleRenderSystem::cullOccludedObjects(const glm::mat4& viewProjection) {
+		occlusionCuller.beginFrame(viewProjection);
+		bool hasOccluders = false;
+		for (uint32_t index : visibleIndices) {
+			auto& obj = *cullCandidates[index];
+			if (obj.occluder == nullptr) continue;
+			const auto& mesh = obj.occluder->mesh != nullptr ? obj.occluder->mesh : obj.model->getOccluderMesh();
+			occlusionCuller.addOccluder(*mesh, candidateTransforms[index]);
+			hasOccluders = true;
+		}
+		if (!hasOccluders) return;
+		occlusionCuller.rasterizeOccluders();
+
+		auto occluded = [this](uint32_t index) {
+			auto& obj = *cullCandidates[index];
+			if (obj.occluder != nullptr) return false;
+			return !occlusionCuller.isVisible(obj.model->getBoundingBox().transformed(candidateTransforms[index]));
+		};
+		visibleIndices.erase(std::remove_if(visibleIndices.begin(), visibleIndices.end(), occluded), visibleIndices.end());
 	}
 
 	/**
@@ -123,39 +424,176 @@ namespace lve {
 		 *
 		 * @param frameInfo A reference to the `FrameInfo` struct containing frame-specific data.
 		 *
-		 * Binds the pipeline and descriptor sets, pushes transformation matrices to the shaders, and issues draw commands
-		 * for each game object with a model. Objects without a model are skipped.
+		 * Culls objects outside of the view frustum or behind occluders and pushes the remaining objects into the render
+		 * queue, keyed by pipeline, model and the view depth of their bounding sphere's center. After sorting, the
+		 * transform slot indices are written in queue order so every run of objects sharing a model is contiguous, and
+		 * only changed transforms are uploaded. Each run is drawn with one instanced draw whose `firstInstance` points at
+		 * its first entry. Pipeline and model binds that would not change any state are skipped.
+		 *
+		 * When the frame provides a command recorder the runs are split into contiguous ranges recorded into one
+		 * secondary command buffer each on the job system, which keeps their front to back order when executed.
 		 */
 	void SimpleRenderSystem::renderGameObjects(FrameInfo &frameInfo) {
-		lvePipeline->bind(frameInfo.commandBuffer);
+		// resolved once here, recording tasks only read the chosen pipelines. The default variant stands in while
+		// the selected one compiles.
+		VariantPipelines* variant = &variantPipelines.at(shadingVariant.getKey());
+		if (variant->shading.get() == nullptr) {
+			variant = &variantPipelines.at(ShadingVariant{}.getKey());
+		}
+		shadingPipeline = variant->shading.get();
+		prepassPipeline = nullptr;
+		if (depthPrepassEnabled && depthPrepassPipeline.get() != nullptr && variant->prepassShading.get() != nullptr) {
+			prepassPipeline = depthPrepassPipeline.get();
+			shadingPipeline = variant->prepassShading.get();
+		}
+		if (shadingPipeline == nullptr) {
+			// still compiling, skip the objects for now
+			cullingStats = CullingStats{};
+			return;
+		}
+
+		cullGameObjects(frameInfo);
+
+		const glm::mat4& view = frameInfo.camera.getView();
+		const uint32_t pipelineId = shadingPipeline->getId();
+		renderQueue.clear();
+		for (uint32_t index : visibleIndices) {
+			float viewDepth = view[0][2] * candidateSpheres.centerX[index] + view[1][2] * candidateSpheres.centerY[index]
+				+ view[2][2] * candidateSpheres.centerZ[index] + view[3][2];
+			renderQueue.push(
+				LveRenderQueue::makeKey(pipelineId, cullCandidates[index]->model->getId(), viewDepth), index);
+		}
+		renderQueue.sort();
+
+		frameCounter++;
+		const uint32_t instanceCount = renderQueue.size();
+		bool instancesGrown = reserveInstances(frameInfo.frameIndex, instanceCount);
+		auto& instanceBuffer = *instanceBuffers[frameInfo.frameIndex];
+		auto* instances = static_cast<uint32_t*>(instanceBuffer.getMappedMemory());
+		for (uint32_t i = 0; i < instanceCount; i++) {
+			uint32_t index = renderQueue.getPayload(i);
+			instances[i] = acquireTransformSlot(*cullCandidates[index], candidateTransforms[index]);
+		}
+		instanceBuffer.flush();
+
+		bool transformsGrown = transformBuffer.upload(frameInfo.frameIndex);
+		if (instancesGrown || transformsGrown) {
+			writeInstanceDescriptorSet(frameInfo.frameIndex);
+		}
+		cullingStats.uploadedTransformBytes = static_cast<uint32_t>(transformBuffer.getUploadedBytes());
+		releaseStaleTransformSlots();
+
+		drawRuns.clear();
+		uint32_t firstInstance = 0;
+		while (firstInstance < instanceCount) {
+			LveModel* model = cullCandidates[renderQueue.getPayload(firstInstance)]->model.get();
+			uint32_t endInstance = firstInstance + 1;
+			while (endInstance < instanceCount && cullCandidates[renderQueue.getPayload(endInstance)]->model.get() == model) {
+				endInstance++;
+			}
+			drawRuns.push_back(DrawRun{ model, firstInstance, endInstance - firstInstance });
+			firstInstance = endInstance;
+		}
+
+		const uint32_t runCount = static_cast<uint32_t>(drawRuns.size());
+		const uint32_t passCount = prepassPipeline != nullptr ? 2 : 1;
+		cullingStats.drawCallCount = passCount * runCount;
+		cullingStats.bindCount = 0;
+		cullingStats.recordingTaskCount = 0;
+		if (frameInfo.commandRecorder == nullptr) {
+			if (prepassPipeline != nullptr) {
+				cullingStats.bindCount += recordDraws(
+					frameInfo, frameInfo.commandBuffer, 0, instanceCount, DrawPass::DepthPrepass);
+			}
+			cullingStats.bindCount += recordDraws(frameInfo, frameInfo.commandBuffer, 0, instanceCount, DrawPass::Shading);
+			return;
+		}
+		if (instanceCount == 0) return;
+
+		// split the instances evenly, but only as far as every task still records a worthwhile number of them. A
+		// task boundary may fall inside a run, a large instanced run is then drawn in parts by several tasks.
+		LveCommandRecorder& recorder = *frameInfo.commandRecorder;
+		const uint32_t taskCount = std::clamp(
+			(instanceCount + MIN_INSTANCES_PER_RECORDING_TASK - 1) / MIN_INSTANCES_PER_RECORDING_TASK,
+			1u,
+			recorder.getThreadSlotCount());
+		const uint32_t instancesPerTask = (instanceCount + taskCount - 1) / taskCount;
+		for (uint32_t boundary = instancesPerTask; boundary < instanceCount; boundary += instancesPerTask) {
+			// a boundary inside a run draws it in two parts
+			auto run = std::lower_bound(drawRuns.begin(), drawRuns.end(), boundary, [](const DrawRun& r, uint32_t instance) {
+				return r.firstInstance < instance;
+			});
+			if (run == drawRuns.end() || run->firstInstance != boundary) {
+				cullingStats.drawCallCount += passCount;
+			}
+		}
+		auto recordPass = [&](DrawPass pass) {
+			taskBindCounts.assign(taskCount, 0);
+			recorder.recordParallel(taskCount, [&](uint32_t taskIndex, VkCommandBuffer commandBuffer) {
+				const uint32_t firstInstance = std::min(instanceCount, taskIndex * instancesPerTask);
+				const uint32_t endInstance = std::min(instanceCount, firstInstance + instancesPerTask);
+				taskBindCounts[taskIndex] = recordDraws(frameInfo, commandBuffer, firstInstance, endInstance, pass);
+			});
+			for (uint32_t bindCount : taskBindCounts) {
+				cullingStats.bindCount += bindCount;
+			}
+		};
+		// secondaries execute in recording order, so the whole depth pass completes before any object is shaded
+		if (prepassPipeline != nullptr) {
+			recordPass(DrawPass::DepthPrepass);
+		}
+		recordPass(DrawPass::Shading);
+		cullingStats.recordingTaskCount = taskCount;
+	}
 
+	/**
+		 * @brief Records the draws of a range of instances.
+		 *
+		 * @param frameInfo A reference to the `FrameInfo` struct containing frame-specific data.
+		 * @param commandBuffer The primary or secondary command buffer to record into.
+		 * @param firstInstance Index of the first instance in the sorted render queue.
+		 * @param endInstance Index one past the last instance.
+		 * @param pass Whether to lay down depth only or to shade the runs.
+		 * @return The number of pipeline and model binds recorded.
+		 *
+		 * Only reads state prepared by renderGameObjects, so ranges can be recorded concurrently into different
+		 * command buffers. Every command buffer gets its own pipeline and descriptor set binds. Runs crossing the
+		 * range's bounds are drawn in part.
+		 */
+	uint32_t SimpleRenderSystem::recordDraws(
+		FrameInfo& frameInfo, VkCommandBuffer commandBuffer, uint32_t firstInstance, uint32_t endInstance, DrawPass pass) {
+		const bool depthOnly = pass == DrawPass::DepthPrepass;
+		// parallel ranges of a pass share the zone name, so the pass is reported as a whole
+		LveGpuProfiler::Zone gpuZone{ frameInfo.gpuProfiler, commandBuffer, depthOnly ? "depth prepass" : "shading" };
+		LveBindState bindState{ commandBuffer };
+		bindState.bindPipeline(depthOnly ? *prepassPipeline : *shadingPipeline);
+
+		VkDescriptorSet descriptorSets[] = {
+			frameInfo.globalDescriptorSet,
+			instanceDescriptorSets[frameInfo.frameIndex] };
 		vkCmdBindDescriptorSets(
-			frameInfo.commandBuffer,
+			commandBuffer,
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
 			pipelineLayout,
 			0, 
-			1,
-			&frameInfo.globalDescriptorSet,
+			2,
+			descriptorSets,
 			0, 
 			nullptr
 		);
 
-		for (auto& kv : frameInfo.gameObjects) {
-			auto& obj = kv.second;
-			if (obj.model == nullptr) continue;
-			SimplePushConstantData push{};
-			push.modelMatrix = obj.transform.mat4();
-			push.normalMatrix = obj.transform.normalMatrix();
-
-			vkCmdPushConstants(
-				frameInfo.commandBuffer,
-				pipelineLayout,
-				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-				0,
-				sizeof(SimplePushConstantData),
-				&push);
-			obj.model->bind(frameInfo.commandBuffer);
-			obj.model->draw(frameInfo.commandBuffer);
+		if (firstInstance >= endInstance) return bindState.getBindCount();
+
+		// the last run starting at or before the range, the first run always starts at instance 0
+		auto run = std::upper_bound(drawRuns.begin(), drawRuns.end(), firstInstance, [](uint32_t instance, const DrawRun& r) {
+			return instance < r.firstInstance;
+		}) - 1;
+		for (; run != drawRuns.end() && run->firstInstance < endInstance; ++run) {
+			const uint32_t first = std::max(run->firstInstance, firstInstance);
+			const uint32_t end = std::min(run->firstInstance + run->instanceCount, endInstance);
+			bindState.bindModel(*run->model, depthOnly);
+			run->model->draw(commandBuffer, end - first, first);
 		}
+		return bindState.getBindCount();
 	}
 }
\ No newline at end of file
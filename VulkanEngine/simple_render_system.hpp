@@ -1,20 +1,55 @@
 #pragma once
 
+#include "lve_buffer.hpp"
 #include "lve_camera.hpp"
+#include "lve_command_recorder.hpp"
+#include "lve_descriptors.hpp"
 #include "lve_device.hpp"
+#include "lve_frustum.hpp"
 #include "lve_game_object.hpp"
+#include "lve_job_system.hpp"
+#include "lve_occlusion_culler.hpp"
 #include "lve_pipeline.hpp"
+#include "lve_pipeline_compiler.hpp"
 #include "lve_frame_info.hpp"
+#include "lve_render_queue.hpp"
+#include "lve_transform_buffer.hpp"
 
 // std
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 namespace lve {
 
+	struct CullingStats {
+		uint32_t visibleCount = 0;
+		uint32_t culledCount = 0;
+		uint32_t occludedCount = 0; // frustum visible objects hidden behind occluders
+		uint32_t drawCallCount = 0; // instanced draws, one per model run and recording task, twice with the depth pre-pass
+		uint32_t bindCount = 0; // pipeline and vertex buffer binds left after skipping redundant ones
+		uint32_t recordingTaskCount = 0; // secondaries the draws were split across, 0 when recorded inline
+		uint32_t uploadedTransformBytes = 0; // only transforms that changed since the frame's last upload
+	};
+
+	// specialization constants of simple_shader.frag, every distinct variant is compiled once and cached
+	struct ShadingVariant {
+		float specularExponent = 512.f;
+		bool specularEnabled = true;
+		uint32_t maxClusterLights = 0; // 0 shades every light of a cluster
+
+		uint64_t getKey() const;
+	};
+
 	class SimpleRenderSystem {
 	public:
-		SimpleRenderSystem(LveDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+		SimpleRenderSystem(
+			LveDevice& device,
+			LveJobSystem& jobSystem,
+			LvePipelineCompiler& pipelineCompiler,
+			VkRenderPass renderPass,
+			VkDescriptorSetLayout globalSetLayout,
+			uint32_t framesInFlight);
 		~SimpleRenderSystem();
 
 		SimpleRenderSystem(const SimpleRenderSystem&) = delete;
@@ -22,13 +57,90 @@ namespace lve {
 
 		void renderGameObjects(FrameInfo &frameInfo);
 
+		// counts from the most recent call to renderGameObjects
+		const CullingStats& getCullingStats() const { return cullingStats; }
+
+		void setOcclusionCullingEnabled(bool enabled) { occlusionCullingEnabled = enabled; }
+		bool isOcclusionCullingEnabled() const { return occlusionCullingEnabled; }
+
+		// lays down depth with a position only pass first, then shades with an EQUAL depth test, once its
+		// pipelines have compiled
+		void setDepthPrepassEnabled(bool enabled) { depthPrepassEnabled = enabled; }
+		bool isDepthPrepassEnabled() const { return depthPrepassEnabled; }
+
+		void setShadingVariant(const ShadingVariant& variant);
+		const ShadingVariant& getShadingVariant() const { return shadingVariant; }
+
 	private:
+		enum class DrawPass { DepthPrepass, Shading };
+
+		void createInstanceResources(uint32_t framesInFlight);
 		void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
-		void createPipeline(VkRenderPass renderPass);
+		void createPipeline();
+		void compileShadingVariant(const ShadingVariant& variant);
+		bool reserveInstances(int frameIndex, uint32_t instanceCount);
+		void writeInstanceDescriptorSet(int frameIndex);
+		uint32_t acquireTransformSlot(LveGameObject& obj, const glm::mat4& modelMatrix);
+		void releaseStaleTransformSlots();
+		void cullGameObjects(FrameInfo& frameInfo);
+		void cullOccludedObjects(const glm::mat4& viewProjection);
+		uint32_t recordDraws(
+			FrameInfo& frameInfo, VkCommandBuffer commandBuffer, uint32_t firstInstance, uint32_t endInstance, DrawPass pass);
+
+		// consecutive queue entries sharing a model, drawn with one instanced draw
+		struct DrawRun {
+			LveModel* model;
+			uint32_t firstInstance;
+			uint32_t instanceCount;
+		};
 
 		LveDevice &lveDevice;
 
-		std::unique_ptr<LvePipeline> lvePipeline;
+		LvePipelineCompiler& pipelineCompiler;
+		VkRenderPass renderPass;
+
+		// shading pipelines by ShadingVariant key, the EQUAL depth test twin is used after a depth pre-pass
+		struct VariantPipelines {
+			LveAsyncPipeline shading;
+			LveAsyncPipeline prepassShading;
+		};
+		std::unordered_map<uint64_t, VariantPipelines> variantPipelines;
+		ShadingVariant shadingVariant{};
+		LveAsyncPipeline depthPrepassPipeline;
+		bool depthPrepassEnabled = false;
+		// pipelines used by the current frame, the pre-pass one is null when it is off or not compiled yet
+		LvePipeline* shadingPipeline = nullptr;
+		LvePipeline* prepassPipeline = nullptr;
 		VkPipelineLayout pipelineLayout;
+
+		// persistent object transforms, objects keep their slot while they are visible
+		struct ObjectSlot {
+			uint32_t slot;
+			uint64_t lastVisibleFrame;
+		};
+		LveTransformBuffer transformBuffer;
+		std::unordered_map<LveGameObject::id_t, ObjectSlot> objectSlots;
+		uint64_t frameCounter = 0;
+
+		// per frame storage buffer of transform slot indices, read with gl_InstanceIndex
+		std::unique_ptr<LveDescriptorSetLayout> instanceSetLayout;
+		std::unique_ptr<LveDescriptorPool> instancePool;
+		std::vector<std::unique_ptr<LveBuffer>> instanceBuffers;
+		std::vector<VkDescriptorSet> instanceDescriptorSets;
+
+		LveOcclusionCuller occlusionCuller;
+		bool occlusionCullingEnabled = true;
+
+		LveRenderQueue renderQueue;
+		std::vector<DrawRun> drawRuns;
+		std::vector<uint32_t> taskBindCounts;
+
+		// reused every frame to avoid per frame allocations
+		std::vector<LveGameObject::id_t> bvhResults;
+		std::vector<LveGameObject*> cullCandidates;
+		std::vector<glm::mat4> candidateTransforms;
+		SphereList candidateSpheres;
+		std::vector<uint32_t> visibleIndices;
+		CullingStats cullingStats;
 	};
 }
\ No newline at end of file
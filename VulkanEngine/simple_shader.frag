@@ -7,7 +7,7 @@ layout(location = 2) in vec3 fragNormalWorld;
 layout(location = 0) out vec4 outColor;
 
 struct PointLight {
-	vec4 position; // ignore w
+	vec4 position; // w is the range of influence
 	vec4 color; // w is intensity
 };
 
@@ -16,41 +16,84 @@ layout(set = 0, binding = 0) uniform GlobalUbo {
 	mat4 view;
 	mat4 invView;
 	vec4 ambientLightColor; // w is intensity
-	PointLight pointLights[10];
-	int numLights;
+	uvec4 clusterCounts; // w is the number of lights
+	vec4 clusterDepth; // x is the first slice's near depth, y the slices per unit of log depth
 } ubo;
 
-layout(push_constant) uniform Push {
-	mat4 modelMatrix;
-	mat4 normalMatrix;
-} push;
+layout(std430, set = 0, binding = 1) readonly buffer LightBuffer {
+	PointLight lights[];
+} lightBuffer;
 
-void main() {
-	vec3 diffuseLight = ubo.ambientLightColor.xyz * ubo.ambientLightColor.w;
-	vec3 specularLight = vec3(0.0);
-	vec3 surfaceNormal = normalize(fragNormalWorld);
+// offset into lightIndices and light count of every cluster, x fastest, then y, then depth slice
+layout(std430, set = 0, binding = 2) readonly buffer ClusterBuffer {
+	uvec2 clusters[];
+} clusterBuffer;
 
-	vec3 cameraPosWorld = ubo.invView[3].xyz;
-	vec3 viewDirection = normalize(cameraPosWorld - fragPosWorld);
+layout(std430, set = 0, binding = 3) readonly buffer LightIndexBuffer {
+	uint lightIndices[];
+} lightIndexBuffer;
+
+// pipeline variants, see ShadingVariant in simple_render_system.hpp. Paths switched off by a constant are
+// removed when the pipeline is compiled.
+layout(constant_id = 0) const float SPECULAR_EXPONENT = 512.0; // higher values -> sharper highlights
+layout(constant_id = 1) const bool SPECULAR_ENABLED = true;
+// 0 shades every light of the cluster, otherwise at most this many with a loop bound known at compile time
+layout(constant_id = 2) const uint MAX_CLUSTER_LIGHTS = 0;
 
-	for(int i = 0; i < ubo.numLights; i++){
-		PointLight light = ubo.pointLights[i];
-		vec3 directionToLight = light.position.xyz - fragPosWorld;
-		float attenuation = 1.0 / dot(directionToLight, directionToLight); // distance squared
-		directionToLight = normalize(directionToLight);
+// must match the binning in LveLightClusters
+uint clusterIndex() {
+	vec4 positionView = ubo.view * vec4(fragPosWorld, 1.0);
+	vec4 positionClip = ubo.projection * positionView;
+	vec2 tileCoord = (positionClip.xy / positionClip.w * 0.5 + 0.5) * vec2(ubo.clusterCounts.xy);
+	uvec2 tile = uvec2(clamp(floor(tileCoord), vec2(0.0), vec2(ubo.clusterCounts.xy - 1u)));
+	float slice = log(max(positionView.z, ubo.clusterDepth.x) / ubo.clusterDepth.x) * ubo.clusterDepth.y;
+	uint depthSlice = min(uint(slice), ubo.clusterCounts.z - 1u);
+	return tile.x + ubo.clusterCounts.x * (tile.y + ubo.clusterCounts.y * depthSlice);
+}
 
-		float cosAngIncidence = max(dot(surfaceNormal, directionToLight), 0);
-		vec3 intensity = light.color.xyz * light.color.w * attenuation;
+void addLight(uint lightIndex, vec3 surfaceNormal, vec3 viewDirection, inout vec3 diffuseLight, inout vec3 specularLight) {
+	PointLight light = lightBuffer.lights[lightIndex];
+	vec3 directionToLight = light.position.xyz - fragPosWorld;
+	float distanceSquared = dot(directionToLight, directionToLight);
+	// fades to zero at the light's range so lights outside their clusters are never missed
+	float falloff = clamp(1.0 - pow(distanceSquared / (light.position.w * light.position.w), 2.0), 0.0, 1.0);
+	float attenuation = falloff * falloff / distanceSquared;
+	directionToLight = normalize(directionToLight);
 
-		diffuseLight += intensity * cosAngIncidence;
+	float cosAngIncidence = max(dot(surfaceNormal, directionToLight), 0);
+	vec3 intensity = light.color.xyz * light.color.w * attenuation;
 
-		// specular lighting
+	diffuseLight += intensity * cosAngIncidence;
+
+	// specular lighting
+	if (SPECULAR_ENABLED) {
 		vec3 halfAngle = normalize(directionToLight + viewDirection);
 		float blinnTerm = dot(surfaceNormal, halfAngle);
 		blinnTerm = clamp(blinnTerm, 0, 1);
-		blinnTerm = pow(blinnTerm, 512.0); // higher values -> sharper highlights
+		blinnTerm = pow(blinnTerm, SPECULAR_EXPONENT);
 		specularLight += intensity * blinnTerm;
 	}
+}
+
+void main() {
+	vec3 diffuseLight = ubo.ambientLightColor.xyz * ubo.ambientLightColor.w;
+	vec3 specularLight = vec3(0.0);
+	vec3 surfaceNormal = normalize(fragNormalWorld);
+
+	vec3 cameraPosWorld = ubo.invView[3].xyz;
+	vec3 viewDirection = normalize(cameraPosWorld - fragPosWorld);
+
+	uvec2 cluster = clusterBuffer.clusters[clusterIndex()];
+	if (MAX_CLUSTER_LIGHTS > 0) {
+		for (uint i = 0; i < MAX_CLUSTER_LIGHTS; i++) {
+			if (i >= cluster.y) break;
+			addLight(lightIndexBuffer.lightIndices[cluster.x + i], surfaceNormal, viewDirection, diffuseLight, specularLight);
+		}
+	} else {
+		for (uint i = 0; i < cluster.y; i++) {
+			addLight(lightIndexBuffer.lightIndices[cluster.x + i], surfaceNormal, viewDirection, diffuseLight, specularLight);
+		}
+	}
 
 	outColor = vec4(diffuseLight * fragColor + specularLight * fragColor, 1.0);
-}
\ No newline at end of file
+}
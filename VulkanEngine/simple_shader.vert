@@ -10,30 +10,42 @@ layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec3 fragPosWorld;
 layout(location = 2) out vec3 fragNormalWorld;
 
-struct PointLight {
-	vec4 position; // ignore w
-	vec4 color; // w is intensity
-};
+// must match depth_prepass.vert exactly for the EQUAL depth test after a pre-pass
+invariant gl_Position;
 
 layout(set = 0, binding = 0) uniform GlobalUbo {
 	mat4 projection;
 	mat4 view;
 	mat4 invView;
 	vec4 ambientLightColor; // w is intensity
-	PointLight pointLights[10];
-	int numLights;
+	uvec4 clusterCounts; // w is the number of lights
+	vec4 clusterDepth; // x is the first slice's near depth, y the slices per unit of log depth
 } ubo;
 
-layout(push_constant) uniform Push {
-	mat4 modelMatrix;
-	mat4 normalMatrix;
-} push;
+// gl_InstanceIndex includes the draw's firstInstance, so it indexes this frame's buffer directly
+layout(std430, set = 1, binding = 0) readonly buffer InstanceBuffer {
+	uint objectSlots[];
+} instanceBuffer;
+
+// rows of each object's affine model matrix, see AffineTransform
+layout(std430, set = 1, binding = 1) readonly buffer TransformBuffer {
+	mat3x4 transforms[];
+} transformBuffer;
+
+// The cofactor matrix equals inverse(transpose(m)) * determinant(m), the scale is removed by normalizing and the
+// sign of the determinant keeps normals of mirrored objects facing out.
+vec3 transformNormal(mat3x4 transform, vec3 normal) {
+	mat3 m = transpose(mat3(transform));
+	mat3 cofactor = mat3(cross(m[1], m[2]), cross(m[2], m[0]), cross(m[0], m[1]));
+	return normalize(cofactor * normal) * sign(dot(m[0], cofactor[0]));
+}
 
 void main() {
-	vec4 positionWorld = push.modelMatrix * vec4(position, 1.0);
+	mat3x4 transform = transformBuffer.transforms[instanceBuffer.objectSlots[gl_InstanceIndex]];
+	vec4 positionWorld = vec4(vec4(position, 1.0) * transform, 1.0);
 	gl_Position = ubo.projection * (ubo.view * positionWorld);
 
-	fragNormalWorld = normalize(mat3(push.normalMatrix) * normal);
+	fragNormalWorld = transformNormal(transform, normal);
 	fragPosWorld = positionWorld.xyz;
 	fragColor = color;
 }
\ No newline at end of file